@@ -0,0 +1,872 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DSPatch.h>
+#include <DspAudioDevice.h>
+#include <DspFileAudioBackend.h>
+#include <DspGain.h>
+#include <DspWaveStreamer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+//=================================================================================================
+// Measures the engine's hot paths and prints the results as JSON (one object per case, holding
+// the case's parameters and metrics), such that runs can be compared over time:
+//
+//   - "chain", "fan", "nesting": ticks per second through a linear chain of components, from one
+//     source out to many components and back into one adder, and through nested circuits.
+//   - "scaling": ticks per second of parallel chains of busy components, per thread count, both
+//     ticked and streamed (see DspCircuit::Stream()).
+//   - "run_type", "signal_bus": nanoseconds per DspRunType and DspSignalBus operation.
+//   - "edit": latency of graph edits made while the circuit auto-ticks.
+//   - "audio_chain": buffers per second through the example's audio chain (wave streamer, gains,
+//     audio device), with a file backend without files in place of the sound card: the device
+//     runs as fast as the chain processes its buffers, rather than in real time.
+//
+// The first argument sets the time spent measuring each case in milliseconds (default 200).
+
+typedef std::chrono::steady_clock Clock;
+
+static double benchTime = 0.2;  // seconds per case
+static volatile float sink = 0;
+
+static double Seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+//=================================================================================================
+
+class Source : public DspComponent
+{
+public:
+    Source()
+        : _value(0)
+    {
+        AddOutput_();
+    }
+
+protected:
+    virtual void Process_(DspSignalBus&, DspSignalBus& outputs)
+    {
+        outputs.SetValue(0, ++_value);
+    }
+
+private:
+    float _value;
+};
+
+//-------------------------------------------------------------------------------------------------
+
+class Pass : public DspComponent
+{
+public:
+    Pass()
+    {
+        AddInput_();
+        AddOutput_();
+    }
+
+protected:
+    virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs)
+    {
+        float const* value = inputs.GetValue<float>(0);
+        if (value != NULL)
+        {
+            outputs.SetValue(0, *value);
+        }
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+
+class Adder : public DspComponent
+{
+public:
+    Adder(int inputCount)
+    {
+        for (int i = 0; i < inputCount; i++)
+        {
+            AddInput_();
+        }
+        AddOutput_();
+    }
+
+protected:
+    virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs)
+    {
+        float sum = 0;
+        for (int i = 0; i < inputs.GetSignalCount(); i++)
+        {
+            float const* value = inputs.GetValue<float>(i);
+            if (value != NULL)
+            {
+                sum += *value;
+            }
+        }
+        outputs.SetValue(0, sum);
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// filters a buffer a number of times per tick, standing in for real DSP work
+class Busy : public DspComponent
+{
+public:
+    Busy(int passes)
+        : _passes(passes)
+        , _buffer(256, 0.5f)
+    {
+        AddInput_();
+        AddOutput_();
+    }
+
+protected:
+    virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs)
+    {
+        float const* value = inputs.GetValue<float>(0);
+        float state = value != NULL ? *value : 0;
+
+        for (int i = 0; i < _passes; i++)
+        {
+            for (size_t j = 0; j < _buffer.size(); j++)
+            {
+                state = state * 0.99f + _buffer[j] * 0.01f;
+                _buffer[j] = state;
+            }
+        }
+
+        outputs.SetValue(0, state);
+    }
+
+private:
+    int _passes;
+    std::vector<float> _buffer;
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// runs an operation on its buses, as many times as asked, on every tick
+class BusBench : public DspComponent
+{
+public:
+    typedef void (*Operation_t)(DspSignalBus& inputs, DspSignalBus& outputs, long count);
+
+    BusBench()
+        : operation(NULL)
+        , count(0)
+    {
+        AddInput_("in");
+        AddOutput_("out");
+    }
+
+    Operation_t operation;
+    long count;
+
+protected:
+    virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs)
+    {
+        operation(inputs, outputs, count);
+    }
+};
+
+//=================================================================================================
+
+// collects results, printed as a JSON array of cases once all have run
+class Results
+{
+public:
+    void AddCase(std::string const& group, std::string const& name)
+    {
+        _cases.push_back("{\"group\":\"" + group + "\",\"name\":\"" + name + "\"");
+    }
+
+    void AddValue(std::string const& key, double value)
+    {
+        char text[64];
+        snprintf(text, sizeof(text), ",\"%s\":%.6g", key.c_str(), value);
+        _cases.back() += text;
+    }
+
+    void Print()
+    {
+        printf("{\n  \"benchmark\": \"dspatch_bench\",\n  \"cpu_count\": %d,\n  \"case_time_ms\": %.0f,\n  \"results\": [",
+               DspThread::GetCpuCount(), benchTime * 1000);
+
+        for (size_t i = 0; i < _cases.size(); i++)
+        {
+            printf("%s\n    %s}", i == 0 ? "" : ",", _cases[i].c_str());
+        }
+
+        printf("\n  ]\n}\n");
+    }
+
+private:
+    std::vector<std::string> _cases;
+};
+
+static Results results;
+
+//=================================================================================================
+
+// ticks (or streams) the circuit in growing batches for the case time, returning ticks per second
+static double TicksPerSecond(DspCircuit& circuit, bool stream = false)
+{
+    circuit.TickN(16);
+
+    unsigned long batch = 1;
+    unsigned long ticks = 0;
+    double elapsed = 0;
+
+    Clock::time_point start = Clock::now();
+
+    while ((elapsed = Seconds(start)) < benchTime)
+    {
+        ticks += stream ? circuit.Stream(batch) : circuit.TickN(batch);
+        batch = std::min(batch * 2, 4096UL);
+    }
+
+    return ticks / elapsed;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+static void AddTickRate(DspCircuit& circuit, int componentCount)
+{
+    double ticksPerSecond = TicksPerSecond(circuit);
+
+    results.AddValue("components", componentCount);
+    results.AddValue("ticks_per_sec", ticksPerSecond);
+    results.AddValue("ns_per_component", 1e9 / ticksPerSecond / componentCount);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+static void BenchChain(int length)
+{
+    DspCircuit circuit;
+    Source source;
+    std::vector<Pass> passes(length);
+
+    circuit.AddComponent(source);
+    for (int i = 0; i < length; i++)
+    {
+        circuit.AddComponent(passes[i]);
+        if (i == 0)
+        {
+            circuit.ConnectOutToIn(source, 0, passes[i], 0);
+        }
+        else
+        {
+            circuit.ConnectOutToIn(passes[i - 1], 0, passes[i], 0);
+        }
+    }
+
+    results.AddCase("chain", "chain/" + std::to_string(length));
+    AddTickRate(circuit, length + 1);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+static void BenchFan(int width)
+{
+    DspCircuit circuit;
+    Source source;
+    std::vector<Pass> passes(width);
+    Adder adder(width);
+
+    circuit.AddComponent(source);
+    circuit.AddComponent(adder);
+    for (int i = 0; i < width; i++)
+    {
+        circuit.AddComponent(passes[i]);
+        circuit.ConnectOutToIn(source, 0, passes[i], 0);
+        circuit.ConnectOutToIn(passes[i], 0, adder, i);
+    }
+
+    results.AddCase("fan", "fan/" + std::to_string(width));
+    AddTickRate(circuit, width + 2);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+// each circuit holds a pass and the next circuit, wired through the circuit's own input and output
+static void BenchNesting(int depth)
+{
+    std::vector<DspCircuit> circuits(depth);
+    std::vector<Pass> passes(depth);
+    Source source;
+
+    for (int i = depth - 1; i >= 0; i--)
+    {
+        circuits[i].AddInput();
+        circuits[i].AddOutput();
+        circuits[i].AddComponent(passes[i]);
+        circuits[i].ConnectInToIn(0, passes[i], 0);
+
+        if (i == depth - 1)
+        {
+            circuits[i].ConnectOutToOut(passes[i], 0, 0);
+        }
+        else
+        {
+            circuits[i].AddComponent(circuits[i + 1]);
+            circuits[i].ConnectOutToIn(passes[i], 0, circuits[i + 1], 0);
+            circuits[i].ConnectOutToOut(circuits[i + 1], 0, 0);
+        }
+    }
+
+    DspCircuit circuit;
+    circuit.AddComponent(source);
+    circuit.AddComponent(circuits[0]);
+    circuit.ConnectOutToIn(source, 0, circuits[0], 0);
+
+    results.AddCase("nesting", "nesting/" + std::to_string(depth));
+    AddTickRate(circuit, 2 * depth + 1);
+
+    // release the nested circuits innermost first
+    circuit.RemoveAllComponents();
+    for (int i = 0; i < depth; i++)
+    {
+        circuits[i].RemoveAllComponents();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+static void BenchScaling(int maxThreadCount)
+{
+    static int const chainCount = 8;
+    static int const chainLength = 4;
+
+    DspEngine engine(maxThreadCount);
+    DspCircuit circuit(0, &engine);
+    Source source;
+    std::vector< std::unique_ptr<Busy> > busy;
+    Adder adder(chainCount);
+
+    circuit.AddComponent(source);
+    circuit.AddComponent(adder);
+    for (int i = 0; i < chainCount; i++)
+    {
+        for (int j = 0; j < chainLength; j++)
+        {
+            busy.push_back(std::unique_ptr<Busy>(new Busy(8)));
+            circuit.AddComponent(*busy.back());
+
+            if (j == 0)
+            {
+                circuit.ConnectOutToIn(source, 0, *busy.back(), 0);
+            }
+            else
+            {
+                circuit.ConnectOutToIn(*busy[busy.size() - 2], 0, *busy.back(), 0);
+            }
+        }
+        circuit.ConnectOutToIn(*busy.back(), 0, adder, i);
+    }
+
+    double baseline = 0;
+
+    for (int threadCount = 0; threadCount <= maxThreadCount; threadCount = threadCount == 0 ? 1 : threadCount * 2)
+    {
+        circuit.SetThreadCount(threadCount);
+
+        double ticksPerSecond = TicksPerSecond(circuit);
+        double streamedPerSecond = TicksPerSecond(circuit, true);
+
+        if (threadCount == 0)
+        {
+            baseline = ticksPerSecond;
+        }
+
+        results.AddCase("scaling", "scaling/" + std::to_string(threadCount));
+        results.AddValue("threads", threadCount);
+        results.AddValue("ticks_per_sec", ticksPerSecond);
+        results.AddValue("speedup", ticksPerSecond / baseline);
+        results.AddValue("stream_ticks_per_sec", streamedPerSecond);
+        results.AddValue("stream_speedup", streamedPerSecond / baseline);
+    }
+}
+
+//=================================================================================================
+
+// repeats an operation in growing batches for the case time, returning nanoseconds per operation
+template <class Operation>
+static double NsPerOperation(Operation operation)
+{
+    long count = 1;
+    long operations = 0;
+    double elapsed = 0;
+
+    Clock::time_point start = Clock::now();
+
+    while ((elapsed = Seconds(start)) < benchTime)
+    {
+        operation(count);
+        operations += count;
+        count = std::min(count * 2, 1L << 16);
+    }
+
+    return elapsed * 1e9 / operations;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+struct RunTypeConstructFloat
+{
+    void operator()(long count)
+    {
+        for (long i = 0; i < count; i++)
+        {
+            DspRunType value(1.0f);
+            sink = *DspRunType::RunTypeCast<float>(&value);
+        }
+    }
+};
+
+struct RunTypeConstructVector
+{
+    std::vector<float> buffer;
+
+    void operator()(long count)
+    {
+        for (long i = 0; i < count; i++)
+        {
+            DspRunType value(buffer);
+            sink = (*DspRunType::RunTypeCast< std::vector<float> >(&value))[0];
+        }
+    }
+};
+
+struct RunTypeCopyVector
+{
+    DspRunType value;
+
+    void operator()(long count)
+    {
+        for (long i = 0; i < count; i++)
+        {
+            DspRunType copy(value);
+            sink = (*DspRunType::RunTypeCast< std::vector<float> >(&copy))[0];
+        }
+    }
+};
+
+struct RunTypeAssignVector
+{
+    std::vector<float> buffer;
+    DspRunType value;
+
+    void operator()(long count)
+    {
+        for (long i = 0; i < count; i++)
+        {
+            value = buffer;
+        }
+        sink = (*DspRunType::RunTypeCast< std::vector<float> >(&value))[0];
+    }
+};
+
+struct RunTypeMove
+{
+    DspRunType from;
+    DspRunType to;
+
+    void operator()(long count)
+    {
+        DspRunType* source = &from;
+        DspRunType* target = &to;
+
+        for (long i = 0; i < count; i++)
+        {
+            source->MoveTo(*target);
+            std::swap(source, target);
+            sink = source->IsEmpty();
+        }
+    }
+};
+
+struct RunTypeCast
+{
+    DspRunType value;
+
+    void operator()(long count)
+    {
+        for (long i = 0; i < count; i++)
+        {
+            sink = *DspRunType::RunTypeCast<float>(&value);
+        }
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+
+static void BenchRunType()
+{
+    std::vector<float> buffer(256, 1.0f);
+
+    RunTypeConstructVector constructVector;
+    constructVector.buffer = buffer;
+
+    RunTypeCopyVector copyVector;
+    copyVector.value = buffer;
+
+    RunTypeAssignVector assignVector;
+    assignVector.buffer = buffer;
+    assignVector.value = buffer;
+
+    RunTypeMove move;
+    move.from = buffer;
+
+    RunTypeCast cast;
+    cast.value = 1.0f;
+
+    results.AddCase("run_type", "run_type/construct_float");
+    results.AddValue("ns_per_op", NsPerOperation(RunTypeConstructFloat()));
+    results.AddCase("run_type", "run_type/construct_vector256");
+    results.AddValue("ns_per_op", NsPerOperation(constructVector));
+    results.AddCase("run_type", "run_type/copy_vector256");
+    results.AddValue("ns_per_op", NsPerOperation(copyVector));
+    results.AddCase("run_type", "run_type/assign_vector256");
+    results.AddValue("ns_per_op", NsPerOperation(assignVector));
+    results.AddCase("run_type", "run_type/move");
+    results.AddValue("ns_per_op", NsPerOperation(move));
+    results.AddCase("run_type", "run_type/cast");
+    results.AddValue("ns_per_op", NsPerOperation(cast));
+}
+
+//=================================================================================================
+
+static std::vector<float> busBuffer(256, 1.0f);
+
+static void BusSetFloat(DspSignalBus&, DspSignalBus& outputs, long count)
+{
+    for (long i = 0; i < count; i++)
+    {
+        outputs.SetValue(0, (float)i);
+    }
+}
+
+static void BusGetFloat(DspSignalBus&, DspSignalBus& outputs, long count)
+{
+    outputs.SetValue(0, 1.0f);
+    for (long i = 0; i < count; i++)
+    {
+        sink = *outputs.GetValue<float>(0);
+    }
+}
+
+static void BusSetVector(DspSignalBus&, DspSignalBus& outputs, long count)
+{
+    for (long i = 0; i < count; i++)
+    {
+        outputs.SetValue(0, busBuffer);
+    }
+}
+
+static void BusGetVectorCopy(DspSignalBus&, DspSignalBus& outputs, long count)
+{
+    std::vector<float> buffer;
+
+    outputs.SetValue(0, busBuffer);
+    for (long i = 0; i < count; i++)
+    {
+        outputs.GetValue(0, buffer);
+    }
+    sink = buffer[0];
+}
+
+static void BusSetSignal(DspSignalBus& inputs, DspSignalBus& outputs, long count)
+{
+    outputs.SetValue(0, busBuffer);
+    for (long i = 0; i < count; i++)
+    {
+        inputs.SetSignal(0, outputs.GetSignal(0));
+    }
+}
+
+static void BusClearAll(DspSignalBus&, DspSignalBus& outputs, long count)
+{
+    for (long i = 0; i < count; i++)
+    {
+        outputs.ClearAllValues();
+    }
+}
+
+static void BusGetByName(DspSignalBus&, DspSignalBus& outputs, long count)
+{
+    outputs.SetValue(0, 1.0f);
+    for (long i = 0; i < count; i++)
+    {
+        sink = *outputs.GetValue<float>("out");
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+// runs a bus operation within a tick (the buses are the engine's own), hence outside any circuit
+struct BusOperation
+{
+    BusBench* bench;
+    BusBench::Operation_t operation;
+
+    void operator()(long count)
+    {
+        bench->operation = operation;
+        bench->count = count;
+        bench->Tick();
+        bench->Reset();
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+
+static void BenchSignalBus()
+{
+    static char const* const names[] = { "set_float", "get_float", "set_vector256", "get_vector256_copy",
+                                         "set_signal_vector256", "clear_all", "get_float_by_name" };
+    static BusBench::Operation_t const operations[] = { BusSetFloat, BusGetFloat, BusSetVector,
+                                                        BusGetVectorCopy, BusSetSignal, BusClearAll, BusGetByName };
+
+    BusBench bench;
+
+    for (int i = 0; i < 7; i++)
+    {
+        BusOperation operation = { &bench, operations[i] };
+
+        results.AddCase("signal_bus", std::string("signal_bus/") + names[i]);
+        results.AddValue("ns_per_op", NsPerOperation(operation));
+    }
+}
+
+//=================================================================================================
+
+struct Latency
+{
+    std::vector<double> times;
+
+    void AddTo(Results& results)
+    {
+        std::sort(times.begin(), times.end());
+
+        double mean = 0;
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            mean += times[i];
+        }
+
+        results.AddValue("edits", times.size());
+        results.AddValue("mean_us", mean / times.size());
+        results.AddValue("p99_us", times[times.size() * 99 / 100]);
+        results.AddValue("max_us", times.back());
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+
+static void BenchEdits(int threadCount)
+{
+    static int const chainLength = 16;
+
+    DspEngine engine(threadCount);
+    DspCircuit circuit(threadCount, &engine);
+    Source source;
+    std::vector< std::unique_ptr<Busy> > busy;
+    Pass extra;
+
+    circuit.AddComponent(source);
+    for (int i = 0; i < chainLength; i++)
+    {
+        busy.push_back(std::unique_ptr<Busy>(new Busy(1)));
+        circuit.AddComponent(*busy[i]);
+
+        if (i == 0)
+        {
+            circuit.ConnectOutToIn(source, 0, *busy[i], 0);
+        }
+        else
+        {
+            circuit.ConnectOutToIn(*busy[i - 1], 0, *busy[i], 0);
+        }
+    }
+
+    circuit.StartAutoTick(engine);
+
+    Latency connect, disconnect, add, remove;
+    Clock::time_point start = Clock::now();
+
+    while (Seconds(start) < benchTime || connect.times.size() < 100)
+    {
+        Clock::time_point editStart = Clock::now();
+        circuit.DisconnectOutToIn(*busy[chainLength / 2 - 1], 0, *busy[chainLength / 2], 0);
+        disconnect.times.push_back(std::chrono::duration<double, std::micro>(Clock::now() - editStart).count());
+
+        editStart = Clock::now();
+        circuit.ConnectOutToIn(*busy[chainLength / 2 - 1], 0, *busy[chainLength / 2], 0);
+        connect.times.push_back(std::chrono::duration<double, std::micro>(Clock::now() - editStart).count());
+
+        editStart = Clock::now();
+        circuit.AddComponent(extra);
+        add.times.push_back(std::chrono::duration<double, std::micro>(Clock::now() - editStart).count());
+
+        editStart = Clock::now();
+        circuit.RemoveComponent(extra);
+        remove.times.push_back(std::chrono::duration<double, std::micro>(Clock::now() - editStart).count());
+
+        // let the circuit tick in between edits
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    circuit.StopAutoTick();
+
+    std::string threads = "/" + std::to_string(threadCount);
+
+    results.AddCase("edit", "edit/disconnect" + threads);
+    results.AddValue("threads", threadCount);
+    disconnect.AddTo(results);
+    results.AddCase("edit", "edit/connect" + threads);
+    results.AddValue("threads", threadCount);
+    connect.AddTo(results);
+    results.AddCase("edit", "edit/add_component" + threads);
+    results.AddValue("threads", threadCount);
+    add.AddTo(results);
+    results.AddCase("edit", "edit/remove_component" + threads);
+    results.AddValue("threads", threadCount);
+    remove.AddTo(results);
+}
+
+//=================================================================================================
+
+static void BenchAudioChain(int threadCount)
+{
+    DspEngine engine(threadCount);
+    DspCircuit circuit(threadCount, &engine);
+
+    // no input file and no output file: silence in, output discarded, faster than real time
+    DspFileAudioBackend* backend = new DspFileAudioBackend("", "");
+
+    DspWaveStreamer waveStreamer;
+    DspAudioDevice audioDevice(backend);
+    DspGain gainLeft;
+    DspGain gainRight;
+
+    circuit.AddComponent(waveStreamer);
+    circuit.AddComponent(audioDevice);
+    circuit.AddComponent(gainLeft);
+    circuit.AddComponent(gainRight);
+
+    waveStreamer.SetChannelOutputs(true);
+
+    circuit.ConnectOutToIn(waveStreamer, "Sample Rate", audioDevice, "Sample Rate");
+    circuit.ConnectOutToIn(waveStreamer, 0, gainLeft, 0);
+    circuit.ConnectOutToIn(waveStreamer, 1, gainRight, 0);
+    circuit.ConnectOutToIn(gainLeft, 0, audioDevice, 0);
+    circuit.ConnectOutToIn(gainRight, 0, audioDevice, 1);
+
+    gainLeft.SetGain(0.75f);
+    gainRight.SetGain(0.75f);
+
+    waveStreamer.LoadFile(EXAMPLE_WAV_FILE);
+    waveStreamer.Play();
+
+    circuit.StartAutoTick(engine);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    unsigned long firstBuffer = backend->GetBufferCount();
+    Clock::time_point start = Clock::now();
+
+    std::this_thread::sleep_for(std::chrono::microseconds((long)(benchTime * 1e6)));
+
+    unsigned long bufferCount = backend->GetBufferCount() - firstBuffer;
+    double elapsed = Seconds(start);
+
+    circuit.StopAutoTick();
+
+    double buffersPerSecond = bufferCount / elapsed;
+
+    results.AddCase("audio_chain", "audio_chain/" + std::to_string(threadCount));
+    results.AddValue("threads", threadCount);
+    results.AddValue("buffer_size", audioDevice.GetBufferSize());
+    results.AddValue("sample_rate", audioDevice.GetSampleRate());
+    results.AddValue("buffers_per_sec", buffersPerSecond);
+    results.AddValue("realtime_factor", buffersPerSecond * audioDevice.GetBufferSize() / audioDevice.GetSampleRate());
+    results.AddValue("underruns", audioDevice.GetUnderrunCount());
+}
+
+//=================================================================================================
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+    {
+        char* end = NULL;
+        long milliseconds = strtol(argv[1], &end, 10);
+
+        if (argc > 2 || end == argv[1] || *end != '\0' || milliseconds < 1)
+        {
+            fprintf(stderr, "usage: %s [milliseconds per case (default 200)]\n", argv[0]);
+            return 1;
+        }
+
+        benchTime = milliseconds / 1000.0;
+    }
+
+    int maxThreadCount = std::max(DspThread::GetCpuCount(), 2);
+
+    BenchChain(1);
+    BenchChain(16);
+    BenchChain(256);
+
+    BenchFan(16);
+    BenchFan(256);
+
+    BenchNesting(1);
+    BenchNesting(8);
+    BenchNesting(32);
+
+    BenchScaling(maxThreadCount);
+
+    BenchRunType();
+    BenchSignalBus();
+
+    BenchEdits(0);
+    BenchEdits(2);
+
+    BenchAudioChain(0);
+    BenchAudioChain(2);
+
+    results.Print();
+
+    DSPatch::Finalize();
+    return 0;
+}
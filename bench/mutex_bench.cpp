@@ -0,0 +1,266 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DSPatch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+//=================================================================================================
+// Measures how long a high priority thread waits to lock a DspMutex held by a low priority thread,
+// while a medium priority thread hogs the CPU (the classic priority inversion setup: all three
+// threads share a single CPU). Run once per DspMutex option set. Without PriorityInherit, the
+// medium priority thread's bursts are added to the high priority thread's wait.
+//
+// Real-time scheduling usually requires privileges (E.g. root or CAP_SYS_NICE). Without them the
+// threads fall back to nice values, which does not reproduce the inversion.
+
+typedef std::chrono::steady_clock Clock;
+
+static std::atomic<bool> stop(false);
+static int benchCpu = 0;
+
+static void SleepUs(int us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+static void SpinUs(int us)
+{
+    Clock::time_point end = Clock::now() + std::chrono::microseconds(us);
+    while (Clock::now() < end)
+    {
+    }
+}
+
+//=================================================================================================
+
+class BenchThread : public DspThread
+{
+public:
+    BenchThread(DspMutex& mutex, int priority, int nice)
+        : done(false)
+        , _mutex(mutex)
+        , _profile(DspSchedulingProfile::FifoPolicy, priority, nice)
+    {
+    }
+
+    std::atomic<bool> done;
+    DspSchedulingProfile effective;
+
+protected:
+    DspMutex& _mutex;
+
+private:
+    virtual void _Run()
+    {
+        std::vector<int> cpus(1, benchCpu);
+        SetAffinity(cpus);
+        SetScheduling(_profile, effective);
+
+        _Work();
+        done = true;
+    }
+
+    virtual void _Work() = 0;
+
+    DspSchedulingProfile _profile;
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// holds the lock most of the time
+class LowThread : public BenchThread
+{
+public:
+    LowThread(DspMutex& mutex)
+        : BenchThread(mutex, 10, 10)
+    {
+    }
+
+private:
+    virtual void _Work()
+    {
+        while (!stop)
+        {
+            _mutex.Lock();
+            SpinUs(300);
+            _mutex.Unlock();
+            SleepUs(50);
+        }
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// hogs the CPU in bursts, without ever touching the lock
+class MediumThread : public BenchThread
+{
+public:
+    MediumThread(DspMutex& mutex)
+        : BenchThread(mutex, 20, 5)
+    {
+    }
+
+private:
+    virtual void _Work()
+    {
+        while (!stop)
+        {
+            SpinUs(2000);
+            SleepUs(1000);
+        }
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// periodically takes the lock, measuring how long it waited for it
+class HighThread : public BenchThread
+{
+public:
+    HighThread(DspMutex& mutex, int iterations)
+        : BenchThread(mutex, 30, 0)
+        , _iterations(iterations)
+    {
+    }
+
+    std::vector<double> waits;
+
+private:
+    virtual void _Work()
+    {
+        for (int i = 0; i < _iterations; i++)
+        {
+            SleepUs(1000);
+
+            Clock::time_point start = Clock::now();
+            _mutex.Lock();
+            Clock::time_point end = Clock::now();
+            _mutex.Unlock();
+
+            waits.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        stop = true;
+    }
+
+    int _iterations;
+};
+
+//=================================================================================================
+
+struct Result
+{
+    double mean, p99, max;
+};
+
+static Result RunBench(int options, int iterations, DspSchedulingProfile& effective)
+{
+    DspMutex mutex(options);
+
+    stop = false;
+
+    LowThread low(mutex);
+    MediumThread medium(mutex);
+    HighThread high(mutex, iterations);
+
+    low.Start();
+    medium.Start();
+    SleepUs(10000);
+    high.Start();
+
+    while (!high.done || !medium.done || !low.done)
+    {
+        SleepUs(10000);
+    }
+
+    effective = high.effective;
+
+    std::vector<double>& waits = high.waits;
+    std::sort(waits.begin(), waits.end());
+
+    Result result;
+    result.mean = 0;
+    for (size_t i = 0; i < waits.size(); i++)
+    {
+        result.mean += waits[i];
+    }
+    result.mean /= waits.size();
+    result.p99 = waits[waits.size() * 99 / 100];
+    result.max = waits.back();
+
+    return result;
+}
+
+//=================================================================================================
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+    if (iterations < 1)
+    {
+        iterations = 1;
+    }
+
+    std::vector<int> cpus;
+    if (DspThread::GetAffinity(cpus) && !cpus.empty())
+    {
+        benchCpu = cpus[0];
+    }
+
+    static char const* names[] = { "default", "PriorityInherit", "AdaptiveSpin", "PriorityInherit|AdaptiveSpin" };
+    static int const options[] = { 0,
+                                   DspMutex::PriorityInherit,
+                                   DspMutex::AdaptiveSpin,
+                                   DspMutex::PriorityInherit | DspMutex::AdaptiveSpin };
+
+    printf("high priority lock wait on CPU %d, %d iterations (microseconds)\n\n", benchCpu, iterations);
+    printf("%-30s %10s %10s %10s\n", "mutex", "mean", "p99", "max");
+
+    Result results[4];
+    DspSchedulingProfile effective;
+
+    for (int i = 0; i < 4; i++)
+    {
+        results[i] = RunBench(options[i], iterations, effective);
+        printf("%-30s %10.1f %10.1f %10.1f\n", names[i], results[i].mean, results[i].p99, results[i].max);
+    }
+
+    printf("\ninversion removed by PriorityInherit: p99 %.0f%%, max %.0f%%\n",
+           100.0 * (1.0 - results[1].p99 / results[0].p99),
+           100.0 * (1.0 - results[1].max / results[0].max));
+
+    if (effective.policy != DspSchedulingProfile::FifoPolicy)
+    {
+        printf("\nN.B. real-time scheduling was refused (insufficient privileges), the threads ran "
+               "time-shared, hence priority inversion could not be reproduced.\n");
+    }
+
+    return 0;
+}
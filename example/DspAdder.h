@@ -96,6 +96,16 @@ protected:
         }
     }
 
+    //! Virtual clone method inherited from DspComponent
+    /*! The Clone_() method is called from the DSPatch engine when a circuit containing this
+    component is cloned (see DspCircuit::Clone()). It should return a new instance of the component,
+    constructed as this one was. Component parameters are copied onto the new instance by the engine. */
+
+    virtual DspComponent* Clone_()
+    {
+        return new DspAdder();
+    }
+
 private:
     std::vector<float> _stream1;
     std::vector<float> _stream2;
@@ -0,0 +1,82 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPAUDIOBACKEND_H
+#define DSPAUDIOBACKEND_H
+
+#include <DSPatch.h>
+
+#include <string>
+
+//=================================================================================================
+// Interface between DspAudioDevice and the audio API (or stand-in) that streams its buffers.
+//
+// A backend lists its devices, opens a stream on one of them, then calls the given callback once
+// per buffer with the device's input and output channels, each a block of "bufferSize" floats,
+// one channel after the other (non-interleaved). A callback returning non-zero stops the stream,
+// while a non-zero "status" reports an xrun. A backend that is not real-time (IsRealTime() returns
+// false) lets the callback wait for the circuit, rather than streaming on a clock of its own.
+
+class DspAudioBackend
+{
+public:
+    struct DeviceInfo
+    {
+        DeviceInfo(std::string const& newName = "", int newInputChannels = 0, int newOutputChannels = 0)
+            : name(newName)
+            , inputChannels(newInputChannels)
+            , outputChannels(newOutputChannels)
+        {
+        }
+
+        std::string name;
+        int inputChannels;
+        int outputChannels;
+    };
+
+    typedef int (*Callback_t)(void* outputBuffer, void* inputBuffer, unsigned int status, void* userData);
+
+    virtual ~DspAudioBackend()
+    {
+    }
+
+    virtual int GetDeviceCount() const = 0;
+    virtual DeviceInfo GetDeviceInfo(int deviceIndex) const = 0;
+    virtual int GetDefaultDevice() const = 0;
+    virtual bool IsRealTime() const = 0;
+
+    // may adjust "bufferSize" to what the device supports
+    virtual bool OpenStream(int deviceIndex,
+                            int sampleRate,
+                            int& bufferSize,
+                            Callback_t callback,
+                            void* userData) = 0;
+    virtual bool StartStream() = 0;
+    virtual void CloseStream() = 0;
+    virtual bool IsStreamOpen() const = 0;
+};
+
+//=================================================================================================
+
+#endif  // DSPAUDIOBACKEND_H
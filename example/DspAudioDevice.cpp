@@ -24,58 +24,56 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 
 #include <DspAudioDevice.h>
 
-#include <RtAudio.h>
-
+#include <algorithm>
 #include <iostream>
 #include <string.h>
 #include <cstdlib>
 
 //=================================================================================================
 
-struct RtAudioMembers
-{
-    std::vector<RtAudio::DeviceInfo> deviceList;
-
-    RtAudio audioStream;
-    RtAudio::StreamParameters outputParams;
-    RtAudio::StreamParameters inputParams;
-};
-
-//=================================================================================================
-
-DspAudioDevice::DspAudioDevice()
-    : _rtAudio(new RtAudioMembers())
-    , _gotWaitReady(false)
-    , _gotSyncReady(true)
+DspAudioDevice::DspAudioDevice(DspAudioBackend* backend)
+    : _backend(backend)
+    , _tickSource(this)
+    , _xrunCount(0)
+    , _underrunCount(0)
+    , _isStreaming(false)
+    , _callbackTicking(false)
+    , _inputSampleRate(0)
+    , _resampling(false)
 {
-    _outputChannels.resize(20);
+    _outputChannels.Resize(20, 0);
     for (int i = 0; i < 20; i++)
     {
         AddInput_();
     }
 
     AddInput_("Sample Rate");
+    AddInput_("Channels");  // all channels as a single DspPlanarBuffer<float>
 
-    _inputChannels.resize(20);
+    _inputChannels.Resize(20, 0);
     for (int i = 0; i < 20; i++)
     {
         AddOutput_();
     }
 
+    AddOutput_("Channels");  // all channels as a single DspPlanarBuffer<float>
+
     std::vector<std::string> deviceNameList;
 
-    for (unsigned int i = 0; i < _rtAudio->audioStream.getDeviceCount(); i++)
+    for (int i = 0; i < _backend->GetDeviceCount(); i++)
     {
-        _rtAudio->deviceList.push_back(_rtAudio->audioStream.getDeviceInfo(i));
-        deviceNameList.push_back(_rtAudio->audioStream.getDeviceInfo(i).name);
+        deviceNameList.push_back(_backend->GetDeviceInfo(i).name);
     }
 
     pDeviceList = AddParameter_("deviceList", DspParameter(DspParameter::List, deviceNameList));
     pIsStreaming = AddParameter_("isStreaming", DspParameter(DspParameter::Bool, false));
     pBufferSize = AddParameter_("bufferSize", DspParameter(DspParameter::Int, 256));
     pSampleRate = AddParameter_("sampleRate", DspParameter(DspParameter::Int, 44100));
+    pBufferDepth = AddParameter_("bufferDepth", DspParameter(DspParameter::Int, 2));
+    pResample = AddParameter_("resample", DspParameter(DspParameter::Bool, false));
+    pChannelOutputs = AddParameter_("channelOutputs", DspParameter(DspParameter::Bool, false));
 
-    SetDevice(_rtAudio->audioStream.getDefaultOutputDevice());
+    SetDevice(_backend->GetDefaultDevice());
     SetBufferSize(GetBufferSize());
     SetSampleRate(GetSampleRate());
 }
@@ -84,9 +82,17 @@ DspAudioDevice::DspAudioDevice()
 
 DspAudioDevice::~DspAudioDevice()
 {
+    _tickSource.Stop();
     _StopStream();
 
-    delete _rtAudio;
+    delete _backend;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspAudioBackend* DspAudioDevice::GetBackend() const
+{
+    return _backend;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -99,11 +105,7 @@ bool DspAudioDevice::SetDevice(int deviceIndex)
 
         SetParameter_(pDeviceList, DspParameter(DspParameter::Int, deviceIndex));
 
-        _rtAudio->inputParams.nChannels = _rtAudio->deviceList[deviceIndex].inputChannels;
-        _rtAudio->inputParams.deviceId = deviceIndex;
-
-        _rtAudio->outputParams.nChannels = _rtAudio->deviceList[deviceIndex].outputChannels;
-        _rtAudio->outputParams.deviceId = deviceIndex;
+        _deviceInfo = _backend->GetDeviceInfo(deviceIndex);
 
         _StartStream();
 
@@ -119,7 +121,7 @@ std::string DspAudioDevice::GetDeviceName(int deviceIndex) const
 {
     if (deviceIndex >= 0 && deviceIndex < GetDeviceCount())
     {
-        return _rtAudio->deviceList[deviceIndex].name;
+        return _backend->GetDeviceInfo(deviceIndex).name;
     }
 
     return "";
@@ -129,14 +131,14 @@ std::string DspAudioDevice::GetDeviceName(int deviceIndex) const
 
 int DspAudioDevice::GetDeviceInputCount(int deviceIndex) const
 {
-    return _rtAudio->deviceList[deviceIndex].inputChannels;
+    return _backend->GetDeviceInfo(deviceIndex).inputChannels;
 }
 
 //-------------------------------------------------------------------------------------------------
 
 int DspAudioDevice::GetDeviceOutputCount(int deviceIndex) const
 {
-    return _rtAudio->deviceList[deviceIndex].outputChannels;
+    return _backend->GetDeviceInfo(deviceIndex).outputChannels;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -160,10 +162,7 @@ void DspAudioDevice::SetBufferSize(int bufferSize)
     _StopStream();
 
     SetParameter_(pBufferSize, DspParameter(DspParameter::Int, bufferSize));
-    for (size_t i = 0; i < _inputChannels.size(); i++)
-    {
-        _inputChannels[i].resize(bufferSize);
-    }
+    _ResizeBuffers();
 
     _StartStream();
 }
@@ -179,9 +178,45 @@ void DspAudioDevice::SetSampleRate(int sampleRate)
 
 //-------------------------------------------------------------------------------------------------
 
+void DspAudioDevice::SetBufferDepth(int bufferDepth)
+{
+    // the number of buffers queued between Process_() and the audio callback (in each direction)
+    _StopStream();
+
+    SetParameter_(pBufferDepth, DspParameter(DspParameter::Int, bufferDepth < 1 ? 1 : bufferDepth));
+    _ResizeBuffers();
+
+    _StartStream();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspAudioDevice::SetResampling(bool resampling)
+{
+    // Rather than restart the stream at each rate the "Sample Rate" input feeds in, the stream keeps
+    // its own rate, and incoming buffers are converted to it (see DspResampler). Incoming buffers
+    // then no longer set the stream's buffer size either: as many whole output buffers are queued
+    // per tick as the converted frames fill (at times none, at times more than one), such that the
+    // circuit is paced by the stream all the same. This does not apply when ticked from within the
+    // audio callback, nor to a device that is not real-time and has inputs (it runs in lockstep).
+    SetParameter_(pResample, DspParameter(DspParameter::Bool, resampling));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspAudioDevice::SetChannelOutputs(bool channelOutputs)
+{
+    // The "Channels" output carries all of the device's input channels at once. Each of the
+    // individual channel outputs costs a copy of its channel per tick, so they are only written
+    // when asked for.
+    SetParameter_(pChannelOutputs, DspParameter(DspParameter::Bool, channelOutputs));
+}
+
+//-------------------------------------------------------------------------------------------------
+
 bool DspAudioDevice::IsStreaming() const
 {
-    return *GetParameter_(pIsStreaming)->GetBool();
+    return _isStreaming.load(std::memory_order_acquire);  // mirrors pIsStreaming, for the callback
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -198,64 +233,183 @@ int DspAudioDevice::GetSampleRate() const
     return *GetParameter_(pSampleRate)->GetInt();
 }
 
+//-------------------------------------------------------------------------------------------------
+
+int DspAudioDevice::GetBufferDepth() const
+{
+    return *GetParameter_(pBufferDepth)->GetInt();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspAudioDevice::IsResampling() const
+{
+    return *GetParameter_(pResample)->GetBool();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspAudioDevice::HasChannelOutputs() const
+{
+    return *GetParameter_(pChannelOutputs)->GetBool();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspAudioDevice::GetXrunCount() const
+{
+    return _xrunCount.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspAudioDevice::GetUnderrunCount() const
+{
+    return _underrunCount.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspTickSource& DspAudioDevice::GetTickSource()
+{
+    // Attach the circuit containing this device and start the source in order to tick the circuit
+    // from within the audio callback, rather than auto-ticking it. Buffers are then exchanged with
+    // the sound card directly (bypassing the buffer queues and their latency), but as the
+    // stream cannot be reconfigured from within its own callback, the buffer size and sample rate
+    // no longer follow the inputs. The circuit must run without circuit threads.
+    return _tickSource;
+}
+
 //=================================================================================================
 
 void DspAudioDevice::Process_(DspSignalBus& inputs, DspSignalBus& outputs)
 {
-    // Wait until the sound card is ready for the next set of buffers
-    // ==============================================================
-    _syncMutex.Lock();
-    if (!_gotSyncReady)  // if haven't already got the release
-    {
-        _syncCondt.Wait(_syncMutex);  // wait for sync
-    }
-    _gotSyncReady = false;  // reset the release flag
-    _syncMutex.Unlock();
+    // when ticked from within the audio callback, there is nothing to wait for (see GetTickSource())
+    bool callbackTick = _callbackTicking.load(std::memory_order_acquire);
 
     // Synchronise sample rate with the "Sample Rate" input feed
     // =========================================================
+    // (unless resampling, see SetResampling())
     int sampleRate;
-    if (inputs.GetValue("Sample Rate", sampleRate))
+    if (!callbackTick && inputs.GetValue("Sample Rate", sampleRate))
     {
-        if (sampleRate != GetSampleRate())
+        _inputSampleRate = sampleRate;
+
+        if (sampleRate != GetSampleRate() && !_CanResample())
         {
             SetSampleRate(sampleRate);
         }
     }
 
+    DspPlanarBuffer<float> const* planarInput = inputs.GetValue< DspPlanarBuffer<float> >("Channels");
+
+    int frameCount = 0;
+    if (planarInput != NULL)
+    {
+        frameCount = planarInput->GetFrameCount();
+    }
+    else
+    {
+        std::vector<float> const* channelInput = inputs.GetValue< std::vector<float> >(0);
+
+        if (channelInput != NULL)
+        {
+            frameCount = channelInput->size();
+        }
+    }
+
+    bool resample = !callbackTick && _CanResample() && _inputSampleRate > 0 &&
+                    _inputSampleRate != GetSampleRate() && frameCount != 0;
+
+    if (resample && !_resampling)
+    {
+        _resampler.Reset();  // rather than resume from frames left over from an earlier rate
+    }
+    _resampling = resample;
+
     // Synchronise buffer size with the size of incoming buffers
     // =========================================================
-    if (inputs.GetValue(0, _outputChannels[0]))
+    if (!callbackTick && !resample && GetBufferSize() != frameCount && frameCount != 0)
+    {
+        SetBufferSize(frameCount);
+    }
+
+    // Wait until the sound card has room for the next output buffer
+    // =============================================================
+    DspPlanarBuffer<float>* outputChannels = &_outputChannels;
+    DspPlanarBuffer<float>* inputChannels = &_inputChannels;
+
+    if (!callbackTick)
     {
-        if (GetBufferSize() != (int)_outputChannels[0].size() && _outputChannels[0].size() != 0)
+        // (when resampling, output buffers are waited for as they are filled, see _WriteResampled())
+        if (!resample)
+        {
+            outputChannels = _WaitForBuffer(_outputRing, true, _outputsFreed);
+        }
+
+        // a device that is not real-time runs in lockstep with Process_(): each input buffer it
+        // hands over is matched by exactly one output buffer
+        if (!_backend->IsRealTime() && _deviceInfo.inputChannels > 0)
         {
-            SetBufferSize(_outputChannels[0].size());
+            inputChannels = _WaitForBuffer(_inputRing, false, _inputsReady);
+        }
+        else
+        {
+            inputChannels = _inputRing.GetReadSlot();
+        }
+
+        if (outputChannels == NULL)
+        {
+            outputChannels = &_outputChannels;  // not streaming, discard the output
+        }
+        if (inputChannels == NULL)
+        {
+            _inputChannels.Clear();  // no input received (yet), output silence
+            inputChannels = &_inputChannels;
         }
     }
 
     // Retrieve incoming component buffers for the sound card to output
     // ================================================================
-    for (size_t i = 0; i < _outputChannels.size(); i++)
+    if (resample)
     {
-        if (!inputs.GetValue(i, _outputChannels[i]))
-        {
-            _outputChannels[i].assign(_outputChannels[i].size(), 0);
-        }
+        // (only as many channels as the device outputs are converted)
+        _resampleChannels.Resize(std::min(_outputChannels.GetChannelCount(), _deviceInfo.outputChannels), frameCount);
+        _ReadInputSignals(inputs, _resampleChannels);
+    }
+    else
+    {
+        _ReadInputSignals(inputs, *outputChannels);
     }
 
     // Retrieve incoming sound card buffers for the component to output
     // ================================================================
-    for (size_t i = 0; i < _inputChannels.size(); i++)
+    outputs.SetValue("Channels", *inputChannels);
+
+    if (HasChannelOutputs())
     {
-        outputs.SetValue(i, _inputChannels[i]);
+        for (int i = 0; i < inputChannels->GetChannelCount(); i++)
+        {
+            float const* inputChannel = inputChannels->GetChannel(i);
+            outputs.PrepareValue< std::vector<float> >(i)->assign(inputChannel, inputChannel + inputChannels->GetFrameCount());
+        }
     }
 
-    // Inform the sound card that buffers are now ready
-    // ================================================
-    _buffersMutex.Lock();
-    _gotWaitReady = true;  // set release flag
-    _waitCondt.WakeAll();  // release sync
-    _buffersMutex.Unlock();
+    // Hand the buffers over to / back to the sound card
+    // =================================================
+    if (outputChannels != &_outputChannels)
+    {
+        _outputRing.CommitWrite();
+        _Signal(_outputsReady);
+    }
+    if (inputChannels != &_inputChannels)
+    {
+        _inputRing.CommitRead();
+    }
+    if (resample)
+    {
+        _WriteResampled();
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -276,6 +430,21 @@ bool DspAudioDevice::ParameterUpdating_(int index, DspParameter const& param)
         SetSampleRate(*param.GetInt());
         return true;
     }
+    else if (index == pBufferDepth)
+    {
+        SetBufferDepth(*param.GetInt());
+        return true;
+    }
+    else if (index == pResample)
+    {
+        SetResampling(*param.GetBool());
+        return true;
+    }
+    else if (index == pChannelOutputs)
+    {
+        SetChannelOutputs(*param.GetBool());
+        return true;
+    }
 
     return false;
 }
@@ -284,139 +453,347 @@ bool DspAudioDevice::ParameterUpdating_(int index, DspParameter const& param)
 
 void DspAudioDevice::_SetIsStreaming(bool isStreaming)
 {
+    _isStreaming.store(isStreaming, std::memory_order_release);
     SetParameter_(pIsStreaming, DspParameter(DspParameter::Bool, isStreaming));
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DspAudioDevice::_WaitForBuffer()
+void DspAudioDevice::_ResizeBuffers()
 {
-    _buffersMutex.Lock();
-    if (!_gotWaitReady)  // if haven't already got the release
+    // all buffers are sized up front (while the stream is stopped), the callback never allocates
+    int bufferDepth = GetBufferDepth();
+    int bufferSize = GetBufferSize();
+
+    _outputChannels.Resize(_outputChannels.GetChannelCount(), bufferSize);
+    _inputChannels.Resize(_inputChannels.GetChannelCount(), bufferSize);
+
+    _outputRing.Resize(bufferDepth);
+    _inputRing.Resize(bufferDepth);
+
+    for (int i = 0; i < bufferDepth; i++)
     {
-        _waitCondt.Wait(_buffersMutex);  // wait for sync
+        _outputRing.GetSlot(i).Resize(_outputChannels.GetChannelCount(), bufferSize);
+        _inputRing.GetSlot(i).Resize(_inputChannels.GetChannelCount(), bufferSize);
     }
-    _gotWaitReady = false;  // reset the release flag
-    _buffersMutex.Unlock();
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DspAudioDevice::_SyncBuffer()
+bool DspAudioDevice::_CanResample() const
 {
-    _syncMutex.Lock();
-    _gotSyncReady = true;  // set release flag
-    _syncCondt.WakeAll();  // release sync
-    _syncMutex.Unlock();
+    // a device running in lockstep hands over exactly one input buffer per output buffer
+    return IsResampling() && (_backend->IsRealTime() || _deviceInfo.inputChannels == 0);
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DspAudioDevice::_StopStream()
+DspPlanarBuffer<float>* DspAudioDevice::_WaitForBuffer(_BufferRing& ring, bool writeSlot, DspFutex& signal)
 {
-    _SetIsStreaming(false);
+    // read the signal before checking the ring, so that a buffer handed over in between is never missed
+    int signalCount = signal.Load();
+    DspPlanarBuffer<float>* channels = writeSlot ? ring.GetWriteSlot() : ring.GetReadSlot();
+
+    while (channels == NULL && IsStreaming() && !_tickSource.IsStarted())
+    {
+        signal.Wait(signalCount);
+
+        signalCount = signal.Load();
+        channels = writeSlot ? ring.GetWriteSlot() : ring.GetReadSlot();
+    }
 
-    _buffersMutex.Lock();
-    _gotWaitReady = true;  // set release flag
-    _waitCondt.WakeAll();  // release sync
-    _buffersMutex.Unlock();
+    return channels;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspAudioDevice::_Signal(DspFutex& signal)
+{
+    // bumped by the callback / Process_() as buffers are handed over, and by _StopStream()
+    int signalCount = signal.Load();
+    while (!signal.CompareExchange(signalCount, signalCount + 1))
+    {
+        signalCount = signal.Load();
+    }
+
+    signal.WakeAll();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspAudioDevice::_ReadInputSignals(DspSignalBus& inputs, DspPlanarBuffer<float>& channels)
+{
+    // (channels carried by the "Channels" input take precedence over the individual channel inputs)
+    DspPlanarBuffer<float> const* planarInput = inputs.GetValue< DspPlanarBuffer<float> >("Channels");
+
+    int planarChannelCount = 0;
+    if (planarInput != NULL && planarInput->GetFrameCount() == channels.GetFrameCount())
+    {
+        planarChannelCount = planarInput->GetChannelCount();
+    }
+
+    size_t channelSize = channels.GetFrameCount() * sizeof(float);
+
+    for (int i = 0; i < planarChannelCount && i < channels.GetChannelCount(); i++)
+    {
+        memcpy(channels.GetChannel(i), planarInput->GetChannel(i), channelSize);
+    }
+
+    // (only the channels left over are looked up one by one)
+    for (int i = planarChannelCount; i < channels.GetChannelCount(); i++)
+    {
+        std::vector<float> const* channelInput = inputs.GetValue< std::vector<float> >(i);
+
+        if (channelInput != NULL && (int)channelInput->size() == channels.GetFrameCount())
+        {
+            memcpy(channels.GetChannel(i), &(*channelInput)[0], channelSize);
+        }
+        else
+        {
+            memset(channels.GetChannel(i), 0, channelSize);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspAudioDevice::_WriteResampled()
+{
+    // convert the incoming buffer to the stream's rate, then queue as many whole output buffers as
+    // there are frames converted so far (the rest are carried over to the next tick)
+    int channelCount = _resampleChannels.GetChannelCount();
+
+    _resampler.SetRates(_inputSampleRate, GetSampleRate());
+    _resampler.SetChannelCount(channelCount);
+    _resampler.Write(_resampleChannels.GetChannel(0), _resampleChannels.GetChannelStride(), _resampleChannels.GetFrameCount());
 
-    if (_rtAudio->audioStream.isStreamOpen())
+    int bufferSize = _outputChannels.GetFrameCount();
+
+    while (bufferSize > 0 && _resampler.GetReadableFrameCount() >= bufferSize)
     {
-        _rtAudio->audioStream.closeStream();
+        DspPlanarBuffer<float>* outputChannels = _WaitForBuffer(_outputRing, true, _outputsFreed);
+
+        if (outputChannels == NULL)
+        {
+            outputChannels = &_outputChannels;  // not streaming, discard the output
+        }
+
+        _resampler.Read(outputChannels->GetChannel(0), outputChannels->GetChannelStride(), bufferSize);
+
+        for (int i = channelCount; i < outputChannels->GetChannelCount(); i++)
+        {
+            memset(outputChannels->GetChannel(i), 0, bufferSize * sizeof(float));
+        }
+
+        if (outputChannels != &_outputChannels)
+        {
+            _outputRing.CommitWrite();
+            _Signal(_outputsReady);
+        }
     }
 }
 
 //-------------------------------------------------------------------------------------------------
 
+void DspAudioDevice::_StopStream()
+{
+    _SetIsStreaming(false);
+
+    // release the callback and Process_() should they be waiting for one another
+    _Signal(_outputsReady);
+
+    _backend->CloseStream();
+
+    _Signal(_outputsFreed);
+    _Signal(_inputsReady);
+}
+
+//-------------------------------------------------------------------------------------------------
+
 void DspAudioDevice::_StartStream()
 {
-    RtAudio::StreamParameters* inputParams = NULL;
-    RtAudio::StreamParameters* outputParams = NULL;
+    int bufferSize = GetBufferSize();
 
-    if (_rtAudio->inputParams.nChannels != 0)
+    if (!_backend->OpenStream(GetCurrentDevice(), GetSampleRate(), bufferSize, &_StaticCallback, this))
     {
-        inputParams = &_rtAudio->inputParams;
+        return;
     }
 
-    if (_rtAudio->outputParams.nChannels != 0)
+    // the device may not support the buffer size asked for
+    if (bufferSize != GetBufferSize())
     {
-        outputParams = &_rtAudio->outputParams;
+        SetParameter_(pBufferSize, DspParameter(DspParameter::Int, bufferSize));
+        _ResizeBuffers();
     }
 
-    RtAudio::StreamOptions options;
-    options.flags |= RTAUDIO_SCHEDULE_REALTIME;
-    options.flags |= RTAUDIO_NONINTERLEAVED;
+    _inputRing.Clear();
+    _outputRing.Clear();
 
-    _rtAudio->audioStream.openStream(outputParams,
-                                     inputParams,
-                                     RTAUDIO_FLOAT32,
-                                     GetSampleRate(),
-                                     (unsigned int*)const_cast<int*>(GetParameter_(pBufferSize)->GetInt()),
-                                     &_StaticCallback,
-                                     this,
-                                     &options);
+    // a real-time device starts with a full queue of silence, such that Process_() has a buffer
+    // depth to catch up in (any other waits for Process_() anyway)
+    while (_backend->IsRealTime() && _outputRing.GetWriteSlot() != NULL)
+    {
+        _outputRing.GetWriteSlot()->Clear();
+        _outputRing.CommitWrite();
+    }
 
-    _rtAudio->audioStream.startStream();
+    _SetIsStreaming(true);  // before the first callback
 
-    _SetIsStreaming(true);
+    if (!_backend->StartStream())
+    {
+        _StopStream();
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
 
-int DspAudioDevice::_StaticCallback(
-    void* outputBuffer, void* inputBuffer, unsigned int, double, unsigned int, void* userData)
+int DspAudioDevice::_StaticCallback(void* outputBuffer, void* inputBuffer, unsigned int status, void* userData)
 {
-    return (reinterpret_cast<DspAudioDevice*>(userData))->_DynamicCallback(inputBuffer, outputBuffer);
+    return (reinterpret_cast<DspAudioDevice*>(userData))->_DynamicCallback(inputBuffer, outputBuffer, status);
 }
 
 //-------------------------------------------------------------------------------------------------
 
-int DspAudioDevice::_DynamicCallback(void* inputBuffer, void* outputBuffer)
+int DspAudioDevice::_DynamicCallback(void* inputBuffer, void* outputBuffer, unsigned int status)
 {
-    _WaitForBuffer();
+    // The callback never takes a lock nor waits: buffers are handed to and from Process_() through
+    // lock-free rings, and when Process_() falls behind, the callback drops input / outputs silence
+    // and counts an xrun / underrun instead.
 
-    if (IsStreaming())
+    if (!IsStreaming())
     {
-        float* floatOutput = (float*)outputBuffer;
-        float* floatInput = (float*)inputBuffer;
+        return 1;
+    }
 
-        if (outputBuffer != NULL)
+    if (status != 0)
+    {
+        _xrunCount.fetch_add(1, std::memory_order_relaxed);  // reported by the sound card itself
+    }
+
+    // when driving its circuit, tick it right here, between reading the sound card's input and
+    // writing its output (see GetTickSource())
+    if (_tickSource.IsStarted())
+    {
+        _ReadDeviceInput(inputBuffer, _inputChannels);
+
+        // (flagged for the tick's duration, as the source may be stopped mid-tick)
+        _callbackTicking.store(true, std::memory_order_release);
+        bool ticked = _tickSource.Tick();
+        _callbackTicking.store(false, std::memory_order_release);
+
+        if (!ticked)
+        {
+            _outputChannels.Clear();  // output silence while ticks are paused
+        }
+
+        _WriteDeviceOutput(outputBuffer, &_outputChannels);
+        return 0;
+    }
+
+    // hand the sound card's input to Process_()
+    if (inputBuffer != NULL)
+    {
+        DspPlanarBuffer<float>* inputChannels = _inputRing.GetWriteSlot();
+
+        if (inputChannels != NULL)
+        {
+            _ReadDeviceInput(inputBuffer, *inputChannels);
+            _inputRing.CommitWrite();
+            _Signal(_inputsReady);
+        }
+        else
         {
-            for (size_t i = 0; i < _outputChannels.size(); i++)
+            _xrunCount.fetch_add(1, std::memory_order_relaxed);  // Process_() fell behind, drop it
+        }
+    }
+
+    // output the next buffer from Process_(), then free it for Process_() to fill again
+    DspPlanarBuffer<float>* outputChannels = _outputRing.GetReadSlot();
+
+    if (outputChannels == NULL && !_backend->IsRealTime())
+    {
+        outputChannels = _WaitForBuffer(_outputRing, false, _outputsReady);  // a device that is not real-time waits instead
+    }
+
+    if (outputChannels != NULL)
+    {
+        _WriteDeviceOutput(outputBuffer, outputChannels);
+
+        _outputRing.CommitRead();
+        _Signal(_outputsFreed);
+    }
+    else
+    {
+        _underrunCount.fetch_add(1, std::memory_order_relaxed);
+        _WriteDeviceOutput(outputBuffer, NULL);
+    }
+
+    return 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspAudioDevice::_ReadDeviceInput(void* inputBuffer, DspPlanarBuffer<float>& channels)
+{
+    float* floatInput = (float*)inputBuffer;
+
+    if (inputBuffer != NULL)
+    {
+        for (int i = 0; i < channels.GetChannelCount(); i++)
+        {
+            if (_deviceInfo.inputChannels >= i + 1)
             {
-                if (_rtAudio->deviceList[GetCurrentDevice()].outputChannels >= (i + 1))
-                {
-                    for (size_t j = 0; j < _outputChannels[i].size(); j++)
-                    {
-                        *floatOutput++ = _outputChannels[i][j];
-                    }
-                }
+                memcpy(channels.GetChannel(i), floatInput, channels.GetFrameCount() * sizeof(float));
+                floatInput += channels.GetFrameCount();
             }
         }
+    }
+}
 
-        if (inputBuffer != NULL)
+//-------------------------------------------------------------------------------------------------
+
+void DspAudioDevice::_WriteDeviceOutput(void* outputBuffer, DspPlanarBuffer<float> const* channels)
+{
+    float* floatOutput = (float*)outputBuffer;
+
+    if (outputBuffer != NULL)
+    {
+        // (a NULL channels buffer outputs silence)
+        int frameCount = _outputChannels.GetFrameCount();
+
+        for (int i = 0; i < _outputChannels.GetChannelCount(); i++)
         {
-            for (size_t i = 0; i < _inputChannels.size(); i++)
+            if (_deviceInfo.outputChannels >= i + 1)
             {
-                if (_rtAudio->deviceList[GetCurrentDevice()].inputChannels >= (i + 1))
+                if (channels != NULL)
+                {
+                    memcpy(floatOutput, channels->GetChannel(i), frameCount * sizeof(float));
+                }
+                else
                 {
-                    for (size_t j = 0; j < _inputChannels[i].size(); j++)
-                    {
-                        _inputChannels[i][j] = *floatInput++;
-                    }
+                    memset(floatOutput, 0, frameCount * sizeof(float));
                 }
+                floatOutput += frameCount;
             }
         }
     }
-    else
-    {
-        _SyncBuffer();
-        return 1;
-    }
+}
 
-    _SyncBuffer();
-    return 0;
+//=================================================================================================
+
+DspAudioDevice::_TickSource::_TickSource(DspAudioDevice* device)
+    : _device(device)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspAudioDevice::_TickSource::Start_()
+{
+    // a callback waiting on Process_() (see _WaitForBuffer()) goes on to tick the circuit instead
+    _device->_Signal(_device->_outputsReady);
+
+    return DspCallbackTickSource::Start_();
 }
 
 //=================================================================================================
@@ -25,9 +25,10 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 #ifndef DSPAUDIODEVICE_H
 #define DSPAUDIODEVICE_H
 
-#include <DSPatch.h>
+#include <atomic>
 
-struct RtAudioMembers;
+#include <DspAudioBackend.h>
+#include <DspResampler.h>
 
 //-------------------------------------------------------------------------------------------------
 
@@ -38,10 +39,15 @@ public:
     int pIsStreaming;  // Bool
     int pBufferSize;   // Int
     int pSampleRate;   // Int
+    int pBufferDepth;  // Int
+    int pResample;     // Bool
+    int pChannelOutputs;  // Bool
 
-    DspAudioDevice();
+    explicit DspAudioDevice(DspAudioBackend* backend);  // takes ownership
     ~DspAudioDevice();
 
+    DspAudioBackend* GetBackend() const;
+
     bool SetDevice(int deviceIndex);
 
     std::string GetDeviceName(int deviceIndex) const;
@@ -52,44 +58,82 @@ public:
 
     void SetBufferSize(int bufferSize);
     void SetSampleRate(int sampleRate);
+    void SetBufferDepth(int bufferDepth);
+    void SetResampling(bool resampling);  // convert "Sample Rate" input rates rather than follow them
+    void SetChannelOutputs(bool channelOutputs);  // also output each channel alone, beside "Channels"
 
     bool IsStreaming() const;
     int GetBufferSize() const;
     int GetSampleRate() const;
+    int GetBufferDepth() const;
+    bool IsResampling() const;
+    bool HasChannelOutputs() const;
+
+    unsigned long GetXrunCount() const;
+    unsigned long GetUnderrunCount() const;
+
+    DspTickSource& GetTickSource();
 
 protected:
     virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs);
     virtual bool ParameterUpdating_(int index, DspParameter const& param);
 
 private:
-    std::vector< std::vector<float> > _outputChannels;
-    std::vector< std::vector<float> > _inputChannels;
+    class _TickSource : public DspCallbackTickSource
+    {
+    public:
+        _TickSource(DspAudioDevice* device);
+
+    protected:
+        virtual bool Start_();
+
+    private:
+        DspAudioDevice* _device;
+    };
+
+    DspPlanarBuffer<float> _outputChannels;
+    DspPlanarBuffer<float> _inputChannels;
+
+    DspAudioBackend* _backend;
+    DspAudioBackend::DeviceInfo _deviceInfo;  // of the current device
+    _TickSource _tickSource;
+
+    typedef DspRingBuffer< DspPlanarBuffer<float> > _BufferRing;
+
+    _BufferRing _outputRing;  // Process_() -> callback
+    _BufferRing _inputRing;   // callback -> Process_()
+    DspFutex _outputsFreed;   // bumped whenever the callback frees an output buffer
+    DspFutex _outputsReady;   // bumped whenever Process_() queues an output buffer
+    DspFutex _inputsReady;    // bumped whenever the callback queues an input buffer
+    std::atomic<unsigned long> _xrunCount;
+    std::atomic<unsigned long> _underrunCount;
+    std::atomic<bool> _isStreaming;
+    std::atomic<bool> _callbackTicking;  // set while the callback ticks the circuit
+
+    DspResampler _resampler;                   // "Sample Rate" input rate -> stream rate
+    DspPlanarBuffer<float> _resampleChannels;  // at the "Sample Rate" input rate
+    int _inputSampleRate;
+    bool _resampling;
 
-    RtAudioMembers* _rtAudio;
+    void _SetIsStreaming(bool isStreaming);
+    void _ResizeBuffers();
+    bool _CanResample() const;
 
-    DspMutex _buffersMutex;
-    DspMutex _syncMutex;
-    DspWaitCondition _waitCondt;
-    DspWaitCondition _syncCondt;
-    bool _gotWaitReady;
-    bool _gotSyncReady;
+    DspPlanarBuffer<float>* _WaitForBuffer(_BufferRing& ring, bool writeSlot, DspFutex& signal);
+    void _Signal(DspFutex& signal);
 
-    void _SetIsStreaming(bool isStreaming);
+    void _ReadInputSignals(DspSignalBus& inputs, DspPlanarBuffer<float>& channels);
+    void _WriteResampled();
 
-    void _WaitForBuffer();
-    void _SyncBuffer();
+    void _ReadDeviceInput(void* inputBuffer, DspPlanarBuffer<float>& channels);
+    void _WriteDeviceOutput(void* outputBuffer, DspPlanarBuffer<float> const* channels);
 
     void _StopStream();
     void _StartStream();
 
-    static int _StaticCallback(void* outputBuffer,
-                               void* inputBuffer,
-                               unsigned int nBufferFrames,
-                               double streamTime,
-                               unsigned int status,
-                               void* userData);
+    static int _StaticCallback(void* outputBuffer, void* inputBuffer, unsigned int status, void* userData);
 
-    int _DynamicCallback(void* inputBuffer, void* outputBuffer);
+    int _DynamicCallback(void* inputBuffer, void* outputBuffer, unsigned int status);
 };
 
 //-------------------------------------------------------------------------------------------------
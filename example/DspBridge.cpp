@@ -0,0 +1,488 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DspBridge.h>
+
+#include <algorithm>
+#include <string.h>
+
+//=================================================================================================
+
+static double const fillSmoothing = 0.005;     // weight of each tick's fill level in the average
+static double const proportionalGain = 0.003;  // rate adjustment per fill level error
+static double const integralGain = 5.6e-7;     // rate adjustment per accumulated fill level error
+static double const maxAdjustment = 0.005;     // drift compensated for at most
+
+//=================================================================================================
+
+DspBridgeSender::DspBridgeSender(DspBridgeReceiver* receiver)
+    : _receiver(NULL)
+    , _sampleRate(0)
+{
+    AddInput_();
+    AddInput_("Sample Rate");
+
+    Attach(receiver);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspBridgeSender::~DspBridgeSender()
+{
+    Detach();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspBridgeSender::Attach(DspBridgeReceiver* receiver)
+{
+    if (receiver == _receiver)
+    {
+        return true;
+    }
+    if (receiver != NULL && receiver->_sender != NULL)
+    {
+        return false;  // the receiver is fed by another sender already
+    }
+
+    Detach();
+
+    if (receiver != NULL)
+    {
+        receiver->_sender = this;
+        receiver->_Reset();
+    }
+    _receiver = receiver;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspBridgeSender::Detach()
+{
+    if (_receiver != NULL)
+    {
+        _receiver->_sender = NULL;
+        _receiver = NULL;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspBridgeReceiver* DspBridgeSender::GetReceiver() const
+{
+    return _receiver;
+}
+
+//=================================================================================================
+
+void DspBridgeSender::Process_(DspSignalBus& inputs, DspSignalBus&)
+{
+    int sampleRate;
+    if (inputs.GetValue("Sample Rate", sampleRate))
+    {
+        _sampleRate = sampleRate;
+    }
+
+    DspPlanarBuffer<float> const* channels = inputs.GetValue< DspPlanarBuffer<float> >(0);
+    std::vector<float> const* stream = inputs.GetValue< std::vector<float> >(0);
+
+    if (_receiver == NULL || (channels == NULL && stream == NULL))
+    {
+        return;
+    }
+
+    DspBridgeReceiver::_Block* block = _receiver->_blockRing.GetWriteSlot();
+
+    if (block == NULL)
+    {
+        _receiver->_overrunCount.fetch_add(1, std::memory_order_relaxed);  // the receiver fell behind, drop it
+        return;
+    }
+
+    // copied into the slot's buffer in place (reusing its allocation)
+    if (channels != NULL)
+    {
+        block->channels = *channels;
+    }
+    else
+    {
+        block->channels.Resize(1, stream->size());
+        if (!stream->empty())
+        {
+            memcpy(block->channels.GetChannel(0), &(*stream)[0], stream->size() * sizeof(float));
+        }
+    }
+
+    block->sampleRate = _sampleRate;
+    block->isStream = channels == NULL;
+
+    // (counted before the block is published, such that the count never runs below zero)
+    _receiver->_queuedFrames.fetch_add(block->channels.GetFrameCount(), std::memory_order_relaxed);
+    _receiver->_blockRing.CommitWrite();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspComponent* DspBridgeSender::Clone_()
+{
+    return new DspBridgeSender();  // a receiver is fed by one sender only, hence clones are detached
+}
+
+//=================================================================================================
+
+DspBridgeReceiver::DspBridgeReceiver()
+    : _sender(NULL)
+    , _blockOffset(0)
+    , _queuedFrames(0)
+    , _underrunCount(0)
+    , _overrunCount(0)
+    , _channelCount(0)
+    , _sampleRate(0)
+    , _isStream(false)
+    , _blockFrameCount(0)
+    , _filling(true)
+    , _averageFill(0.0)
+    , _fillIntegral(0.0)
+    , _rateAdjustment(0.0)
+{
+    AddOutput_();
+    AddOutput_("Sample Rate");
+
+    pBufferSize = AddParameter_("bufferSize", DspParameter(DspParameter::Int, 256));
+    pBufferDepth = AddParameter_("bufferDepth", DspParameter(DspParameter::Int, 8));
+    pSampleRate = AddParameter_("sampleRate", DspParameter(DspParameter::Int, 0));
+    pDriftCompensation = AddParameter_("driftCompensation", DspParameter(DspParameter::Bool, true));
+
+    SetBufferDepth(GetBufferDepth());
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspBridgeReceiver::~DspBridgeReceiver()
+{
+    if (_sender != NULL)
+    {
+        _sender->Detach();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspBridgeSender* DspBridgeReceiver::GetSender() const
+{
+    return _sender;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspBridgeReceiver::SetBufferSize(int bufferSize)
+{
+    SetParameter_(pBufferSize, DspParameter(DspParameter::Int, std::max(1, bufferSize)));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspBridgeReceiver::SetBufferDepth(int bufferDepth)
+{
+    SetParameter_(pBufferDepth, DspParameter(DspParameter::Int, std::max(3, bufferDepth)));
+
+    _blockRing.Resize(GetBufferDepth());
+    _Reset();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspBridgeReceiver::SetSampleRate(int sampleRate)
+{
+    SetParameter_(pSampleRate, DspParameter(DspParameter::Int, std::max(0, sampleRate)));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspBridgeReceiver::SetDriftCompensation(bool enabled)
+{
+    SetParameter_(pDriftCompensation, DspParameter(DspParameter::Bool, enabled));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspBridgeReceiver::GetBufferSize() const
+{
+    return *GetParameter_(pBufferSize)->GetInt();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspBridgeReceiver::GetBufferDepth() const
+{
+    return *GetParameter_(pBufferDepth)->GetInt();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspBridgeReceiver::GetSampleRate() const
+{
+    return *GetParameter_(pSampleRate)->GetInt();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspBridgeReceiver::GetDriftCompensation() const
+{
+    return *GetParameter_(pDriftCompensation)->GetBool();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspBridgeReceiver::GetQueuedFrameCount() const
+{
+    return _queuedFrames.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double DspBridgeReceiver::GetRateAdjustment() const
+{
+    return _rateAdjustment.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspBridgeReceiver::GetUnderrunCount() const
+{
+    return _underrunCount.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspBridgeReceiver::GetOverrunCount() const
+{
+    return _overrunCount.load(std::memory_order_relaxed);
+}
+
+//=================================================================================================
+
+void DspBridgeReceiver::Process_(DspSignalBus&, DspSignalBus& outputs)
+{
+    // pick up the stream's format from the next buffer received
+    _Block* block = _blockRing.GetReadSlot();
+
+    if (block != NULL)
+    {
+        _channelCount = block->channels.GetChannelCount();
+        _sampleRate = block->sampleRate;
+        _isStream = block->isStream;
+        _blockFrameCount = block->channels.GetFrameCount();
+    }
+
+    if (_channelCount == 0)
+    {
+        outputs.ClearValue(0);  // nothing received yet
+        return;
+    }
+
+    // without a rate on either end, the stream is taken to be of the same rate on both
+    int inputRate = _sampleRate > 0 ? _sampleRate : GetSampleRate();
+    int outputRate = GetSampleRate() > 0 ? GetSampleRate() : _sampleRate;
+
+    if (inputRate <= 0)
+    {
+        inputRate = outputRate = 44100;
+    }
+
+    int frameCount = GetBufferSize();
+    _channels.Resize(_channelCount, frameCount);
+
+    // wait for the ring to fill up halfway before starting (again), leaving room for at least a
+    // whole buffer to be read while the next block is in flight (as far as the ring allows)
+    int targetFrameCount = std::max(_blockRing.GetCapacity() * _blockFrameCount / 2, frameCount + _blockFrameCount);
+    targetFrameCount = std::min(targetFrameCount, (_blockRing.GetCapacity() - 1) * _blockFrameCount);
+
+    if (_filling && _queuedFrames.load(std::memory_order_relaxed) >= targetFrameCount)
+    {
+        _filling = false;
+        _averageFill = _queuedFrames.load(std::memory_order_relaxed);
+    }
+
+    if (_filling)
+    {
+        _channels.Clear();
+    }
+    else if (GetDriftCompensation() || inputRate != outputRate)
+    {
+        // read as many frames off the ring as it takes to convert a whole buffer
+        _resampler.SetRates(inputRate, outputRate);
+        _resampler.SetChannelCount(_channelCount);
+        _Compensate(targetFrameCount);
+
+        int inputFrameCount = _resampler.GetInputFrameCount(frameCount);
+
+        _blockChannels.Resize(_channelCount, inputFrameCount);
+        _PullFrames(_blockChannels, inputFrameCount);
+
+        _resampler.Write(_blockChannels.GetChannel(0), _blockChannels.GetChannelStride(), inputFrameCount);
+        _resampler.Read(_channels.GetChannel(0), _channels.GetChannelStride(), frameCount);
+    }
+    else
+    {
+        _PullFrames(_channels, frameCount);
+    }
+
+    if (_isStream)
+    {
+        _stream.assign(_channels.GetChannel(0), _channels.GetChannel(0) + frameCount);
+        outputs.SetValue(0, _stream);
+    }
+    else
+    {
+        outputs.SetValue(0, _channels);
+    }
+
+    outputs.SetValue("Sample Rate", outputRate);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspBridgeReceiver::ParameterUpdating_(int index, DspParameter const& param)
+{
+    if (index == pBufferSize)
+    {
+        SetBufferSize(*param.GetInt());
+        return true;
+    }
+    else if (index == pBufferDepth)
+    {
+        SetBufferDepth(*param.GetInt());
+        return true;
+    }
+    else if (index == pSampleRate)
+    {
+        SetSampleRate(*param.GetInt());
+        return true;
+    }
+    else if (index == pDriftCompensation)
+    {
+        SetDriftCompensation(*param.GetBool());
+        return true;
+    }
+
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspComponent* DspBridgeReceiver::Clone_()
+{
+    return new DspBridgeReceiver();
+}
+
+//=================================================================================================
+
+void DspBridgeReceiver::_Reset()
+{
+    _blockRing.Clear();
+    _blockOffset = 0;
+    _queuedFrames.store(0, std::memory_order_relaxed);
+
+    _filling = true;
+    _averageFill = 0.0;
+    _fillIntegral = 0.0;
+    _rateAdjustment.store(0.0, std::memory_order_relaxed);
+
+    _resampler.SetRateAdjustment(0.0);
+    _resampler.Reset();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspBridgeReceiver::_PullFrames(DspPlanarBuffer<float>& channels, int frameCount)
+{
+    // copy the next frames out of the blocks received
+    for (int frame = 0; frame < frameCount;)
+    {
+        _Block* block = _blockRing.GetReadSlot();
+
+        if (block == NULL)
+        {
+            // the sender fell behind, output silence until the ring has filled up again
+            for (int i = 0; i < channels.GetChannelCount(); i++)
+            {
+                memset(channels.GetChannel(i) + frame, 0, (frameCount - frame) * sizeof(float));
+            }
+
+            _underrunCount.fetch_add(1, std::memory_order_relaxed);
+            _filling = true;
+            break;
+        }
+
+        int readCount = std::min(block->channels.GetFrameCount() - _blockOffset, frameCount - frame);
+
+        for (int i = 0; i < channels.GetChannelCount(); i++)
+        {
+            if (i < block->channels.GetChannelCount())
+            {
+                memcpy(channels.GetChannel(i) + frame,
+                       block->channels.GetChannel(i) + _blockOffset,
+                       readCount * sizeof(float));
+            }
+            else
+            {
+                memset(channels.GetChannel(i) + frame, 0, readCount * sizeof(float));
+            }
+        }
+
+        frame += readCount;
+        _blockOffset += readCount;
+        _queuedFrames.fetch_sub(readCount, std::memory_order_relaxed);
+
+        if (_blockOffset == block->channels.GetFrameCount())
+        {
+            _blockRing.CommitRead();
+            _blockOffset = 0;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspBridgeReceiver::_Compensate(int targetFrameCount)
+{
+    // steer the ring's fill level towards the target: playing faster while it fills up (the
+    // sender's clock runs fast), slower while it drains (the sender's clock runs slow)
+    _averageFill += (_queuedFrames.load(std::memory_order_relaxed) - _averageFill) * fillSmoothing;
+
+    double error = (_averageFill - targetFrameCount) / targetFrameCount;
+
+    _fillIntegral = std::max(-maxAdjustment / integralGain,
+                             std::min(_fillIntegral + error, maxAdjustment / integralGain));
+
+    double adjustment = proportionalGain * error + integralGain * _fillIntegral;
+
+    _resampler.SetRateAdjustment(std::max(-maxAdjustment, std::min(adjustment, maxAdjustment)));
+    _rateAdjustment.store(_resampler.GetRateAdjustment(), std::memory_order_relaxed);
+}
+
+//=================================================================================================
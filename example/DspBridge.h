@@ -0,0 +1,156 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPBRIDGE_H
+#define DSPBRIDGE_H
+
+#include <DspResampler.h>
+
+#include <atomic>
+
+class DspBridgeReceiver;
+
+//=================================================================================================
+// Streams samples from one circuit to another ticked independently (E.g. each by its own audio
+// device), without either side taking a lock or waiting on the other.
+//
+// A DspBridgeSender in the first circuit hands each buffer fed into its input 0 (either a single
+// channel as a std::vector<float>, or all channels of a stream as a DspPlanarBuffer<float>) to the
+// DspBridgeReceiver it is attached to in the second, through a lock-free ring of buffers (see
+// DspRingBuffer). The sender's "Sample Rate" input tells the buffers' sample rate, if known. Should
+// the ring be full, the buffer is dropped, and the receiver's GetOverrunCount() incremented.
+//
+// Every tick, the receiver outputs a buffer of its own size (see SetBufferSize()) on its output 0,
+// of the type fed into the sender, and its sample rate on its "Sample Rate" output. The ring holds
+// GetBufferDepth() of the sender's buffers (at least 3, and best enough to span several of the
+// receiver's), and acts as a jitter buffer: the receiver outputs silence until the ring is half
+// full, and again after running dry (incrementing GetUnderrunCount()). As the two circuits' clocks
+// never run at exactly the same rate, the ring would eventually overflow or run dry all the same.
+// With drift compensation on (the default, see SetDriftCompensation()), the receiver instead
+// resamples the stream (see DspResampler), speeding up or slowing down playback by a fraction of a
+// percent so as to keep the ring half full. The stream may also be converted to another sample
+// rate (see SetSampleRate()).
+//
+// A sender feeds at most one receiver, and vice versa. Attaching, detaching and destroying either
+// end, as well as resizing the ring (see SetBufferDepth()), may only be done while neither end's
+// circuit is ticking.
+
+//=================================================================================================
+
+class DspBridgeSender : public DspComponent
+{
+public:
+    DspBridgeSender(DspBridgeReceiver* receiver = NULL);
+    ~DspBridgeSender();
+
+    bool Attach(DspBridgeReceiver* receiver);
+    void Detach();
+
+    DspBridgeReceiver* GetReceiver() const;
+
+protected:
+    virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs);
+    virtual DspComponent* Clone_();
+
+private:
+    DspBridgeReceiver* _receiver;
+    int _sampleRate;
+};
+
+//=================================================================================================
+
+class DspBridgeReceiver : public DspComponent
+{
+public:
+    int pBufferSize;         // Int
+    int pBufferDepth;        // Int
+    int pSampleRate;         // Int
+    int pDriftCompensation;  // Bool
+
+    DspBridgeReceiver();
+    ~DspBridgeReceiver();
+
+    DspBridgeSender* GetSender() const;
+
+    void SetBufferSize(int bufferSize);
+    void SetBufferDepth(int bufferDepth);  // in sender buffers
+    void SetSampleRate(int sampleRate);    // 0: the sender's
+    void SetDriftCompensation(bool enabled);
+
+    int GetBufferSize() const;
+    int GetBufferDepth() const;
+    int GetSampleRate() const;
+    bool GetDriftCompensation() const;
+
+    int GetQueuedFrameCount() const;
+    double GetRateAdjustment() const;  // the current drift compensation
+    unsigned long GetUnderrunCount() const;
+    unsigned long GetOverrunCount() const;
+
+protected:
+    virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs);
+    virtual bool ParameterUpdating_(int index, DspParameter const& param);
+    virtual DspComponent* Clone_();
+
+private:
+    friend class DspBridgeSender;
+
+    struct _Block
+    {
+        DspPlanarBuffer<float> channels;
+        int sampleRate;
+        bool isStream;  // fed in as a std::vector<float>
+    };
+
+    void _Reset();
+    void _PullFrames(DspPlanarBuffer<float>& channels, int frameCount);
+    void _Compensate(int targetFrameCount);
+
+    DspBridgeSender* _sender;
+
+    DspRingBuffer<_Block> _blockRing;  // sender -> receiver
+    int _blockOffset;                  // frames of the block at the ring's head already output
+    std::atomic<int> _queuedFrames;    // in the ring, not yet output
+    std::atomic<unsigned long> _underrunCount;
+    std::atomic<unsigned long> _overrunCount;
+
+    int _channelCount;  // of the last block received
+    int _sampleRate;
+    bool _isStream;
+    int _blockFrameCount;
+    bool _filling;      // outputting silence until the ring is half full
+
+    DspResampler _resampler;
+    double _averageFill;  // queued frames, low-pass filtered
+    double _fillIntegral;
+    std::atomic<double> _rateAdjustment;
+
+    DspPlanarBuffer<float> _blockChannels;  // at the sender's rate, when resampling
+    DspPlanarBuffer<float> _channels;
+    std::vector<float> _stream;
+};
+
+//=================================================================================================
+
+#endif  // DSPBRIDGE_H
@@ -0,0 +1,315 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DspFileAudioBackend.h>
+
+#include <string.h>
+
+//=================================================================================================
+
+namespace
+{
+
+bool IsWaveFile(std::string const& path)
+{
+    return path.size() >= 4 && (path.compare(path.size() - 4, 4, ".wav") == 0 ||
+                                path.compare(path.size() - 4, 4, ".WAV") == 0);
+}
+
+unsigned long ReadLittleEndian(std::ifstream& file, int byteCount)
+{
+    unsigned char bytes[4] = {0, 0, 0, 0};
+    file.read(reinterpret_cast<char*>(bytes), byteCount);
+
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned long)bytes[3] << 24);
+}
+
+void WriteLittleEndian(std::ofstream& file, unsigned long value, int byteCount)
+{
+    for (int i = 0; i < byteCount; i++)
+    {
+        file.put((char)((value >> (i * 8)) & 0xff));
+    }
+}
+
+}  // namespace
+
+//=================================================================================================
+
+DspFileAudioBackend::DspFileAudioBackend(std::string const& inputPath,
+                                         std::string const& outputPath,
+                                         int inputChannels,
+                                         int outputChannels)
+    : DspNullAudioBackend(DeviceInfo("File Device", inputChannels, outputChannels), false)
+    , _inputPath(inputPath)
+    , _outputPath(outputPath)
+    , _inputChannels(inputChannels)
+    , _outputChannels(outputChannels)
+    , _inputFileChannels(0)
+    , _inputSampleType(DspSampleDecoder::Unsupported)
+    , _inputFramesLeft(0)
+    , _inputFinished(false)
+    , _outputIsWave(false)
+    , _outputSampleRate(0)
+    , _outputFrameCount(0)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspFileAudioBackend::~DspFileAudioBackend()
+{
+    CloseStream();  // Close_() must run while we are still a DspFileAudioBackend
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspFileAudioBackend::IsInputFinished() const
+{
+    return _inputFinished.load(std::memory_order_relaxed);
+}
+
+//=================================================================================================
+
+bool DspFileAudioBackend::Open_(int sampleRate)
+{
+    _inputFinished.store(_inputPath.empty(), std::memory_order_relaxed);
+
+    if ((!_inputPath.empty() && !_OpenInput()) || (!_outputPath.empty() && !_OpenOutput(sampleRate)))
+    {
+        Close_();
+        return false;
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspFileAudioBackend::Close_()
+{
+    if (_inputFile.is_open())
+    {
+        _inputFile.close();
+    }
+
+    if (_outputFile.is_open())
+    {
+        // now that the data size is known, complete the header
+        if (_outputIsWave)
+        {
+            _outputFile.seekp(0, std::ios::beg);
+            _WriteWaveHeader(_outputSampleRate, _outputFrameCount * _outputChannels * sizeof(float));
+        }
+
+        _outputFile.close();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspFileAudioBackend::ReadInput_(float* inputBuffer, int bufferSize)
+{
+    memset(inputBuffer, 0, _inputChannels * bufferSize * sizeof(float));
+
+    int readCount = _inputFramesLeft < (unsigned long long)bufferSize ? (int)_inputFramesLeft : bufferSize;
+
+    if (!_inputFile.is_open() || readCount == 0)
+    {
+        _inputFinished.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    int frameSize = DspSampleDecoder::GetSampleSize(_inputSampleType) * _inputFileChannels;
+
+    _fileBuffer.resize(readCount * frameSize);
+    _inputFile.read(&_fileBuffer[0], _fileBuffer.size());
+
+    // a short read means the file was truncated, treat it as the end of the input
+    int frameCount = _inputFile.gcount() / frameSize;
+    _inputFramesLeft = frameCount < readCount ? 0 : _inputFramesLeft - frameCount;
+
+    // deinterleave and convert the channels the device has, leaving the rest silent
+    DspSampleDecoder::Decode(_inputSampleType,
+                             _inputFileChannels,
+                             &_fileBuffer[0],
+                             frameCount,
+                             inputBuffer,
+                             bufferSize,
+                             _inputChannels);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspFileAudioBackend::WriteOutput_(float const* outputBuffer, int bufferSize)
+{
+    if (!_outputFile.is_open())
+    {
+        return;
+    }
+
+    // interleave the channels as 32-bit float frames
+    _fileBuffer.resize(bufferSize * _outputChannels * sizeof(float));
+    float* frames = reinterpret_cast<float*>(&_fileBuffer[0]);
+
+    for (int i = 0; i < _outputChannels; i++)
+    {
+        float const* channel = outputBuffer + i * bufferSize;
+
+        for (int j = 0; j < bufferSize; j++)
+        {
+            frames[j * _outputChannels + i] = channel[j];
+        }
+    }
+
+    _outputFile.write(&_fileBuffer[0], _fileBuffer.size());
+    _outputFrameCount += bufferSize;
+}
+
+//=================================================================================================
+
+bool DspFileAudioBackend::_OpenInput()
+{
+    _inputFile.open(_inputPath.c_str(), std::ios::binary | std::ios::in);
+    if (!_inputFile.is_open())
+    {
+        return false;
+    }
+
+    if (!IsWaveFile(_inputPath))
+    {
+        // raw 32-bit float frames
+        _inputFile.seekg(0, std::ios::end);
+        unsigned long long fileSize = _inputFile.tellg();
+        _inputFile.seekg(0, std::ios::beg);
+
+        _inputFileChannels = _inputChannels;
+        _inputSampleType = DspSampleDecoder::Float32;
+        _inputFramesLeft = _inputChannels == 0 ? 0 : fileSize / (_inputChannels * sizeof(float));
+        return true;
+    }
+
+    char chunkId[5] = {0, 0, 0, 0, 0};
+
+    _inputFile.read(chunkId, 4);
+    ReadLittleEndian(_inputFile, 4);
+    if (strcmp(chunkId, "RIFF"))
+    {
+        return false;
+    }
+
+    _inputFile.read(chunkId, 4);
+    if (strcmp(chunkId, "WAVE"))
+    {
+        return false;
+    }
+
+    // walk the chunks up to the "data" chunk, picking up the format on the way
+    int format = 0, bitDepth = 0;
+
+    while (_inputFile.read(chunkId, 4))
+    {
+        unsigned long chunkSize = ReadLittleEndian(_inputFile, 4);
+        std::streampos chunkData = _inputFile.tellg();
+
+        if (!strcmp(chunkId, "fmt "))
+        {
+            format = ReadLittleEndian(_inputFile, 2);
+            _inputFileChannels = ReadLittleEndian(_inputFile, 2);
+            ReadLittleEndian(_inputFile, 4);  // sample rate
+            ReadLittleEndian(_inputFile, 4);  // byte rate
+            ReadLittleEndian(_inputFile, 2);  // frame size
+            bitDepth = ReadLittleEndian(_inputFile, 2);
+
+            if (format == 0xfffe && chunkSize >= 26)  // WAVE_FORMAT_EXTENSIBLE
+            {
+                _inputFile.seekg(chunkData + std::streamoff(24));
+                format = ReadLittleEndian(_inputFile, 2);  // sub-format
+            }
+        }
+        else if (!strcmp(chunkId, "data"))
+        {
+            _inputSampleType = DspSampleDecoder::GetSampleType(format, bitDepth);
+
+            if (_inputSampleType == DspSampleDecoder::Unsupported || _inputFileChannels == 0)
+            {
+                return false;
+            }
+
+            _inputFramesLeft = chunkSize / (_inputFileChannels * DspSampleDecoder::GetSampleSize(_inputSampleType));
+            return true;
+        }
+
+        _inputFile.seekg(chunkData + std::streamoff((chunkSize + 1) & ~1UL));  // chunks are WORD aligned
+    }
+
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspFileAudioBackend::_OpenOutput(int sampleRate)
+{
+    _outputFile.open(_outputPath.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!_outputFile.is_open())
+    {
+        return false;
+    }
+
+    _outputIsWave = IsWaveFile(_outputPath);
+    _outputSampleRate = sampleRate;
+    _outputFrameCount = 0;
+
+    if (_outputIsWave)
+    {
+        _WriteWaveHeader(sampleRate, 0);  // completed by Close_()
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspFileAudioBackend::_WriteWaveHeader(int sampleRate, unsigned long dataSize)
+{
+    int frameSize = _outputChannels * sizeof(float);
+
+    _outputFile.write("RIFF", 4);
+    WriteLittleEndian(_outputFile, 36 + dataSize, 4);
+    _outputFile.write("WAVE", 4);
+
+    _outputFile.write("fmt ", 4);
+    WriteLittleEndian(_outputFile, 16, 4);
+    WriteLittleEndian(_outputFile, 3, 2);  // float PCM
+    WriteLittleEndian(_outputFile, _outputChannels, 2);
+    WriteLittleEndian(_outputFile, sampleRate, 4);
+    WriteLittleEndian(_outputFile, sampleRate * frameSize, 4);
+    WriteLittleEndian(_outputFile, frameSize, 2);
+    WriteLittleEndian(_outputFile, 32, 2);
+
+    _outputFile.write("data", 4);
+    WriteLittleEndian(_outputFile, dataSize, 4);
+}
+
+//=================================================================================================
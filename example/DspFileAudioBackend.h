@@ -0,0 +1,88 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPFILEAUDIOBACKEND_H
+#define DSPFILEAUDIOBACKEND_H
+
+#include <DspNullAudioBackend.h>
+#include <DspSampleDecoder.h>
+
+#include <fstream>
+
+//=================================================================================================
+// Streams a single headless device from and to files, as fast as the circuit can process them.
+//
+// The device's input is read from "inputPath" and its output written to "outputPath" (either may
+// be empty). Files ending in ".wav" are WAV files: read as 8/16/24/32-bit integer or 32/64-bit
+// float PCM (see DspSampleDecoder), and written as 32-bit float. Any other file is raw,
+// interleaved 32-bit float samples, with as many channels as the device. Once the input runs out,
+// silence is fed in instead, and IsInputFinished() returns true.
+//
+// The stream is not real-time: the device waits for the circuit to process every buffer, hence
+// the stream runs exactly as fast as the circuit (E.g. for measuring throughput).
+
+class DspFileAudioBackend : public DspNullAudioBackend
+{
+public:
+    DspFileAudioBackend(std::string const& inputPath,
+                        std::string const& outputPath,
+                        int inputChannels = 2,
+                        int outputChannels = 2);
+    ~DspFileAudioBackend();
+
+    bool IsInputFinished() const;
+
+protected:
+    virtual bool Open_(int sampleRate);
+    virtual void Close_();
+    virtual void ReadInput_(float* inputBuffer, int bufferSize);
+    virtual void WriteOutput_(float const* outputBuffer, int bufferSize);
+
+private:
+    bool _OpenInput();
+    bool _OpenOutput(int sampleRate);
+    void _WriteWaveHeader(int sampleRate, unsigned long dataSize);
+
+    std::string _inputPath;
+    std::string _outputPath;
+    int _inputChannels;
+    int _outputChannels;
+
+    std::ifstream _inputFile;
+    int _inputFileChannels;
+    DspSampleDecoder::SampleType _inputSampleType;
+    unsigned long long _inputFramesLeft;
+    std::atomic<bool> _inputFinished;
+
+    std::ofstream _outputFile;
+    bool _outputIsWave;
+    int _outputSampleRate;
+    unsigned long long _outputFrameCount;
+
+    std::vector<char> _fileBuffer;
+};
+
+//=================================================================================================
+
+#endif  // DSPFILEAUDIOBACKEND_H
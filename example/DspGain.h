@@ -58,6 +58,25 @@ public:
 protected:
     virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs)
     {
+        // the input may also carry all channels of a stream in one DspPlanarBuffer
+        DspPlanarBuffer<float> const* channels = inputs.GetValue< DspPlanarBuffer<float> >(0);
+        if (channels != NULL)
+        {
+            _channels = *channels;
+
+            for (int i = 0; i < _channels.GetChannelCount(); i++)
+            {
+                float* channel = _channels.GetChannel(i);
+                for (int j = 0; j < _channels.GetFrameCount(); j++)
+                {
+                    channel[j] *= GetGain();
+                }
+            }
+
+            outputs.SetValue(0, _channels);
+            return;
+        }
+
         if (!inputs.GetValue(0, _stream))
         {
             _stream.assign(_stream.size(), 0);
@@ -81,8 +100,14 @@ protected:
         return false;
     }
 
+    virtual DspComponent* Clone_()
+    {
+        return new DspGain();
+    }
+
 private:
     std::vector<float> _stream;
+    DspPlanarBuffer<float> _channels;
 };
 
 //=================================================================================================
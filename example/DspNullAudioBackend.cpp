@@ -0,0 +1,270 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DspNullAudioBackend.h>
+
+#include <string.h>
+
+//=================================================================================================
+
+class DspNullAudioBackend::_Thread : public DspThread
+{
+public:
+    _Thread(DspNullAudioBackend* backend)
+        : _backend(backend)
+    {
+    }
+
+    ~_Thread()
+    {
+        Stop();
+    }
+
+private:
+    virtual void _Run()
+    {
+        _backend->_Run();
+    }
+
+    DspNullAudioBackend* _backend;
+};
+
+//=================================================================================================
+
+DspNullAudioBackend::DspNullAudioBackend(int inputChannels, int outputChannels)
+    : _deviceInfo("Null Device", inputChannels, outputChannels)
+    , _realTime(true)
+    , _sampleRate(0)
+    , _bufferSize(0)
+    , _callback(NULL)
+    , _userData(NULL)
+    , _thread(NULL)
+    , _bufferCount(0)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspNullAudioBackend::DspNullAudioBackend(DeviceInfo const& deviceInfo, bool realTime)
+    : _deviceInfo(deviceInfo)
+    , _realTime(realTime)
+    , _sampleRate(0)
+    , _bufferSize(0)
+    , _callback(NULL)
+    , _userData(NULL)
+    , _thread(NULL)
+    , _bufferCount(0)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspNullAudioBackend::~DspNullAudioBackend()
+{
+    CloseStream();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspNullAudioBackend::GetDeviceCount() const
+{
+    return 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspAudioBackend::DeviceInfo DspNullAudioBackend::GetDeviceInfo(int deviceIndex) const
+{
+    return deviceIndex == 0 ? _deviceInfo : DeviceInfo();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspNullAudioBackend::GetDefaultDevice() const
+{
+    return 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspNullAudioBackend::IsRealTime() const
+{
+    return _realTime;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspNullAudioBackend::OpenStream(int deviceIndex, int sampleRate, int& bufferSize, Callback_t callback, void* userData)
+{
+    CloseStream();
+
+    if (deviceIndex != 0 || sampleRate <= 0 || bufferSize <= 0 || callback == NULL)
+    {
+        return false;
+    }
+
+    _sampleRate = sampleRate;
+    _bufferSize = bufferSize;
+    _callback = callback;
+    _userData = userData;
+
+    _inputBuffer.assign(_deviceInfo.inputChannels * bufferSize, 0.0f);
+    _outputBuffer.assign(_deviceInfo.outputChannels * bufferSize, 0.0f);
+
+    if (!Open_(sampleRate))
+    {
+        return false;
+    }
+
+    _thread = new _Thread(this);
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspNullAudioBackend::StartStream()
+{
+    if (_thread == NULL)
+    {
+        return false;
+    }
+
+    _stop.Store(0);
+    _bufferCount.store(0, std::memory_order_relaxed);
+
+    // a real-time stream runs at the priority of an audio thread, a free-running one must not
+    _thread->Start(_realTime ? DspThread::TimeCriticalPriority : DspThread::NormalPriority);
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspNullAudioBackend::CloseStream()
+{
+    if (_thread != NULL)
+    {
+        _stop.Store(1);
+        _stop.WakeAll();
+
+        delete _thread;  // joins the thread
+        _thread = NULL;
+
+        Close_();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspNullAudioBackend::IsStreamOpen() const
+{
+    return _thread != NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspNullAudioBackend::GetBufferCount() const
+{
+    return _bufferCount.load(std::memory_order_relaxed);
+}
+
+//=================================================================================================
+
+bool DspNullAudioBackend::Open_(int)
+{
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspNullAudioBackend::Close_()
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspNullAudioBackend::ReadInput_(float* inputBuffer, int bufferSize)
+{
+    memset(inputBuffer, 0, _deviceInfo.inputChannels * bufferSize * sizeof(float));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspNullAudioBackend::WriteOutput_(float const*, int)
+{
+}
+
+//=================================================================================================
+
+void DspNullAudioBackend::_Run()
+{
+    float* inputBuffer = _inputBuffer.empty() ? NULL : &_inputBuffer[0];
+    float* outputBuffer = _outputBuffer.empty() ? NULL : &_outputBuffer[0];
+
+    unsigned long long startTime = DspThread::GetMonotonicTime();
+    unsigned long long bufferCount = 0;
+    unsigned int status = 0;
+
+    while (_stop.Load() == 0)
+    {
+        if (inputBuffer != NULL)
+        {
+            ReadInput_(inputBuffer, _bufferSize);
+        }
+
+        if (_callback(outputBuffer, inputBuffer, status, _userData) != 0)
+        {
+            break;
+        }
+
+        if (outputBuffer != NULL)
+        {
+            WriteOutput_(outputBuffer, _bufferSize);
+        }
+
+        _bufferCount.store(++bufferCount, std::memory_order_relaxed);
+        status = 0;
+
+        if (_realTime)
+        {
+            // the next buffer is due when the frames streamed so far have played out
+            unsigned long long frameCount = bufferCount * _bufferSize;
+            unsigned long long dueTime = startTime + frameCount * 1000000 / _sampleRate;
+            unsigned long long now = DspThread::GetMonotonicTime();
+
+            if (now > dueTime + (unsigned long long)_bufferSize * 1000000 / _sampleRate)
+            {
+                // a whole buffer period late: report an xrun and carry on from now
+                status = 1;
+                startTime = now - frameCount * 1000000 / _sampleRate;
+            }
+
+            while (_stop.Load() == 0 && DspThread::GetMonotonicTime() < dueTime)
+            {
+                _stop.WaitUntil(0, dueTime);
+            }
+        }
+    }
+}
+
+//=================================================================================================
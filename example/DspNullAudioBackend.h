@@ -0,0 +1,90 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPNULLAUDIOBACKEND_H
+#define DSPNULLAUDIOBACKEND_H
+
+#include <DspAudioBackend.h>
+
+#include <atomic>
+#include <vector>
+
+//=================================================================================================
+// Streams a single headless device on a software clock, for running circuits with no sound card.
+//
+// The stream's thread calls back every "bufferSize / sampleRate" seconds, at absolute times of the
+// monotonic clock (hence without drift), feeding silence in and discarding the output. A callback
+// that overruns its buffer period is reported as an xrun, like a sound card would. Derived
+// backends may override ReadInput_() and WriteOutput_() to source and sink the samples, and may
+// run free (calling back as fast as the circuit allows) rather than on the clock.
+
+class DspNullAudioBackend : public DspAudioBackend
+{
+public:
+    DspNullAudioBackend(int inputChannels = 2, int outputChannels = 2);
+    ~DspNullAudioBackend();
+
+    virtual int GetDeviceCount() const;
+    virtual DeviceInfo GetDeviceInfo(int deviceIndex) const;
+    virtual int GetDefaultDevice() const;
+    virtual bool IsRealTime() const;
+
+    virtual bool OpenStream(int deviceIndex, int sampleRate, int& bufferSize, Callback_t callback, void* userData);
+    virtual bool StartStream();
+    virtual void CloseStream();
+    virtual bool IsStreamOpen() const;
+
+    unsigned long GetBufferCount() const;
+
+protected:
+    DspNullAudioBackend(DeviceInfo const& deviceInfo, bool realTime);
+
+    virtual bool Open_(int sampleRate);
+    virtual void Close_();
+    virtual void ReadInput_(float* inputBuffer, int bufferSize);
+    virtual void WriteOutput_(float const* outputBuffer, int bufferSize);
+
+private:
+    class _Thread;
+
+    void _Run();
+
+    DeviceInfo _deviceInfo;
+    bool _realTime;
+
+    int _sampleRate;
+    int _bufferSize;
+    Callback_t _callback;
+    void* _userData;
+    std::vector<float> _inputBuffer;
+    std::vector<float> _outputBuffer;
+
+    _Thread* _thread;
+    DspFutex _stop;
+    std::atomic<unsigned long> _bufferCount;
+};
+
+//=================================================================================================
+
+#endif  // DSPNULLAUDIOBACKEND_H
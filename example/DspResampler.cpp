@@ -0,0 +1,611 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DspResampler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DSPRESAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+//=================================================================================================
+
+namespace
+{
+
+int const phaseCount = 256;     // fractional positions between input frames in the bank
+int const baseTapCount = 64;    // filter length when upsampling
+int const maxTapCount = 512;    // filter length limit when downsampling
+double const passband = 0.9;    // cutoff, relative to the lower rate's Nyquist frequency
+double const kaiserBeta = 8.0;  // window shape, ~80dB stopband attenuation
+double const maxRateAdjustment = 0.01;
+double const pi = 3.14159265358979323846;
+
+double BesselI0(double x)
+{
+    // power series of the zeroth order modified Bessel function of the first kind
+    double sum = 1.0, term = 1.0;
+
+    for (int k = 1; term > sum * 1e-12; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+// "tapCount" is a multiple of 8 and "kernel" is aligned (see DspPlanarBuffer), "samples" need not be
+
+void InterpolateKernel(float const* phase0, float const* phase1, float alpha, float* kernel, int tapCount)
+{
+#ifdef DSPRESAMPLER_SSE2
+    __m128 const weight = _mm_set1_ps(alpha);
+
+    for (int n = 0; n < tapCount; n += 4)
+    {
+        __m128 coefficients0 = _mm_load_ps(phase0 + n);
+        __m128 coefficients1 = _mm_load_ps(phase1 + n);
+
+        __m128 difference = _mm_sub_ps(coefficients1, coefficients0);
+        _mm_store_ps(kernel + n, _mm_add_ps(coefficients0, _mm_mul_ps(difference, weight)));
+    }
+#else
+    for (int n = 0; n < tapCount; n++)
+    {
+        kernel[n] = phase0[n] + (phase1[n] - phase0[n]) * alpha;
+    }
+#endif
+}
+
+float DotProduct(float const* samples, float const* kernel, int tapCount)
+{
+#ifdef DSPRESAMPLER_SSE2
+    // two accumulators, such that consecutive additions do not wait on one another
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+
+    for (int n = 0; n < tapCount; n += 8)
+    {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(samples + n), _mm_load_ps(kernel + n)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(samples + n + 4), _mm_load_ps(kernel + n + 4)));
+    }
+
+    __m128 sum = _mm_add_ps(sum0, sum1);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+
+    return _mm_cvtss_f32(sum);
+#else
+    float sum = 0.0f;
+
+    for (int n = 0; n < tapCount; n++)
+    {
+        sum += samples[n] * kernel[n];
+    }
+
+    return sum;
+#endif
+}
+
+}  // namespace
+
+//=================================================================================================
+// builds the banks requested by SetRates(), and deletes those swapped out, for all resamplers
+// (started with the first resampler constructed, and stopped with the last one destroyed)
+
+class DspResampler::_Builder : public DspThread
+{
+public:
+    static void Add(DspResampler* resampler)
+    {
+        _Builder& builder = _GetInstance();
+
+        builder._startMutex.Lock();
+
+        builder._mutex.Lock();
+        builder._resamplers.push_back(resampler);
+        builder._mutex.Unlock();
+
+        if (builder._resamplers.size() == 1)
+        {
+            builder._stop.store(false, std::memory_order_relaxed);
+            builder.Start(DspThread::NormalPriority);
+        }
+
+        builder._startMutex.Unlock();
+    }
+
+    static void Remove(DspResampler* resampler)
+    {
+        _Builder& builder = _GetInstance();
+
+        builder._startMutex.Lock();
+
+        // (waits for a bank being built meanwhile)
+        builder._mutex.Lock();
+        builder._resamplers.erase(std::find(builder._resamplers.begin(), builder._resamplers.end(), resampler));
+        builder._mutex.Unlock();
+
+        if (builder._resamplers.empty())
+        {
+            builder._stop.store(true, std::memory_order_relaxed);
+            Wake();
+
+            builder.Stop();  // joins the thread
+        }
+
+        builder._startMutex.Unlock();
+    }
+
+    // never blocks (called from audio threads)
+    static void Wake()
+    {
+        _Builder& builder = _GetInstance();
+
+        int wakeCount;
+        do
+        {
+            wakeCount = builder._wakeCount.Load();
+        } while (!builder._wakeCount.CompareExchange(wakeCount, wakeCount + 1));
+
+        builder._wakeCount.WakeAll();
+    }
+
+private:
+    _Builder()
+        : _stop(false)
+    {
+    }
+
+    static _Builder& _GetInstance()
+    {
+        static _Builder builder;
+        return builder;
+    }
+
+    virtual void _Run()
+    {
+        while (!_stop.load(std::memory_order_relaxed))
+        {
+            // read the counter before looking for requests, so that a request made in between is
+            // never missed
+            int wakeCount = _wakeCount.Load();
+
+            _mutex.Lock();
+
+            for (size_t i = 0; i < _resamplers.size(); i++)
+            {
+                DspResampler* resampler = _resamplers[i];
+
+                delete resampler->_retiredBank.exchange(NULL, std::memory_order_acquire);
+
+                double scale = resampler->_requestedScale.exchange(0.0, std::memory_order_acquire);
+                if (scale != 0.0)
+                {
+                    delete resampler->_builtBank.exchange(_BuildBank(scale), std::memory_order_acq_rel);
+                }
+            }
+
+            _mutex.Unlock();
+
+            _wakeCount.Wait(wakeCount);
+        }
+    }
+
+private:
+    std::vector<DspResampler*> _resamplers;
+    std::atomic<bool> _stop;
+    DspMutex _mutex;       // guards _resamplers
+    DspMutex _startMutex;  // serialises starting and stopping the thread
+    DspFutex _wakeCount;   // bumped by Wake()
+};
+
+//=================================================================================================
+
+DspResampler::DspResampler()
+    : _inputRate(44100)
+    , _outputRate(44100)
+    , _channelCount(0)
+    , _bank(_BuildBank(1.0))
+    , _tapCount(_bank->tapCount)
+    , _kernel(1, maxTapCount)
+    , _requestedScale(0.0)
+    , _builtBank(NULL)
+    , _retiredBank(NULL)
+    , _rateAdjustment(0.0)
+    , _step(1ULL << 32)
+    , _historyFrameCount(0)
+    , _position(0)
+{
+    Reset();
+
+    _Builder::Add(this);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspResampler::~DspResampler()
+{
+    _Builder::Remove(this);  // waits for a bank being built for this resampler
+
+    delete _bank;
+    delete _builtBank.load();
+    delete _retiredBank.load();
+}
+
+//=================================================================================================
+
+void DspResampler::SetRates(int inputRate, int outputRate)
+{
+    if (inputRate <= 0 || outputRate <= 0)
+    {
+        return;
+    }
+
+    if (inputRate == _inputRate && outputRate == _outputRate)
+    {
+        _SwapBank();
+        return;
+    }
+
+    _inputRate = inputRate;
+    _outputRate = outputRate;
+
+    _UpdateStep();
+    Reset();
+
+    // meanwhile, the bank in use filters the new rates (see _SwapBank())
+    double scale = _GetScale(inputRate, outputRate);
+
+    if (scale != _bank->scale)
+    {
+        _requestedScale.store(scale, std::memory_order_release);
+        _Builder::Wake();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspResampler::GetInputRate() const
+{
+    return _inputRate;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspResampler::GetOutputRate() const
+{
+    return _outputRate;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspResampler::SetRateAdjustment(double adjustment)
+{
+    // (large adjustments would call for a different filter, see _BuildBank())
+    _rateAdjustment = std::max(-maxRateAdjustment, std::min(adjustment, maxRateAdjustment));
+
+    _UpdateStep();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+double DspResampler::GetRateAdjustment() const
+{
+    return _rateAdjustment;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspResampler::SetChannelCount(int channelCount)
+{
+    if (channelCount < 0 || channelCount == _channelCount)
+    {
+        return;
+    }
+
+    _channelCount = channelCount;
+
+    Reset();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspResampler::GetChannelCount() const
+{
+    return _channelCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspResampler::Reset()
+{
+    // start with the filter's first half over silence, centred on the first frame to be written
+    int halfTapCount = _tapCount / 2;
+
+    _historyFrameCount = 0;
+    _ReserveHistory(halfTapCount - 1);
+
+    for (int i = 0; i < _channelCount; i++)
+    {
+        memset(_history.GetChannel(i), 0, (halfTapCount - 1) * sizeof(float));
+    }
+
+    _historyFrameCount = halfTapCount - 1;
+    _position = (unsigned long long)(halfTapCount - 1) << 32;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspResampler::GetReadableFrameCount() const
+{
+    // an output frame needs the input frames up to half the filter's length past its position
+    long long endFrame = (long long)_historyFrameCount - _tapCount / 2;
+    if (endFrame <= 0)
+    {
+        return 0;
+    }
+
+    unsigned long long endPosition = (unsigned long long)endFrame << 32;
+    if (_position >= endPosition)
+    {
+        return 0;
+    }
+
+    return (int)((endPosition - 1 - _position) / _step + 1);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspResampler::GetInputFrameCount(int outputFrameCount) const
+{
+    if (outputFrameCount <= 0)
+    {
+        return 0;
+    }
+
+    unsigned long long lastPosition = _position + (outputFrameCount - 1) * _step;
+    long long frameCount = (long long)(lastPosition >> 32) + _tapCount / 2 + 1 - _historyFrameCount;
+
+    return frameCount > 0 ? (int)frameCount : 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspResampler::Write(float const* channels, int channelStride, int frameCount)
+{
+    if (frameCount <= 0)
+    {
+        return;
+    }
+
+    _ReserveHistory(_historyFrameCount + frameCount);
+
+    for (int i = 0; i < _channelCount; i++)
+    {
+        memcpy(_history.GetChannel(i) + _historyFrameCount, channels + i * channelStride, frameCount * sizeof(float));
+    }
+
+    _historyFrameCount += frameCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspResampler::Read(float* channels, int channelStride, int frameCount)
+{
+    // frames past the input written so far are output as silence
+    int readCount = std::min(frameCount, GetReadableFrameCount());
+    int halfTapCount = _tapCount / 2;
+
+    for (int j = 0; j < readCount; j++, _position += _step)
+    {
+        int frame = (int)(_position >> 32);
+
+        // (after a rate adjustment the position may be left between two frames)
+        if (_step == 1ULL << 32 && (unsigned int)_position == 0)
+        {
+            for (int i = 0; i < _channelCount; i++)
+            {
+                channels[i * channelStride + j] = _history.GetChannel(i)[frame];
+            }
+            continue;
+        }
+
+        // interpolate the filter between the two phases either side of the fractional position
+        unsigned int fraction = (unsigned int)_position;
+        int phase = fraction >> 24;
+        float alpha = (fraction & 0xffffff) * (1.0f / 16777216.0f);
+
+        InterpolateKernel(_bank->coefficients.GetChannel(phase), _bank->coefficients.GetChannel(phase + 1), alpha, _kernel.GetChannel(0), _tapCount);
+
+        for (int i = 0; i < _channelCount; i++)
+        {
+            float const* samples = _history.GetChannel(i) + frame - halfTapCount + 1;
+            channels[i * channelStride + j] = DotProduct(samples, _kernel.GetChannel(0), _tapCount);
+        }
+    }
+
+    for (int i = 0; i < _channelCount; i++)
+    {
+        memset(channels + i * channelStride + readCount, 0, (frameCount - readCount) * sizeof(float));
+    }
+
+    // drop the input frames now out of the filter's reach
+    int dropCount = std::min((int)(_position >> 32) - halfTapCount + 1, _historyFrameCount);
+
+    if (dropCount > 0)
+    {
+        for (int i = 0; i < _channelCount; i++)
+        {
+            float* channel = _history.GetChannel(i);
+            memmove(channel, channel + dropCount, (_historyFrameCount - dropCount) * sizeof(float));
+        }
+
+        _historyFrameCount -= dropCount;
+        _position -= (unsigned long long)dropCount << 32;
+    }
+}
+
+//=================================================================================================
+
+double DspResampler::_GetScale(int inputRate, int outputRate)
+{
+    // when downsampling, the cutoff drops below the output's Nyquist frequency (see _BuildBank())
+    return std::min(1.0, (double)outputRate / inputRate);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspResampler::_Bank* DspResampler::_BuildBank(double scale)
+{
+    // the filter spans as many more input frames as the cutoff drops, to keep the same transition
+    // band relative to the output
+    _Bank* bank = new _Bank();
+    bank->scale = scale;
+    bank->tapCount = std::min(maxTapCount, (int)std::ceil(baseTapCount / scale / 8) * 8);
+
+    int tapCount = bank->tapCount;
+    double cutoff = passband * scale;
+    int halfTapCount = tapCount / 2;
+
+    // one more phase than the positions, such that the last position interpolates towards the
+    // next input frame
+    bank->coefficients.Resize(phaseCount + 1, tapCount);
+
+    for (int p = 0; p <= phaseCount; p++)
+    {
+        float* coefficients = bank->coefficients.GetChannel(p);
+        double sum = 0.0;
+
+        for (int n = 0; n < tapCount; n++)
+        {
+            // distance from the output frame to the input frame under this tap
+            double distance = n - (halfTapCount - 1) - (double)p / phaseCount;
+
+            double window = 0.0;
+            if (std::fabs(distance) < halfTapCount)
+            {
+                double x = distance / halfTapCount;
+                window = BesselI0(kaiserBeta * std::sqrt(1.0 - x * x)) / BesselI0(kaiserBeta);
+            }
+
+            double sinc = distance == 0.0 ? 1.0 : std::sin(pi * cutoff * distance) / (pi * cutoff * distance);
+
+            coefficients[n] = (float)(cutoff * sinc * window);
+            sum += coefficients[n];
+        }
+
+        // unity gain at DC for every phase
+        for (int n = 0; n < tapCount; n++)
+        {
+            coefficients[n] = (float)(coefficients[n] / sum);
+        }
+    }
+
+    return bank;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspResampler::_SwapBank()
+{
+    // the bank swapped out last must be deleted (by the builder thread) before the next swap
+    if (_builtBank.load(std::memory_order_relaxed) == NULL || _retiredBank.load(std::memory_order_relaxed) != NULL)
+    {
+        return;
+    }
+
+    _Bank* bank = _builtBank.exchange(NULL, std::memory_order_acq_rel);
+
+    if (bank->scale != _GetScale(_inputRate, _outputRate))
+    {
+        _retiredBank.store(bank, std::memory_order_release);  // built for rates set before
+        _Builder::Wake();
+        return;
+    }
+
+    // keep the input frames buffered: a longer filter reaches further back, into silence
+    int extraFrameCount = bank->tapCount / 2 - _tapCount / 2;
+
+    if (extraFrameCount > 0)
+    {
+        _ReserveHistory(_historyFrameCount + extraFrameCount);
+
+        for (int i = 0; i < _channelCount; i++)
+        {
+            float* channel = _history.GetChannel(i);
+            memmove(channel + extraFrameCount, channel, _historyFrameCount * sizeof(float));
+            memset(channel, 0, extraFrameCount * sizeof(float));
+        }
+
+        _historyFrameCount += extraFrameCount;
+        _position += (unsigned long long)extraFrameCount << 32;
+    }
+
+    _retiredBank.store(_bank, std::memory_order_release);
+    _Builder::Wake();
+
+    _bank = bank;
+    _tapCount = bank->tapCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspResampler::_UpdateStep()
+{
+    double step = (double)_inputRate / _outputRate * (1.0 + _rateAdjustment);
+
+    _step = (unsigned long long)(step * 4294967296.0 + 0.5);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspResampler::_ReserveHistory(int frameCount)
+{
+    if (_history.GetChannelCount() == _channelCount && _history.GetFrameCount() >= frameCount)
+    {
+        return;
+    }
+
+    // grow geometrically, keeping the frames written so far
+    int capacity = std::max(frameCount, _history.GetFrameCount() * 2);
+    DspPlanarBuffer<float> history(_channelCount, capacity);
+
+    if (_history.GetChannelCount() == _channelCount)
+    {
+        for (int i = 0; i < _channelCount; i++)
+        {
+            memcpy(history.GetChannel(i), _history.GetChannel(i), _historyFrameCount * sizeof(float));
+        }
+    }
+
+    _history = history;
+}
+
+//=================================================================================================
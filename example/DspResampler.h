@@ -0,0 +1,123 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPRESAMPLER_H
+#define DSPRESAMPLER_H
+
+#include <DSPatch.h>
+
+#include <atomic>
+
+//=================================================================================================
+// Converts planar multichannel audio from one sample rate to another, at any ratio.
+//
+// Each output frame is interpolated by a windowed-sinc filter, whose coefficients are taken from a
+// bank precomputed for a fixed number of fractional positions (phases) between input frames,
+// interpolating linearly between the two nearest phases. The bank is recomputed only when the
+// rates change, lowering the filter's cutoff below the output rate's Nyquist frequency when
+// downsampling (lengthening the filter accordingly). The filter loops use SSE2 where available.
+//
+// As SetRates() is called from audio threads, it does not compute the bank itself (which takes
+// milliseconds): a thread shared by all resamplers builds it, while the new rates take effect at
+// once, filtered with the bank in use until SetRates() finds the new one built and swaps it in
+// (hence SetRates() is to be called on every conversion, before GetInputFrameCount()). Upsampling
+// at any rates uses the same bank, which is built on construction.
+//
+// Input frames are appended with Write() and converted frames taken with Read(), in any amounts:
+// GetReadableFrameCount() returns how many frames Read() can take from the input written so far,
+// while GetInputFrameCount() returns how many more input frames must be written before Read() can
+// take a given number (E.g. to produce fixed-size output buffers from a source read on demand).
+// Output frame 0 is aligned with input frame 0, so the filter looks a few input frames ahead.
+//
+// SetRateAdjustment() speeds up or slows down the conversion by a small fraction, without
+// rebuilding the bank nor dropping the frames buffered (E.g. to track the drift between two
+// clocks of nominally the same rate).
+
+class DspResampler
+{
+public:
+    DspResampler();
+    ~DspResampler();
+
+    void SetRates(int inputRate, int outputRate);
+    int GetInputRate() const;
+    int GetOutputRate() const;
+
+    void SetRateAdjustment(double adjustment);  // input frames read per output frame, times 1 + adjustment
+    double GetRateAdjustment() const;
+
+    void SetChannelCount(int channelCount);
+    int GetChannelCount() const;
+
+    void Reset();
+
+    int GetReadableFrameCount() const;
+    int GetInputFrameCount(int outputFrameCount) const;
+
+    void Write(float const* channels, int channelStride, int frameCount);
+    void Read(float* channels, int channelStride, int frameCount);
+
+private:
+    DspResampler(DspResampler const&);
+    DspResampler& operator=(DspResampler const&);
+
+    class _Builder;
+
+    struct _Bank
+    {
+        double scale;                          // output rate / input rate, at most 1
+        int tapCount;                          // per phase, a multiple of 8
+        DspPlanarBuffer<float> coefficients;   // phase x tap
+    };
+
+    static double _GetScale(int inputRate, int outputRate);
+    static _Bank* _BuildBank(double scale);
+    void _SwapBank();
+    void _UpdateStep();
+    void _ReserveHistory(int frameCount);
+
+    int _inputRate;
+    int _outputRate;
+    int _channelCount;
+
+    _Bank* _bank;                      // in use
+    int _tapCount;                     // of the bank in use
+    DspPlanarBuffer<float> _kernel;    // coefficients for the current output frame
+
+    // the bank for the rates last set, built by the builder thread (see _Builder)
+    std::atomic<double> _requestedScale;  // 0: none requested
+    std::atomic<_Bank*> _builtBank;       // built, to be swapped in by SetRates()
+    std::atomic<_Bank*> _retiredBank;     // swapped out, to be deleted by the builder thread
+
+    double _rateAdjustment;
+    unsigned long long _step;          // input frames per output frame, in 32.32 fixed point
+
+    DspPlanarBuffer<float> _history;   // input frames written and still in the filter's reach
+    int _historyFrameCount;
+    unsigned long long _position;      // of the next output frame in _history, in 32.32 fixed point
+};
+
+//=================================================================================================
+
+#endif  // DSPRESAMPLER_H
@@ -0,0 +1,177 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DspRtAudioBackend.h>
+
+#include <RtAudio.h>
+
+//=================================================================================================
+
+struct RtAudioMembers
+{
+    RtAudio audioStream;
+    RtAudio::StreamParameters outputParams;
+    RtAudio::StreamParameters inputParams;
+};
+
+//=================================================================================================
+
+DspRtAudioBackend::DspRtAudioBackend()
+    : _rtAudio(new RtAudioMembers())
+    , _callback(NULL)
+    , _userData(NULL)
+{
+    for (unsigned int i = 0; i < _rtAudio->audioStream.getDeviceCount(); i++)
+    {
+        RtAudio::DeviceInfo deviceInfo = _rtAudio->audioStream.getDeviceInfo(i);
+        _deviceList.push_back(DeviceInfo(deviceInfo.name, deviceInfo.inputChannels, deviceInfo.outputChannels));
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspRtAudioBackend::~DspRtAudioBackend()
+{
+    CloseStream();
+
+    delete _rtAudio;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspRtAudioBackend::GetDeviceCount() const
+{
+    return _deviceList.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspAudioBackend::DeviceInfo DspRtAudioBackend::GetDeviceInfo(int deviceIndex) const
+{
+    if (deviceIndex >= 0 && deviceIndex < GetDeviceCount())
+    {
+        return _deviceList[deviceIndex];
+    }
+
+    return DeviceInfo();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspRtAudioBackend::GetDefaultDevice() const
+{
+    return _rtAudio->audioStream.getDefaultOutputDevice();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspRtAudioBackend::IsRealTime() const
+{
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspRtAudioBackend::OpenStream(int deviceIndex, int sampleRate, int& bufferSize, Callback_t callback, void* userData)
+{
+    CloseStream();
+
+    _callback = callback;
+    _userData = userData;
+
+    _rtAudio->inputParams.nChannels = GetDeviceInfo(deviceIndex).inputChannels;
+    _rtAudio->inputParams.deviceId = deviceIndex;
+
+    _rtAudio->outputParams.nChannels = GetDeviceInfo(deviceIndex).outputChannels;
+    _rtAudio->outputParams.deviceId = deviceIndex;
+
+    RtAudio::StreamParameters* inputParams = NULL;
+    RtAudio::StreamParameters* outputParams = NULL;
+
+    if (_rtAudio->inputParams.nChannels != 0)
+    {
+        inputParams = &_rtAudio->inputParams;
+    }
+
+    if (_rtAudio->outputParams.nChannels != 0)
+    {
+        outputParams = &_rtAudio->outputParams;
+    }
+
+    RtAudio::StreamOptions options;
+    options.flags |= RTAUDIO_SCHEDULE_REALTIME;
+    options.flags |= RTAUDIO_NONINTERLEAVED;
+
+    unsigned int bufferFrames = bufferSize;
+
+    _rtAudio->audioStream.openStream(outputParams,
+                                     inputParams,
+                                     RTAUDIO_FLOAT32,
+                                     sampleRate,
+                                     &bufferFrames,
+                                     &_StaticCallback,
+                                     this,
+                                     &options);
+
+    bufferSize = bufferFrames;
+
+    return _rtAudio->audioStream.isStreamOpen();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspRtAudioBackend::StartStream()
+{
+    _rtAudio->audioStream.startStream();
+
+    return _rtAudio->audioStream.isStreamRunning();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspRtAudioBackend::CloseStream()
+{
+    if (_rtAudio->audioStream.isStreamOpen())
+    {
+        _rtAudio->audioStream.closeStream();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspRtAudioBackend::IsStreamOpen() const
+{
+    return _rtAudio->audioStream.isStreamOpen();
+}
+
+//=================================================================================================
+
+int DspRtAudioBackend::_StaticCallback(
+    void* outputBuffer, void* inputBuffer, unsigned int, double, unsigned int status, void* userData)
+{
+    DspRtAudioBackend* backend = reinterpret_cast<DspRtAudioBackend*>(userData);
+    return backend->_callback(outputBuffer, inputBuffer, status, backend->_userData);
+}
+
+//=================================================================================================
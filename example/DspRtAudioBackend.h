@@ -0,0 +1,70 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPRTAUDIOBACKEND_H
+#define DSPRTAUDIOBACKEND_H
+
+#include <DspAudioBackend.h>
+
+#include <vector>
+
+struct RtAudioMembers;
+
+//=================================================================================================
+// Streams through the sound card(s) via RtAudio (the example program's DspAudioDevice backend).
+
+class DspRtAudioBackend : public DspAudioBackend
+{
+public:
+    DspRtAudioBackend();
+    ~DspRtAudioBackend();
+
+    virtual int GetDeviceCount() const;
+    virtual DeviceInfo GetDeviceInfo(int deviceIndex) const;
+    virtual int GetDefaultDevice() const;
+    virtual bool IsRealTime() const;
+
+    virtual bool OpenStream(int deviceIndex, int sampleRate, int& bufferSize, Callback_t callback, void* userData);
+    virtual bool StartStream();
+    virtual void CloseStream();
+    virtual bool IsStreamOpen() const;
+
+private:
+    std::vector<DeviceInfo> _deviceList;
+
+    RtAudioMembers* _rtAudio;
+    Callback_t _callback;
+    void* _userData;
+
+    static int _StaticCallback(void* outputBuffer,
+                               void* inputBuffer,
+                               unsigned int nBufferFrames,
+                               double streamTime,
+                               unsigned int status,
+                               void* userData);
+};
+
+//=================================================================================================
+
+#endif  // DSPRTAUDIOBACKEND_H
@@ -0,0 +1,299 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DspSampleCache.h>
+
+#include <sys/stat.h>
+
+//=================================================================================================
+
+DspSampleCache::Samples const* DspSampleCache::Acquire(std::string const& filePath)
+{
+    long long modifiedTime, fileSize;
+
+    if (!_GetFileStat(filePath, modifiedTime, fileSize))
+    {
+        return NULL;
+    }
+
+    DspSampleCache& cache = _GetInstance();
+    Samples const* samples = NULL;
+
+    cache._mutex.Lock();
+
+    std::map<std::string, _Entry*>::iterator it = cache._files.find(filePath);
+
+    if (it != cache._files.end())
+    {
+        _Entry* entry = it->second;
+
+        if (entry->modifiedTime == modifiedTime && entry->fileSize == fileSize)
+        {
+            entry->refCount++;
+            entry->lastUsed = ++cache._useCount;
+
+            samples = entry->samples;
+        }
+        else
+        {
+            cache._Uncache(entry);  // the file has changed since
+        }
+    }
+
+    cache._mutex.Unlock();
+
+    return samples;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspSampleCache::Samples const* DspSampleCache::Insert(std::string const& filePath, Samples* samples)
+{
+    long long modifiedTime, fileSize;
+
+    if (!_GetFileStat(filePath, modifiedTime, fileSize))
+    {
+        modifiedTime = fileSize = -1;  // never matched by Acquire()
+    }
+
+    DspSampleCache& cache = _GetInstance();
+
+    cache._mutex.Lock();
+
+    std::map<std::string, _Entry*>::iterator it = cache._files.find(filePath);
+
+    if (it != cache._files.end())
+    {
+        _Entry* entry = it->second;
+
+        // share the copy inserted meanwhile, unless ours is newer
+        if (entry->modifiedTime == modifiedTime && entry->fileSize == fileSize)
+        {
+            entry->refCount++;
+            entry->lastUsed = ++cache._useCount;
+
+            cache._mutex.Unlock();
+
+            delete samples;
+            return entry->samples;
+        }
+
+        cache._Uncache(entry);
+    }
+
+    _Entry* entry = new _Entry();
+    entry->filePath = filePath;
+    entry->modifiedTime = modifiedTime;
+    entry->fileSize = fileSize;
+    entry->samples = samples;
+    entry->refCount = 1;
+    entry->lastUsed = ++cache._useCount;
+    entry->isCached = true;
+
+    cache._files[filePath] = entry;
+    cache._entries[samples] = entry;
+    cache._size += samples->data.size();
+
+    cache._Evict();
+
+    cache._mutex.Unlock();
+
+    return samples;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspSampleCache::Release(Samples const* samples)
+{
+    if (samples == NULL)
+    {
+        return;
+    }
+
+    DspSampleCache& cache = _GetInstance();
+
+    cache._mutex.Lock();
+
+    std::map<Samples const*, _Entry*>::iterator it = cache._entries.find(samples);
+
+    if (it != cache._entries.end() && --it->second->refCount == 0)
+    {
+        _Entry* entry = it->second;
+
+        if (entry->isCached)
+        {
+            cache._Evict();  // kept for reuse, unless over budget
+        }
+        else
+        {
+            cache._entries.erase(it);
+            delete entry->samples;
+            delete entry;
+        }
+    }
+
+    cache._mutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspSampleCache::SetBudget(unsigned long long budget)
+{
+    DspSampleCache& cache = _GetInstance();
+
+    cache._mutex.Lock();
+
+    cache._budget = budget;
+    cache._Evict();
+
+    cache._mutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long long DspSampleCache::GetBudget()
+{
+    DspSampleCache& cache = _GetInstance();
+
+    cache._mutex.Lock();
+    unsigned long long budget = cache._budget;
+    cache._mutex.Unlock();
+
+    return budget;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long long DspSampleCache::GetSize()
+{
+    DspSampleCache& cache = _GetInstance();
+
+    cache._mutex.Lock();
+    unsigned long long size = cache._size;
+    cache._mutex.Unlock();
+
+    return size;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspSampleCache::GetFileCount()
+{
+    DspSampleCache& cache = _GetInstance();
+
+    cache._mutex.Lock();
+    int fileCount = cache._files.size();
+    cache._mutex.Unlock();
+
+    return fileCount;
+}
+
+//=================================================================================================
+
+DspSampleCache::DspSampleCache()
+    : _budget(256 * 1024 * 1024)
+    , _size(0)
+    , _useCount(0)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspSampleCache::~DspSampleCache()
+{
+    for (std::map<Samples const*, _Entry*>::iterator it = _entries.begin(); it != _entries.end(); ++it)
+    {
+        delete it->second->samples;
+        delete it->second;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspSampleCache& DspSampleCache::_GetInstance()
+{
+    static DspSampleCache cache;
+    return cache;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspSampleCache::_GetFileStat(std::string const& filePath, long long& modifiedTime, long long& fileSize)
+{
+    struct stat fileStat;
+
+    if (stat(filePath.c_str(), &fileStat) != 0)
+    {
+        return false;
+    }
+
+    modifiedTime = fileStat.st_mtime;
+    fileSize = fileStat.st_size;
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspSampleCache::_Uncache(_Entry* entry)
+{
+    // drop the entry from the cache, its samples are deleted once no longer referenced
+    _files.erase(entry->filePath);
+    _size -= entry->samples->data.size();
+    entry->isCached = false;
+
+    if (entry->refCount == 0)
+    {
+        _entries.erase(entry->samples);
+        delete entry->samples;
+        delete entry;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspSampleCache::_Evict()
+{
+    // evict the least recently used samples no longer referenced, until back within budget
+    while (_size > _budget)
+    {
+        _Entry* lruEntry = NULL;
+
+        for (std::map<std::string, _Entry*>::iterator it = _files.begin(); it != _files.end(); ++it)
+        {
+            if (it->second->refCount == 0 && (lruEntry == NULL || it->second->lastUsed < lruEntry->lastUsed))
+            {
+                lruEntry = it->second;
+            }
+        }
+
+        if (lruEntry == NULL)
+        {
+            break;  // all in use
+        }
+
+        _Uncache(lruEntry);
+    }
+}
+
+//=================================================================================================
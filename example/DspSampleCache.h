@@ -0,0 +1,106 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPSAMPLECACHE_H
+#define DSPSAMPLECACHE_H
+
+#include <DSPatch.h>
+
+#include <map>
+#include <string>
+
+//=================================================================================================
+// Process-wide cache of audio file samples, shared between the components playing them.
+//
+// Acquire() returns the samples of a file loaded before (by any component), or NULL when the file
+// has not been loaded, or has been modified since (files are keyed by path, modification time and
+// size). On NULL, the caller loads the file itself and hands the samples to Insert(), which returns
+// the cached copy to use instead (another caller may have inserted the same file meanwhile). The
+// samples returned are read-only and reference counted: each must be handed back to Release()
+// once no longer played.
+//
+// Samples no longer referenced stay cached, such that reloading a file is instant, until the
+// cache's size exceeds its budget (see SetBudget()). The least recently used of them are then
+// evicted. Samples still referenced are never evicted, even when over budget.
+//
+// Samples are cached as stored in the file rather than decoded to floats, which would double the
+// memory a 16-bit file takes (quadruple an 8-bit one's). DspSampleDecoder decodes them into the
+// output channels as they are played instead, in a single pass at about the cost of copying out
+// decoded floats, and the same way it decodes the blocks read from a file streamed from disk.
+
+class DspSampleCache
+{
+public:
+    struct Samples
+    {
+        unsigned short format;        // 1: integer PCM, 3: float PCM
+        unsigned short channelCount;  // Number of audio channels
+        unsigned long sampleRate;     // Audio sample rate
+        unsigned short frameSize;     // Size in bytes of a sample block (all channels)
+        unsigned short bitDepth;      // Size in bits of a single per-channel sample
+        std::vector<char> data;       // Interleaved sample blocks, as stored in the file (undecoded)
+    };
+
+    static Samples const* Acquire(std::string const& filePath);
+    static Samples const* Insert(std::string const& filePath, Samples* samples);
+    static void Release(Samples const* samples);
+
+    static void SetBudget(unsigned long long budget);
+    static unsigned long long GetBudget();
+
+    static unsigned long long GetSize();
+    static int GetFileCount();
+
+private:
+    struct _Entry
+    {
+        std::string filePath;
+        long long modifiedTime;
+        long long fileSize;
+        Samples* samples;
+        int refCount;
+        unsigned long lastUsed;
+        bool isCached;  // false once replaced by a newer version of the file
+    };
+
+    DspSampleCache();
+    ~DspSampleCache();
+
+    static DspSampleCache& _GetInstance();
+    static bool _GetFileStat(std::string const& filePath, long long& modifiedTime, long long& fileSize);
+
+    void _Uncache(_Entry* entry);
+    void _Evict();
+
+    std::map<std::string, _Entry*> _files;
+    std::map<Samples const*, _Entry*> _entries;
+    unsigned long long _budget;
+    unsigned long long _size;
+    unsigned long _useCount;
+    DspMutex _mutex;
+};
+
+//=================================================================================================
+
+#endif  // DSPSAMPLECACHE_H
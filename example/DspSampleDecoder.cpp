@@ -0,0 +1,383 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DspSampleDecoder.h>
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DSPSAMPLEDECODER_SSE2
+#include <emmintrin.h>
+#endif
+
+//=================================================================================================
+
+namespace
+{
+
+// per-sample conversions (little endian, any alignment)
+
+inline float ConvertInt8(unsigned char const* sample)
+{
+    return (sample[0] - 128) * (1.0f / 128.0f);  // 8-bit WAV samples are unsigned
+}
+
+inline float ConvertInt16(unsigned char const* sample)
+{
+    return (short)(sample[0] | (sample[1] << 8)) * (1.0f / 32768.0f);
+}
+
+inline float ConvertInt24(unsigned char const* sample)
+{
+    int value = (int)((sample[0] << 8) | (sample[1] << 16) | ((unsigned)sample[2] << 24));
+    return (value >> 8) * (1.0f / 8388608.0f);
+}
+
+inline float ConvertInt32(unsigned char const* sample)
+{
+    int value = (int)(sample[0] | (sample[1] << 8) | (sample[2] << 16) | ((unsigned)sample[3] << 24));
+    return value * (1.0f / 2147483648.0f);
+}
+
+inline float ConvertFloat32(unsigned char const* sample)
+{
+    float value;
+    memcpy(&value, sample, sizeof(float));
+    return value;
+}
+
+inline float ConvertFloat64(unsigned char const* sample)
+{
+    double value;
+    memcpy(&value, sample, sizeof(double));
+    return (float)value;
+}
+
+// deinterleaves and converts frames from "frame" on, one channel at a time
+
+template <float (*Convert)(unsigned char const*), int SampleSize>
+void DecodeScalar(unsigned char const* frames,
+                  int frameChannelCount,
+                  int frame,
+                  int frameCount,
+                  float* channels,
+                  int channelStride,
+                  int channelCount)
+{
+    int frameSize = SampleSize * frameChannelCount;
+
+    for (int i = 0; i < channelCount; i++)
+    {
+        float* channel = channels + i * channelStride;
+        unsigned char const* sample = frames + frame * frameSize + i * SampleSize;
+
+        for (int j = frame; j < frameCount; j++, sample += frameSize)
+        {
+            channel[j] = Convert(sample);
+        }
+    }
+}
+
+#ifdef DSPSAMPLEDECODER_SSE2
+
+// the SSE2 kernels below decode whole groups of 4 or 8 frames, returning how many frames were
+// decoded (the rest are left to DecodeScalar())
+
+int DecodeInt16Mono(unsigned char const* frames, int frameCount, float* channel)
+{
+    __m128 const scale = _mm_set1_ps(1.0f / 32768.0f);
+
+    int j = 0;
+    for (; j + 8 <= frameCount; j += 8)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<__m128i const*>(frames + j * 2));
+
+        // duplicating each 16-bit sample into a 32-bit lane, then shifting down, sign-extends it
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+
+        _mm_storeu_ps(channel + j, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(channel + j + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+
+    return j;
+}
+
+int DecodeInt16Stereo(unsigned char const* frames, int frameCount, float* left, float* right)
+{
+    __m128 const scale = _mm_set1_ps(1.0f / 32768.0f);
+
+    int j = 0;
+    for (; j + 8 <= frameCount; j += 8)
+    {
+        // each 32-bit lane holds a frame: the left sample in its low half, the right in its high
+        __m128i frames0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(frames + j * 4));
+        __m128i frames1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(frames + j * 4 + 16));
+
+        __m128i left0 = _mm_srai_epi32(_mm_slli_epi32(frames0, 16), 16);
+        __m128i left1 = _mm_srai_epi32(_mm_slli_epi32(frames1, 16), 16);
+        __m128i right0 = _mm_srai_epi32(frames0, 16);
+        __m128i right1 = _mm_srai_epi32(frames1, 16);
+
+        _mm_storeu_ps(left + j, _mm_mul_ps(_mm_cvtepi32_ps(left0), scale));
+        _mm_storeu_ps(left + j + 4, _mm_mul_ps(_mm_cvtepi32_ps(left1), scale));
+        _mm_storeu_ps(right + j, _mm_mul_ps(_mm_cvtepi32_ps(right0), scale));
+        _mm_storeu_ps(right + j + 4, _mm_mul_ps(_mm_cvtepi32_ps(right1), scale));
+    }
+
+    return j;
+}
+
+int DecodeInt24(unsigned char const* frames,
+                int frameChannelCount,
+                int frameCount,
+                float* channels,
+                int channelStride,
+                int channelCount)
+{
+    __m128 const scale = _mm_set1_ps(1.0f / 2147483648.0f);
+    int frameSize = 3 * frameChannelCount;
+
+    // each sample is read as a 32-bit word, taking along the next sample's first byte (hence the
+    // last frame is left to DecodeScalar(), so as not to read past the frames)
+    int j = 0;
+    for (; j + 5 <= frameCount; j += 4)
+    {
+        unsigned char const* sample = frames + j * frameSize;
+
+        for (int i = 0; i < channelCount; i++, sample += 3)
+        {
+            int words[4];
+            memcpy(&words[0], sample, 4);
+            memcpy(&words[1], sample + frameSize, 4);
+            memcpy(&words[2], sample + 2 * frameSize, 4);
+            memcpy(&words[3], sample + 3 * frameSize, 4);
+
+            // shifting the 24-bit samples to the top of the words drops the extra bytes
+            __m128i samples = _mm_slli_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(words)), 8);
+            _mm_storeu_ps(channels + i * channelStride + j, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+        }
+    }
+
+    return j;
+}
+
+int DecodeInt32Mono(unsigned char const* frames, int frameCount, float* channel)
+{
+    __m128 const scale = _mm_set1_ps(1.0f / 2147483648.0f);
+
+    int j = 0;
+    for (; j + 4 <= frameCount; j += 4)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<__m128i const*>(frames + j * 4));
+        _mm_storeu_ps(channel + j, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+    }
+
+    return j;
+}
+
+int DecodeInt32Stereo(unsigned char const* frames, int frameCount, float* left, float* right)
+{
+    __m128 const scale = _mm_set1_ps(1.0f / 2147483648.0f);
+
+    int j = 0;
+    for (; j + 4 <= frameCount; j += 4)
+    {
+        // shuffle the even (left) and odd (right) samples of 4 frames apart as raw bits
+        __m128 frames0 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<__m128i const*>(frames + j * 8)));
+        __m128 frames1 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<__m128i const*>(frames + j * 8 + 16)));
+
+        __m128i leftSamples = _mm_castps_si128(_mm_shuffle_ps(frames0, frames1, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i rightSamples = _mm_castps_si128(_mm_shuffle_ps(frames0, frames1, _MM_SHUFFLE(3, 1, 3, 1)));
+
+        _mm_storeu_ps(left + j, _mm_mul_ps(_mm_cvtepi32_ps(leftSamples), scale));
+        _mm_storeu_ps(right + j, _mm_mul_ps(_mm_cvtepi32_ps(rightSamples), scale));
+    }
+
+    return j;
+}
+
+int DecodeFloat32Stereo(unsigned char const* frames, int frameCount, float* left, float* right)
+{
+    int j = 0;
+    for (; j + 4 <= frameCount; j += 4)
+    {
+        __m128 frames0 = _mm_loadu_ps(reinterpret_cast<float const*>(frames + j * 8));
+        __m128 frames1 = _mm_loadu_ps(reinterpret_cast<float const*>(frames + j * 8 + 16));
+
+        _mm_storeu_ps(left + j, _mm_shuffle_ps(frames0, frames1, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + j, _mm_shuffle_ps(frames0, frames1, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    return j;
+}
+
+#endif  // DSPSAMPLEDECODER_SSE2
+
+}  // namespace
+
+//=================================================================================================
+
+DspSampleDecoder::SampleType DspSampleDecoder::GetSampleType(int format, int bitDepth)
+{
+    if (format == 1)
+    {
+        switch (bitDepth)
+        {
+            case 8:
+                return Int8;
+            case 16:
+                return Int16;
+            case 24:
+                return Int24;
+            case 32:
+                return Int32;
+        }
+    }
+    else if (format == 3)
+    {
+        switch (bitDepth)
+        {
+            case 32:
+                return Float32;
+            case 64:
+                return Float64;
+        }
+    }
+
+    return Unsupported;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspSampleDecoder::GetSampleSize(SampleType sampleType)
+{
+    switch (sampleType)
+    {
+        case Int8:
+            return 1;
+        case Int16:
+            return 2;
+        case Int24:
+            return 3;
+        case Int32:
+        case Float32:
+            return 4;
+        case Float64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspSampleDecoder::Decode(SampleType sampleType,
+                              int frameChannelCount,
+                              char const* frames,
+                              int frameCount,
+                              float* channels,
+                              int channelStride,
+                              int channelCount)
+{
+    unsigned char const* samples = reinterpret_cast<unsigned char const*>(frames);
+    channelCount = std::min(channelCount, frameChannelCount);
+
+    if (channelCount <= 0 || frameCount <= 0)
+    {
+        return;
+    }
+
+    // decode as many frames as possible with a SIMD kernel, then the rest one sample at a time
+    int frame = 0;
+
+#ifdef DSPSAMPLEDECODER_SSE2
+    float* left = channels;
+    float* right = channels + channelStride;
+
+    if (sampleType == Int24)
+    {
+        frame = DecodeInt24(samples, frameChannelCount, frameCount, channels, channelStride, channelCount);
+    }
+    else if (frameChannelCount == 1)
+    {
+        if (sampleType == Int16)
+        {
+            frame = DecodeInt16Mono(samples, frameCount, left);
+        }
+        else if (sampleType == Int32)
+        {
+            frame = DecodeInt32Mono(samples, frameCount, left);
+        }
+    }
+    else if (frameChannelCount == 2 && channelCount == 2)
+    {
+        if (sampleType == Int16)
+        {
+            frame = DecodeInt16Stereo(samples, frameCount, left, right);
+        }
+        else if (sampleType == Int32)
+        {
+            frame = DecodeInt32Stereo(samples, frameCount, left, right);
+        }
+        else if (sampleType == Float32)
+        {
+            frame = DecodeFloat32Stereo(samples, frameCount, left, right);
+        }
+    }
+#endif
+
+    if (sampleType == Float32 && frameChannelCount == 1)
+    {
+        memcpy(channels, samples, frameCount * sizeof(float));  // already planar
+        return;
+    }
+
+    switch (sampleType)
+    {
+        case Int8:
+            DecodeScalar<ConvertInt8, 1>(samples, frameChannelCount, frame, frameCount, channels, channelStride, channelCount);
+            break;
+        case Int16:
+            DecodeScalar<ConvertInt16, 2>(samples, frameChannelCount, frame, frameCount, channels, channelStride, channelCount);
+            break;
+        case Int24:
+            DecodeScalar<ConvertInt24, 3>(samples, frameChannelCount, frame, frameCount, channels, channelStride, channelCount);
+            break;
+        case Int32:
+            DecodeScalar<ConvertInt32, 4>(samples, frameChannelCount, frame, frameCount, channels, channelStride, channelCount);
+            break;
+        case Float32:
+            DecodeScalar<ConvertFloat32, 4>(samples, frameChannelCount, frame, frameCount, channels, channelStride, channelCount);
+            break;
+        case Float64:
+            DecodeScalar<ConvertFloat64, 8>(samples, frameChannelCount, frame, frameCount, channels, channelStride, channelCount);
+            break;
+        default:
+            break;
+    }
+}
+
+//=================================================================================================
@@ -0,0 +1,71 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPSAMPLEDECODER_H
+#define DSPSAMPLEDECODER_H
+
+//=================================================================================================
+// Converts interleaved audio file frames (as stored in a WAV file's data chunk) into planar float
+// channels.
+//
+// GetSampleType() maps a WAV format tag (1: integer PCM, 3: float PCM, or WAVE_FORMAT_EXTENSIBLE's
+// sub-format) and bit depth to one of the supported sample types: 8/16/24/32-bit integer and
+// 32/64-bit float. Decode() then deinterleaves and converts a run of frames straight into planar
+// channels in one pass. Integer samples are scaled to [-1, 1) (8-bit samples are unsigned).
+//
+// Where SSE2 is available, mono and stereo 16-bit, 32-bit integer and 32-bit float frames, as well
+// as 24-bit frames of any channel count, are decoded by SIMD kernels a few frames at a time. Other
+// formats and channel counts fall back to scalar loops.
+
+class DspSampleDecoder
+{
+public:
+    enum SampleType
+    {
+        Unsupported,
+        Int8,
+        Int16,
+        Int24,
+        Int32,
+        Float32,
+        Float64
+    };
+
+    static SampleType GetSampleType(int format, int bitDepth);
+    static int GetSampleSize(SampleType sampleType);  // in bytes
+
+    // decodes "frameCount" frames of "frameChannelCount" channels into "channelCount" channels,
+    // "channelStride" floats apart from "channels" (channels the frames lack are left untouched)
+    static void Decode(SampleType sampleType,
+                       int frameChannelCount,
+                       char const* frames,
+                       int frameCount,
+                       float* channels,
+                       int channelStride,
+                       int channelCount);
+};
+
+//=================================================================================================
+
+#endif  // DSPSAMPLEDECODER_H
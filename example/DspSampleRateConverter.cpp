@@ -0,0 +1,143 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DspSampleRateConverter.h>
+
+//=================================================================================================
+
+DspSampleRateConverter::DspSampleRateConverter(int sampleRate)
+    : _inputSampleRate(0)
+{
+    AddInput_();
+    AddInput_("Sample Rate");
+
+    AddOutput_();
+    AddOutput_("Sample Rate");
+
+    pSampleRate = AddParameter_("sampleRate", DspParameter(DspParameter::Int, sampleRate));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspSampleRateConverter::~DspSampleRateConverter()
+{
+}
+
+//=================================================================================================
+
+void DspSampleRateConverter::SetSampleRate(int sampleRate)
+{
+    if (sampleRate > 0)
+    {
+        SetParameter_(pSampleRate, DspParameter(DspParameter::Int, sampleRate));
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspSampleRateConverter::GetSampleRate() const
+{
+    return *GetParameter_(pSampleRate)->GetInt();
+}
+
+//=================================================================================================
+
+void DspSampleRateConverter::Process_(DspSignalBus& inputs, DspSignalBus& outputs)
+{
+    int sampleRate;
+    if (inputs.GetValue("Sample Rate", sampleRate))
+    {
+        _inputSampleRate = sampleRate;
+    }
+
+    outputs.SetValue("Sample Rate", GetSampleRate());
+
+    DspPlanarBuffer<float> const* channels = inputs.GetValue< DspPlanarBuffer<float> >(0);
+    std::vector<float> const* stream = inputs.GetValue< std::vector<float> >(0);
+
+    if (channels == NULL && stream == NULL)
+    {
+        outputs.ClearValue(0);
+        return;
+    }
+
+    if (_inputSampleRate <= 0 || _inputSampleRate == GetSampleRate())
+    {
+        _resampler.Reset();  // such that a later conversion does not resume from stale frames
+
+        outputs.SetSignal(0, inputs.GetSignal(0));
+        return;
+    }
+
+    _resampler.SetRates(_inputSampleRate, GetSampleRate());
+
+    if (channels != NULL)
+    {
+        _resampler.SetChannelCount(channels->GetChannelCount());
+        _resampler.Write(channels->GetChannel(0), channels->GetChannelStride(), channels->GetFrameCount());
+
+        _channels.Resize(channels->GetChannelCount(), _resampler.GetReadableFrameCount());
+        _resampler.Read(_channels.GetChannel(0), _channels.GetChannelStride(), _channels.GetFrameCount());
+
+        outputs.SetValue(0, _channels);
+    }
+    else
+    {
+        _resampler.SetChannelCount(1);
+        if (!stream->empty())
+        {
+            _resampler.Write(&(*stream)[0], 0, stream->size());
+        }
+
+        _stream.resize(_resampler.GetReadableFrameCount());
+        if (!_stream.empty())
+        {
+            _resampler.Read(&_stream[0], 0, _stream.size());
+        }
+
+        outputs.SetValue(0, _stream);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspSampleRateConverter::ParameterUpdating_(int index, DspParameter const& param)
+{
+    if (index == pSampleRate)
+    {
+        SetSampleRate(*param.GetInt());
+        return *param.GetInt() > 0;
+    }
+
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspComponent* DspSampleRateConverter::Clone_()
+{
+    return new DspSampleRateConverter(GetSampleRate());
+}
+
+//=================================================================================================
@@ -0,0 +1,68 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPSAMPLERATECONVERTER_H
+#define DSPSAMPLERATECONVERTER_H
+
+#include <DspResampler.h>
+
+//=================================================================================================
+// Converts a stream from the rate fed into its "Sample Rate" input to the rate set (see
+// SetSampleRate()), which its "Sample Rate" output carries on.
+//
+// Input 0 takes either a single channel (std::vector<float>) or all channels of a stream (a
+// DspPlanarBuffer<float>), output 0 then carries the converted frames of the same type. As the
+// rates differ, so do the input and output buffer sizes: each output buffer holds as many frames
+// as have been converted so far, hence its size varies by a frame from one tick to the next.
+// Components that need fixed-size buffers convert their input themselves instead (see
+// DspWaveStreamer::SetSampleRate() and DspAudioDevice::SetResampling()). Until a rate is fed in,
+// or while the rates match, the input is passed through as is.
+
+class DspSampleRateConverter : public DspComponent
+{
+public:
+    int pSampleRate;  // Int
+
+    DspSampleRateConverter(int sampleRate = 44100);
+    ~DspSampleRateConverter();
+
+    void SetSampleRate(int sampleRate);
+    int GetSampleRate() const;
+
+protected:
+    virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs);
+    virtual bool ParameterUpdating_(int index, DspParameter const& param);
+    virtual DspComponent* Clone_();
+
+private:
+    DspResampler _resampler;
+    int _inputSampleRate;
+
+    DspPlanarBuffer<float> _channels;
+    std::vector<float> _stream;
+};
+
+//=================================================================================================
+
+#endif  // DSPSAMPLERATECONVERTER_H
@@ -24,38 +24,83 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 
 #include <DspWaveStreamer.h>
 
-#include <fstream>
+#include <algorithm>
 #include <iostream>
+#include <stdint.h>
 #include <string.h>
 
 //=================================================================================================
 
+static int const blockFrames = 4096;  // frames read per block in streaming mode
+static int const blockCount = 8;      // blocks read ahead in streaming mode
+
+//=================================================================================================
+
+class DspWaveStreamer::_Reader : public DspThread
+{
+public:
+    _Reader(DspWaveStreamer* waveStreamer)
+        : _waveStreamer(waveStreamer)
+    {
+    }
+
+    ~_Reader()
+    {
+        Stop();
+    }
+
+private:
+    virtual void _Run()
+    {
+        _waveStreamer->_RunReader();
+    }
+
+    DspWaveStreamer* _waveStreamer;
+};
+
+//=================================================================================================
+
 DspWaveStreamer::DspWaveStreamer()
-    : _waveData(0)
+    : _sampleType(DspSampleDecoder::Unsupported)
+    , _samples(NULL)
     , _bufferSize(256)
-    , _sampleIndex(0)
-    , _shortToFloatCoeff(1.0f / 32767.0f)
+    , _frameIndex(0)
+    , _busyMutex(DspMutex::PriorityInherit)  // held by LoadFile() in control threads
+    , _dataOffset(0)
+    , _dataSize(0)
+    , _reader(NULL)
+    , _blockRing(blockCount)
+    , _blockOffset(0)
+    , _generation(0)
+    , _stopReader(false)
+    , _underrunCount(0)
 {
     _waveFormat.Clear();
 
-    _leftChannel.resize(_bufferSize);
-    _rightChannel.resize(_bufferSize);
+    _channels.Resize(2, _bufferSize);
 
     AddOutput_();
     AddOutput_();
     AddOutput_("Sample Rate");
+    AddOutput_("Channels");  // all channels as a single DspPlanarBuffer<float>
 
     pFilePath = AddParameter_("filePath", DspParameter(DspParameter::FilePath, ""));
     pPlay = AddParameter_("play", DspParameter(DspParameter::Trigger));
     pPause = AddParameter_("pause", DspParameter(DspParameter::Trigger));
     pStop = AddParameter_("stop", DspParameter(DspParameter::Trigger));
     pIsPlaying = AddParameter_("isPlaying", DspParameter(DspParameter::Bool, false));
+    pStreaming = AddParameter_("streaming", DspParameter(DspParameter::Bool, false));
+    pSampleRate = AddParameter_("sampleRate", DspParameter(DspParameter::Int, 0));
+    pChannelOutputs = AddParameter_("channelOutputs", DspParameter(DspParameter::Bool, false));
 }
 
 //-------------------------------------------------------------------------------------------------
 
 DspWaveStreamer::~DspWaveStreamer()
 {
+    _StopReader();
+
+    DspSampleCache::Release(_samples);
 }
 
 //=================================================================================================
@@ -70,13 +115,351 @@ bool DspWaveStreamer::LoadFile(char const* filePath)
         return false;
     }
 
-    std::ifstream inFile(filePath, std::ios::binary | std::ios::in);
-    if (inFile.bad())
+    bool streaming = IsStreaming();
+
+    WaveFormat waveFormat;
+    std::streamoff dataOffset = 0;
+    unsigned long long dataSize = 0;
+
+    // in memory, a file loaded before (by any DspWaveStreamer) is shared rather than read again
+    DspSampleCache::Samples const* samples = streaming ? NULL : DspSampleCache::Acquire(filePath);
+
+    if (samples != NULL)
     {
-        return false;
+        waveFormat.Clear();
+        waveFormat.format = samples->format;
+        waveFormat.channelCount = samples->channelCount;
+        waveFormat.sampleRate = samples->sampleRate;
+        waveFormat.frameSize = samples->frameSize;
+        waveFormat.bitDepth = samples->bitDepth;
     }
+    else
+    {
+        std::ifstream inFile(filePath, std::ios::binary | std::ios::in);
+        if (inFile.bad())
+        {
+            return false;
+        }
 
-    int dwFileSize = 0, dwChunkSize = 0;
+        if (!_ReadHeader(inFile, filePath, waveFormat, dataOffset, dataSize))
+        {
+            inFile.close();
+            return false;
+        }
+
+        // in streaming mode, the reader reads the samples as they are played instead
+        if (!streaming)
+        {
+            DspSampleCache::Samples* newSamples = new DspSampleCache::Samples();
+            newSamples->format = waveFormat.format;
+            newSamples->channelCount = waveFormat.channelCount;
+            newSamples->sampleRate = waveFormat.sampleRate;
+            newSamples->frameSize = waveFormat.frameSize;
+            newSamples->bitDepth = waveFormat.bitDepth;
+            newSamples->data.resize(dataSize);
+
+            inFile.seekg(dataOffset, std::ios::beg);
+            inFile.read(&newSamples->data[0], dataSize);
+
+            // the file may be shorter than its header claims: keep only the whole frames read
+            unsigned long long readFrameCount = (unsigned long long)inFile.gcount() / waveFormat.frameSize;
+            if (readFrameCount == 0)
+            {
+                delete newSamples;
+                inFile.close();
+                return false;
+            }
+            newSamples->data.resize(readFrameCount * waveFormat.frameSize);
+
+            samples = DspSampleCache::Insert(filePath, newSamples);
+        }
+
+        inFile.close();
+    }
+
+    // hand the new file over to playback
+    _StopReader();
+
+    _busyMutex.Lock();
+
+    _waveFormat = waveFormat;
+    _sampleType = DspSampleDecoder::GetSampleType(waveFormat.format, waveFormat.bitDepth);
+    std::swap(_samples, samples);
+    _frameIndex = 0;
+    _resampler.Reset();
+
+    _filePath = filePath;
+    _dataOffset = dataOffset;
+    _dataSize = streaming ? dataSize : 0;
+
+    _blockRing.Clear();
+    _blockOffset = 0;
+
+    for (int i = 0; i < _blockRing.GetCapacity(); i++)
+    {
+        _blockRing.GetSlot(i).data.resize(streaming ? blockFrames * waveFormat.frameSize : 0);
+    }
+
+    _busyMutex.Unlock();
+
+    DspSampleCache::Release(samples);  // those of the previous file
+
+    if (streaming)
+    {
+        _StartReader();
+    }
+
+    if (wasPlaying)
+    {
+        Play();
+    }
+
+    SetParameter_(pFilePath, DspParameter(DspParameter::FilePath, filePath));
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::Play()
+{
+    SetParameter_(pIsPlaying, DspParameter(DspParameter::Bool, true));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::Pause()
+{
+    SetParameter_(pIsPlaying, DspParameter(DspParameter::Bool, false));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::Stop()
+{
+    _busyMutex.Lock();
+
+    _frameIndex = 0;
+    _resampler.Reset();
+
+    // rewind the reader, discarding the blocks it has read ahead (Process_() discards those still
+    // being read, by their generation)
+    _generation.fetch_add(1, std::memory_order_release);
+
+    while (_blockRing.GetReadSlot() != NULL)
+    {
+        _FreeBlock();
+    }
+    _WakeReader();
+
+    SetParameter_(pIsPlaying, DspParameter(DspParameter::Bool, false));
+
+    _busyMutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspWaveStreamer::IsPlaying() const
+{
+    return *GetParameter_(pIsPlaying)->GetBool();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::SetStreaming(bool streaming)
+{
+    if (streaming == IsStreaming())
+    {
+        return;
+    }
+
+    SetParameter_(pStreaming, DspParameter(DspParameter::Bool, streaming));
+
+    // reload the current file in the new mode
+    std::string filePath = *GetParameter_(pFilePath)->GetString();
+
+    if (!filePath.empty())
+    {
+        LoadFile(filePath.c_str());
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspWaveStreamer::IsStreaming() const
+{
+    return *GetParameter_(pStreaming)->GetBool();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspWaveStreamer::GetUnderrunCount() const
+{
+    return _underrunCount.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::SetSampleRate(int sampleRate)
+{
+    _busyMutex.Lock();
+
+    // start converting afresh, rather than from frames buffered at the previous rate
+    _resampler.Reset();
+    SetParameter_(pSampleRate, DspParameter(DspParameter::Int, std::max(0, sampleRate)));
+
+    _busyMutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspWaveStreamer::GetSampleRate() const
+{
+    return *GetParameter_(pSampleRate)->GetInt();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::SetChannelOutputs(bool channelOutputs)
+{
+    SetParameter_(pChannelOutputs, DspParameter(DspParameter::Bool, channelOutputs));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspWaveStreamer::HasChannelOutputs() const
+{
+    return *GetParameter_(pChannelOutputs)->GetBool();
+}
+
+//=================================================================================================
+
+void DspWaveStreamer::Process_(DspSignalBus&, DspSignalBus& outputs)
+{
+    if (IsPlaying() && (_samples != NULL || _dataSize > 0))
+    {
+        _busyMutex.Lock();
+
+        // one channel per file channel, and at least a left and right one
+        int channelCount = std::max(2, (int)_waveFormat.channelCount);
+
+        if (_channels.GetChannelCount() != channelCount)
+        {
+            _channels.Resize(channelCount, _bufferSize);
+        }
+
+        int sampleRate = GetSampleRate();
+
+        if (sampleRate == 0 || sampleRate == (int)_waveFormat.sampleRate)
+        {
+            _NextFrames(_channels, _bufferSize);
+        }
+        else
+        {
+            // read as many of the file's frames as it takes to convert a whole buffer
+            _resampler.SetRates(_waveFormat.sampleRate, sampleRate);
+            _resampler.SetChannelCount(channelCount);
+
+            int frameCount = _resampler.GetInputFrameCount(_bufferSize);
+
+            _fileChannels.Resize(channelCount, frameCount);
+            _NextFrames(_fileChannels, frameCount);
+
+            _resampler.Write(_fileChannels.GetChannel(0), _fileChannels.GetChannelStride(), frameCount);
+            _resampler.Read(_channels.GetChannel(0), _channels.GetChannelStride(), _bufferSize);
+        }
+
+        _busyMutex.Unlock();
+
+        if (HasChannelOutputs())
+        {
+            float* leftChannel = _channels.GetChannel(0);
+            float* rightChannel = _channels.GetChannel(1);
+
+            outputs.PrepareValue< std::vector<float> >(0)->assign(leftChannel, leftChannel + _bufferSize);
+            outputs.PrepareValue< std::vector<float> >(1)->assign(rightChannel, rightChannel + _bufferSize);
+        }
+
+        outputs.SetValue("Sample Rate", GetSampleRate() != 0 ? GetSampleRate() : (int)_waveFormat.sampleRate);
+        outputs.SetValue("Channels", _channels);
+    }
+    else
+    {
+        outputs.ClearValue(0);
+        outputs.ClearValue(1);
+        outputs.ClearValue("Channels");
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspWaveStreamer::ParameterUpdating_(int index, DspParameter const& param)
+{
+    if (index == pFilePath)
+    {
+        return LoadFile(param.GetString()->c_str());
+    }
+    else if (index == pPlay)
+    {
+        Play();
+        return true;
+    }
+    else if (index == pPause)
+    {
+        Pause();
+        return true;
+    }
+    else if (index == pStop)
+    {
+        Stop();
+        return true;
+    }
+    else if (index == pStreaming)
+    {
+        SetStreaming(*param.GetBool());
+        return true;
+    }
+    else if (index == pSampleRate)
+    {
+        SetSampleRate(*param.GetInt());
+        return true;
+    }
+    else if (index == pChannelOutputs)
+    {
+        SetChannelOutputs(*param.GetBool());
+        return true;
+    }
+
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspComponent* DspWaveStreamer::Clone_()
+{
+    DspWaveStreamer* waveStreamer = new DspWaveStreamer();
+
+    // set the mode first, such that the file path (copied after this call) is loaded only once
+    waveStreamer->SetStreaming(IsStreaming());
+
+    // the file path parameter is copied after this call, LoadFile() then retains the playing state
+    if (IsPlaying())
+    {
+        waveStreamer->Play();
+    }
+
+    return waveStreamer;
+}
+
+//=================================================================================================
+
+bool DspWaveStreamer::_ReadHeader(std::ifstream& inFile,
+                                  char const* filePath,
+                                  WaveFormat& waveFormat,
+                                  std::streamoff& dataOffset,
+                                  unsigned long long& dataSize)
+{
+    // sizes are unsigned 32-bit, hence offsets past them are 64-bit (files of 2GB and over)
+    uint32_t dwFileSize = 0, dwChunkSize = 0;
     char dwChunkId[5];
     char dwExtra[5];
 
@@ -89,27 +472,24 @@ bool DspWaveStreamer::LoadFile(char const* filePath)
     if (strcmp(dwChunkId, "RIFF"))
     {
         std::cerr << "'" << filePath << "' not found.\n";
-        inFile.close();
         return false;
     }
     inFile.seekg(4, std::ios::beg);  // get file size
     inFile.read(reinterpret_cast<char*>(&dwFileSize), 4);
     if (dwFileSize <= 16)
     {
-        inFile.close();
         return false;
     }
     inFile.seekg(8, std::ios::beg);  // get file format
     inFile.read(dwExtra, 4);
     if (strcmp(dwExtra, "WAVE"))
     {
-        inFile.close();
         return false;
     }
 
     // look for 'fmt ' chunk id
     bool bFilledFormat = false;
-    for (int i = 12; i < dwFileSize;)
+    for (std::streamoff i = 12; i < dwFileSize;)
     {
         inFile.seekg(i, std::ios::beg);
         inFile.read(dwChunkId, 4);
@@ -119,32 +499,47 @@ bool DspWaveStreamer::LoadFile(char const* filePath)
         {
             inFile.seekg(i + 8, std::ios::beg);
 
-            _waveFormat.Clear();
-            inFile.read(reinterpret_cast<char*>(&_waveFormat.format), 2);
-            inFile.read(reinterpret_cast<char*>(&_waveFormat.channelCount), 2);
-            inFile.read(reinterpret_cast<char*>(&_waveFormat.sampleRate), 4);
-            inFile.read(reinterpret_cast<char*>(&_waveFormat.byteRate), 4);
-            inFile.read(reinterpret_cast<char*>(&_waveFormat.frameSize), 2);
-            inFile.read(reinterpret_cast<char*>(&_waveFormat.bitDepth), 2);
-            inFile.read(reinterpret_cast<char*>(&_waveFormat.extraDataSize), 2);
+            waveFormat.Clear();
+            inFile.read(reinterpret_cast<char*>(&waveFormat.format), 2);
+            inFile.read(reinterpret_cast<char*>(&waveFormat.channelCount), 2);
+            inFile.read(reinterpret_cast<char*>(&waveFormat.sampleRate), 4);
+            inFile.read(reinterpret_cast<char*>(&waveFormat.byteRate), 4);
+            inFile.read(reinterpret_cast<char*>(&waveFormat.frameSize), 2);
+            inFile.read(reinterpret_cast<char*>(&waveFormat.bitDepth), 2);
+            inFile.read(reinterpret_cast<char*>(&waveFormat.extraDataSize), 2);
+
+            // WAVE_FORMAT_EXTENSIBLE: the actual format is the first 2 bytes of the sub-format GUID
+            if (waveFormat.format == 0xfffe && waveFormat.extraDataSize >= 22)
+            {
+                inFile.seekg(i + 8 + 24, std::ios::beg);
+                inFile.read(reinterpret_cast<char*>(&waveFormat.format), 2);
+            }
 
             bFilledFormat = true;
             break;
         }
-        dwChunkSize += 8;  // add offsets of the chunk id, and chunk size data entries
-        dwChunkSize += 1;
-        dwChunkSize &= 0xfffffffe;  // guarantees WORD padding alignment
-        i += dwChunkSize;
+        std::streamoff chunkSize = dwChunkSize;
+        chunkSize += 8;  // add offsets of the chunk id, and chunk size data entries
+        chunkSize += 1;
+        chunkSize &= ~std::streamoff(1);  // guarantees WORD padding alignment
+        i += chunkSize;
     }
-    if (!bFilledFormat)
+    if (!bFilledFormat || waveFormat.channelCount == 0)
     {
-        inFile.close();
+        return false;
+    }
+
+    DspSampleDecoder::SampleType sampleType = DspSampleDecoder::GetSampleType(waveFormat.format, waveFormat.bitDepth);
+    if (sampleType == DspSampleDecoder::Unsupported ||
+        waveFormat.frameSize != waveFormat.channelCount * DspSampleDecoder::GetSampleSize(sampleType))
+    {
+        std::cerr << "'" << filePath << "' has an unsupported sample format.\n";
         return false;
     }
 
     // look for 'data' chunk id
     bool bFilledData = false;
-    for (int i = 12; i < dwFileSize;)
+    for (std::streamoff i = 12; i < dwFileSize;)
     {
         inFile.seekg(i, std::ios::beg);
         inFile.read(dwChunkId, 4);
@@ -152,128 +547,258 @@ bool DspWaveStreamer::LoadFile(char const* filePath)
         inFile.read(reinterpret_cast<char*>(&dwChunkSize), 4);
         if (!strcmp(dwChunkId, "data"))
         {
-            _waveData.resize(dwChunkSize / 2);
-            inFile.seekg(i + 8, std::ios::beg);
-            inFile.read(reinterpret_cast<char*>(&_waveData[0]), dwChunkSize);
-            bFilledData = true;
+            dataOffset = i + 8;
+            dataSize = dwChunkSize - dwChunkSize % waveFormat.frameSize;  // whole frames only
+            bFilledData = dataSize > 0;
             break;
         }
-        dwChunkSize += 8;  // add offsets of the chunk id, and chunk size data entries
-        dwChunkSize += 1;
-        dwChunkSize &= 0xfffffffe;  // guarantees WORD padding alignment
-        i += dwChunkSize;
-    }
-    if (!bFilledData)
-    {
-        inFile.close();
-        return false;
+        std::streamoff chunkSize = dwChunkSize;
+        chunkSize += 8;  // add offsets of the chunk id, and chunk size data entries
+        chunkSize += 1;
+        chunkSize &= ~std::streamoff(1);  // guarantees WORD padding alignment
+        i += chunkSize;
     }
 
-    inFile.close();
-
-    if (wasPlaying)
-    {
-        Play();
-    }
-
-    SetParameter_(pFilePath, DspParameter(DspParameter::FilePath, filePath));
-    return true;
+    return bFilledData;
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DspWaveStreamer::Play()
+void DspWaveStreamer::_StartReader()
 {
-    SetParameter_(pIsPlaying, DspParameter(DspParameter::Bool, true));
+    _stopReader.store(false, std::memory_order_relaxed);
+
+    _reader = new _Reader(this);
+    _reader->Start(DspThread::HighPriority);  // reads ahead of an audio thread
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DspWaveStreamer::Pause()
+void DspWaveStreamer::_StopReader()
 {
-    SetParameter_(pIsPlaying, DspParameter(DspParameter::Bool, false));
+    if (_reader != NULL)
+    {
+        _stopReader.store(true, std::memory_order_release);
+        _WakeReader();
+
+        delete _reader;  // joins the thread
+        _reader = NULL;
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DspWaveStreamer::Stop()
+void DspWaveStreamer::_RunReader()
 {
-    _busyMutex.Lock();
+    std::ifstream inFile(_filePath.c_str(), std::ios::binary | std::ios::in);
 
-    _sampleIndex = 0;
-    SetParameter_(pIsPlaying, DspParameter(DspParameter::Bool, false));
+    int generation = _generation.load(std::memory_order_acquire);
+    unsigned long long position = 0;  // in the data chunk, in bytes
+    bool seek = true;
 
-    _busyMutex.Unlock();
-}
+    while (!_stopReader.load(std::memory_order_acquire))
+    {
+        // read the counter before checking for room, so that a block freed in between is never missed
+        int blocksFreed = _blocksFreed.Load();
+        _Block* block = _blockRing.GetWriteSlot();
 
-//-------------------------------------------------------------------------------------------------
+        if (block == NULL)
+        {
+            _blocksFreed.Wait(blocksFreed);
+            continue;
+        }
 
-bool DspWaveStreamer::IsPlaying() const
-{
-    return *GetParameter_(pIsPlaying)->GetBool();
-}
+        // start over from the top after a rewind
+        int newGeneration = _generation.load(std::memory_order_acquire);
 
-//=================================================================================================
+        if (newGeneration != generation)
+        {
+            generation = newGeneration;
+            position = 0;
+            seek = true;
+        }
 
-void DspWaveStreamer::Process_(DspSignalBus&, DspSignalBus& outputs)
-{
-    if (IsPlaying() && _waveData.size() > 0)
-    {
-        _busyMutex.Lock();
+        // read a block, wrapping around to the start of the data at its end (playback loops)
+        unsigned long long blockSize = block->data.size();
+        unsigned long long readSize = 0;
+        unsigned long long blockPosition = position;
 
-        int index = 0;
-        for (int i = 0; i < _bufferSize * 2; i += 2)
+        while (readSize < blockSize)
         {
-            _leftChannel[index++] = (float)_waveData[_sampleIndex + i] * _shortToFloatCoeff;
+            unsigned long long chunkSize = std::min(blockSize - readSize, _dataSize - position);
+
+            if (seek)
+            {
+                inFile.seekg(_dataOffset + position, std::ios::beg);
+                seek = false;
+            }
+
+            inFile.read(&block->data[readSize], chunkSize);
+            readSize += inFile.gcount();
+            position += inFile.gcount();
+
+            if ((unsigned long long)inFile.gcount() != chunkSize)
+            {
+                break;  // the file is shorter than its header claims
+            }
+            if (position == _dataSize)
+            {
+                position = 0;
+                seek = true;
+            }
         }
 
-        index = 0;
-        for (int i = 1; i < _bufferSize * 2; i += 2)
+        if (readSize < _waveFormat.frameSize)
         {
-            _rightChannel[index++] = (float)_waveData[_sampleIndex + i] * _shortToFloatCoeff;
+            if (blockPosition == 0)
+            {
+                break;  // nothing to read at all, Process_() outputs silence from here on
+            }
+
+            // the file ended (short of its header's claim) right at the end of the last block
+            inFile.clear();
+            position = 0;
+            seek = true;
+            continue;
         }
 
-        _sampleIndex += _bufferSize * 2;
-        _sampleIndex %= _waveData.size() - _bufferSize * 2;
+        block->frameCount = readSize / _waveFormat.frameSize;
+        block->generation = generation;
+        _blockRing.CommitWrite();
 
-        _busyMutex.Unlock();
+        if (readSize < blockSize)
+        {
+            inFile.clear();
+            position = 0;
+            seek = true;
+        }
+    }
+}
 
-        outputs.SetValue(0, _leftChannel);
-        outputs.SetValue(1, _rightChannel);
-        outputs.SetValue("Sample Rate", _waveFormat.sampleRate);
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::_NextFrames(DspPlanarBuffer<float>& channels, int frameCount)
+{
+    if (_dataSize > 0)
+    {
+        _StreamFrames(channels, frameCount);
     }
     else
     {
-        outputs.ClearValue(0);
-        outputs.ClearValue(1);
+        _PlayFrames(channels, frameCount);
     }
 }
 
 //-------------------------------------------------------------------------------------------------
 
-bool DspWaveStreamer::ParameterUpdating_(int index, DspParameter const& param)
+void DspWaveStreamer::_PlayFrames(DspPlanarBuffer<float>& channels, int frameCount)
 {
-    if (index == pFilePath)
+    // copy the next frames out of memory, wrapping around to the top at the end
+    // (in size_t, as the samples of a file may well span more than 2GB)
+    size_t sampleFrameCount = _samples->data.size() / _waveFormat.frameSize;
+    char const* frames = &_samples->data[0];
+
+    for (int frame = 0; frame < frameCount;)
     {
-        return LoadFile(param.GetString()->c_str());
+        int readCount = (int)std::min(sampleFrameCount - _frameIndex, (size_t)(frameCount - frame));
+
+        _ReadFrames(channels, frames + _frameIndex * _waveFormat.frameSize, readCount, frame);
+
+        frame += readCount;
+        _frameIndex = (_frameIndex + readCount) % sampleFrameCount;
     }
-    else if (index == pPlay)
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::_StreamFrames(DspPlanarBuffer<float>& channels, int frameCount)
+{
+    // copy the next frames out of the blocks read ahead
+    int generation = _generation.load(std::memory_order_acquire);
+
+    for (int frame = 0; frame < frameCount;)
     {
-        Play();
-        return true;
+        _Block* block = _blockRing.GetReadSlot();
+
+        if (block == NULL)
+        {
+            // the reader fell behind, output silence for the rest of this buffer
+            for (int i = 0; i < channels.GetChannelCount(); i++)
+            {
+                memset(channels.GetChannel(i) + frame, 0, (frameCount - frame) * sizeof(float));
+            }
+
+            _underrunCount.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+
+        if (block->generation != generation)
+        {
+            _FreeBlock();  // read before the last rewind
+            continue;
+        }
+
+        int readCount = std::min(block->frameCount - _blockOffset, frameCount - frame);
+
+        _ReadFrames(channels, &block->data[_blockOffset * _waveFormat.frameSize], readCount, frame);
+
+        frame += readCount;
+        _blockOffset += readCount;
+
+        if (_blockOffset == block->frameCount)
+        {
+            _FreeBlock();
+        }
     }
-    else if (index == pPause)
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::_ReadFrames(DspPlanarBuffer<float>& channels,
+                                  char const* frames,
+                                  int frameCount,
+                                  int channelFrame)
+{
+    // deinterleave and convert the frames into the channels
+    float* leftChannel = channels.GetChannel(0) + channelFrame;
+
+    DspSampleDecoder::Decode(_sampleType,
+                             _waveFormat.channelCount,
+                             frames,
+                             frameCount,
+                             leftChannel,
+                             channels.GetChannelStride(),
+                             channels.GetChannelCount());
+
+    // a mono file feeds both the left and right channels
+    if (_waveFormat.channelCount == 1)
     {
-        Pause();
-        return true;
+        memcpy(channels.GetChannel(1) + channelFrame, leftChannel, frameCount * sizeof(float));
     }
-    else if (index == pStop)
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::_FreeBlock()
+{
+    _blockRing.CommitRead();
+    _blockOffset = 0;
+
+    _WakeReader();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspWaveStreamer::_WakeReader()
+{
+    // bumped by Process_() and Stop() as blocks are freed, and to rewind / stop the reader
+    int blocksFreed = _blocksFreed.Load();
+    while (!_blocksFreed.CompareExchange(blocksFreed, blocksFreed + 1))
     {
-        Stop();
-        return true;
+        blocksFreed = _blocksFreed.Load();
     }
 
-    return false;
+    _blocksFreed.WakeAll();
 }
 
 //=================================================================================================
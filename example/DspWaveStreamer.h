@@ -26,8 +26,33 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 #define DSPWAVESTREAMER_H
 
 #include <DSPatch.h>
+#include <DspSampleCache.h>
+#include <DspResampler.h>
+#include <DspSampleDecoder.h>
+
+#include <atomic>
+#include <fstream>
 
 //=================================================================================================
+// Plays a WAV file in a loop.
+//
+// Files of 8/16/24/32-bit integer or 32/64-bit float samples, with any number of channels, are
+// decoded straight into the "Channels" output (see DspSampleDecoder). Outputs 0 and 1 only carry
+// the first two channels (a mono file feeds both) once enabled via SetChannelOutputs(), as each
+// costs a copy of its channel per tick.
+//
+// The file is played at its own sample rate, which the "Sample Rate" output carries, unless a
+// sample rate is set (see SetSampleRate()). The samples are then converted to that rate on the
+// fly (see DspResampler), such that files of any rate can feed the same DspAudioDevice without
+// it restarting its stream.
+//
+// By default, LoadFile() reads the file's samples into memory in full, sharing them with every
+// other DspWaveStreamer playing the same file via the process-wide DspSampleCache (hence loading a
+// file already loaded is instant). In streaming mode (see SetStreaming()), LoadFile() only reads
+// the file's header, while a background thread reads the samples ahead of playback into a ring of
+// blocks. Opening a file then takes constant time, and memory use is bounded by the ring's size
+// regardless of the file's length. Should the reader fall behind playback, silence is output
+// instead, and GetUnderrunCount() is incremented.
 
 class DspWaveStreamer : public DspComponent
 {
@@ -37,6 +62,9 @@ public:
     int pPause;      // Trigger
     int pStop;       // Trigger
     int pIsPlaying;  // Bool
+    int pStreaming;  // Bool
+    int pSampleRate;  // Int
+    int pChannelOutputs;  // Bool
 
     DspWaveStreamer();
     ~DspWaveStreamer();
@@ -48,9 +76,21 @@ public:
 
     bool IsPlaying() const;
 
+    void SetStreaming(bool streaming);
+    bool IsStreaming() const;
+
+    unsigned long GetUnderrunCount() const;
+
+    void SetSampleRate(int sampleRate);  // 0: the file's own
+    int GetSampleRate() const;
+
+    void SetChannelOutputs(bool channelOutputs);  // also write outputs 0 and 1
+    bool HasChannelOutputs() const;
+
 protected:
     virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs);
     virtual bool ParameterUpdating_(int index, DspParameter const& param);
+    virtual DspComponent* Clone_();
 
 private:
     struct WaveFormat
@@ -66,7 +106,7 @@ private:
             extraDataSize = 0;
         }
 
-        unsigned short format;         // Integer identifier of the format
+        unsigned short format;         // Integer identifier of the format (sub-format if extensible)
         unsigned short channelCount;   // Number of audio channels
         unsigned long sampleRate;      // Audio sample rate
         unsigned long byteRate;        // Bytes per second (possibly approximate)
@@ -75,15 +115,54 @@ private:
         unsigned short extraDataSize;  // Bytes of extra data appended to this struct
     };
 
+    class _Reader;
+
+    struct _Block
+    {
+        std::vector<char> data;
+        int frameCount;
+        int generation;  // of the rewind it was read after (see Stop())
+    };
+
+    bool _ReadHeader(std::ifstream& inFile,
+                     char const* filePath,
+                     WaveFormat& waveFormat,
+                     std::streamoff& dataOffset,
+                     unsigned long long& dataSize);
+    void _StartReader();
+    void _StopReader();
+    void _RunReader();
+
+    void _NextFrames(DspPlanarBuffer<float>& channels, int frameCount);
+    void _PlayFrames(DspPlanarBuffer<float>& channels, int frameCount);
+    void _StreamFrames(DspPlanarBuffer<float>& channels, int frameCount);
+    void _ReadFrames(DspPlanarBuffer<float>& channels, char const* frames, int frameCount, int channelFrame);
+    void _FreeBlock();
+    void _WakeReader();
+
     WaveFormat _waveFormat;
-    std::vector<short> _waveData;
+    DspSampleDecoder::SampleType _sampleType;
+    DspSampleCache::Samples const* _samples;  // in memory
     int _bufferSize;
-    int _sampleIndex;
-    float _shortToFloatCoeff;
+    size_t _frameIndex;  // next frame played from memory
     DspMutex _busyMutex;
 
-    std::vector<float> _leftChannel;
-    std::vector<float> _rightChannel;
+    std::string _filePath;
+    std::streamoff _dataOffset;     // of the data chunk in the file, in bytes
+    unsigned long long _dataSize;  // of the data chunk, in bytes (whole frames)
+
+    _Reader* _reader;
+    DspRingBuffer<_Block> _blockRing;  // reader -> Process_()
+    int _blockOffset;                  // frames of the block at the ring's head already played
+    DspFutex _blocksFreed;             // bumped whenever a block is freed (and to wake the reader)
+    std::atomic<int> _generation;      // bumped on rewind, blocks read before are discarded
+    std::atomic<bool> _stopReader;
+    std::atomic<unsigned long> _underrunCount;
+
+    DspResampler _resampler;
+    DspPlanarBuffer<float> _fileChannels;  // at the file's sample rate, when converted
+
+    DspPlanarBuffer<float> _channels;
 };
 
 //=================================================================================================
@@ -27,6 +27,7 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 #include <DspWaveStreamer.h>
 #include <DspGain.h>
 #include <DspAudioDevice.h>
+#include <DspRtAudioBackend.h>
 #include <DspAdder.h>
 
 #include <stdio.h>
@@ -45,7 +46,7 @@ int main()
 
     // declare components to be added to the circuit
     DspWaveStreamer waveStreamer;
-    DspAudioDevice audioDevice;
+    DspAudioDevice audioDevice(new DspRtAudioBackend());  // streams through the sound card(s)
     DspGain gainLeft;
     DspGain gainRight;
 
@@ -65,6 +66,13 @@ int main()
     // DspAudioDevice's "Sample Rate" input receives a sample rate value and updates the audio stream accordingly
     circuit.ConnectOutToIn(waveStreamer, "Sample Rate", audioDevice, "Sample Rate");  // sample rate sync
 
+    // (rather than restart its stream at the wave's sample rate, the audio device can also convert the wave to its own
+    // rate: see DspAudioDevice::SetResampling())
+
+    // DspWaveStreamer's "Channels" output carries all of the wave's channels at once, outputs 0 and 1 carry its left
+    // and right channels one by one once enabled
+    waveStreamer.SetChannelOutputs(true);
+
     // connect component output signals to respective component input signals
     circuit.ConnectOutToIn(waveStreamer, 0, gainLeft, 0);   // wave left channel into gain left
     circuit.ConnectOutToIn(waveStreamer, 1, gainRight, 0);  // wave right channel into gain right
@@ -35,6 +35,7 @@ static const float TWOPI = 6.283185307179586476925286766559f;
 DspOscillator::DspOscillator(float startFreq, float startAmpl)
     : _lastPos(0)
     , _lookupLength(0)
+    , _processMutex(DspMutex::PriorityInherit)  // held by parameter updates in control threads
 {
     AddInput_("Sample Rate");
     AddInput_("Buffer Size");
@@ -199,6 +200,13 @@ bool DspOscillator::ParameterUpdating_(int index, DspParameter const& param)
     return false;
 }
 
+//-------------------------------------------------------------------------------------------------
+
+DspComponent* DspOscillator::Clone_()
+{
+    return new DspOscillator(GetFreq(), GetAmpl());
+}
+
 //=================================================================================================
 
 void DspOscillator::_BuildLookup()
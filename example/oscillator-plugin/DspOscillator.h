@@ -53,6 +53,7 @@ public:
 protected:
     virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs);
     virtual bool ParameterUpdating_(int index, DspParameter const& param);
+    virtual DspComponent* Clone_();
 
 private:
     std::vector<float> _signalLookup;
@@ -28,21 +28,38 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 //-------------------------------------------------------------------------------------------------
 
 #include <dspatch/DspCircuit.h>
+#include <dspatch/DspEngine.h>
+#include <dspatch/DspPlanarBuffer.h>
 #include <dspatch/DspPluginLoader.h>
+#include <dspatch/DspProfiler.h>
+#include <dspatch/DspRenderSink.h>
+#include <dspatch/DspRingBuffer.h>
+#include <dspatch/DspSchedulingProfile.h>
+#include <dspatch/DspThreadPlacement.h>
+#include <dspatch/DspThreadScaling.h>
+#include <dspatch/DspTickSource.h>
+#include <dspatch/DspTracer.h>
 
 //=================================================================================================
 /// System-wide DSPatch functionality
 
 /**
-At the core of the DSPatch framework is what's known as the "global circuit". The DSPatch class and
-hence, the global circuit provides a transparent workspace for "global scoped components"
-(components not within a DspCircuit) to benefit from circuit parallel processing. As it is not
-required that components be explicitly added to a DspCircuit in order to be routed etc., in order
-for these global scoped components to benefit from the multi threading associated with the circuit
-scheduler, they are automatically added to the DSPatch global circuit when parallel processing is
-required (i.e. StartAutoTick() is called). Although global circuit operations are automatic and
-transparent to the user, if required, the user is may set the number of threads used by the global
-circuit by calling SetGlobalThreadCount().
+At the core of the DSPatch framework is what's known as the "global engine". The DSPatch class and
+hence, the global engine's root circuit provides a transparent workspace for "global scoped
+components" (components not within a DspCircuit) to benefit from circuit parallel processing. As
+it is not required that components be explicitly added to a DspCircuit in order to be routed etc.,
+in order for these global scoped components to benefit from the multi threading associated with
+the circuit scheduler, they are automatically added to the global engine's root circuit when
+parallel processing is required (i.e. StartAutoTick() is called). Although global engine
+operations are automatic and transparent to the user, if required, the user is may set the number
+of threads used by the global engine's root circuit by calling SetGlobalThreadCount() (which
+returns the number of threads granted).
+
+The global engine is simply the default DspEngine instance, accessible via GetGlobalEngine(). It
+also provides the worker pool used by every circuit not assigned an engine of its own (see
+DspCircuit::SetEngine()). Additional DspEngine instances may be created in order to run isolated
+processing domains, each with its own auto-tick thread, worker pool and priority (see DspEngine).
+The global engine is never destroyed, as circuits may outlive Finalize().
 
 Lastly, the Finalize() method must be called on application exit in order for DSPatch to perform
 the necessary memory cleanup.
@@ -51,24 +68,10 @@ the necessary memory cleanup.
 class DLLEXPORT DSPatch
 {
 public:
-    static void SetGlobalThreadCount(int threadCount);
-    static void Finalize();
-
-private:
-    static bool _IsThisGlobalCircuit(DspComponent const* thisComponent);
-
-    static bool _AddGlobalComponent(DspComponent* component);
-    static void _RemoveGlobalComponent(DspComponent const* component);
-
-    static int _GetGlobalComponentCount();
+    static int SetGlobalThreadCount(int threadCount);
 
-    static void _StartGlobalAutoTick();
-    static void _StopGlobalAutoTick();
-
-private:
-    friend class DspComponent;
-
-    static DspCircuit* _globalCircuit;
+    static DspEngine& GetGlobalEngine();
+    static void Finalize();
 };
 
 //=================================================================================================
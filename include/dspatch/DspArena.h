@@ -0,0 +1,89 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPARENA_H
+#define DSPARENA_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+
+#include <dspatch/DspThread.h>
+
+//=================================================================================================
+/// Cache-line aligned fixed-size block allocator
+
+/**
+A DspArena hands out fixed-size memory blocks carved from larger chunks. The block size requested
+on construction is rounded up to a whole number of cache lines and every block begins on a cache
+line boundary, hence no two blocks ever share a cache line. Blocks returned via Free() are reused
+by subsequent calls to Allocate(), while the underlying chunks are only released when the arena
+is destroyed.
+
+Each DspCircuit owns a DspArena from which the per-thread state of its components is allocated
+(see DspComponent), keeping the state touched by each circuit thread on its own cache lines and
+close together in memory. DspArena is not thread-safe: allocations are made while the owning
+circuit is paused.
+
+When a NUMA node is provided on construction, every chunk is page aligned and its pages are bound
+to that node (where supported by the platform), so that blocks are local to the threads placed on
+the node (see DspThreadPlacement).
+*/
+
+class DLLEXPORT DspArena
+{
+public:
+    static const size_t CacheLineSize = 64;
+
+    DspArena(size_t blockSize, int blocksPerChunk = 64, int numaNode = -1);
+    ~DspArena();
+
+    void* Allocate();
+    void Free(void* block);
+
+    size_t GetBlockSize() const;
+    int GetNumaNode() const;
+
+private:
+    DspArena(DspArena const&);
+    DspArena& operator=(DspArena const&);
+
+    void _BindToNode(char* memory, size_t size);
+
+private:
+    size_t _blockSize;
+    int _blocksPerChunk;
+    int _numaNode;
+
+    std::vector<char*> _chunks;
+    std::vector<void*> _freeBlocks;
+
+    char* _nextBlock;
+    char* _chunkEnd;
+};
+
+//=================================================================================================
+
+#endif  // DSPARENA_H
@@ -30,6 +30,12 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 #include <dspatch/DspComponent.h>
 #include <dspatch/DspWireBus.h>
 #include <dspatch/DspCircuitThread.h>
+#include <dspatch/DspEngine.h>
+#include <dspatch/DspRenderSink.h>
+#include <dspatch/DspThreadScaling.h>
+
+#include <atomic>
+#include <map>
 
 //=================================================================================================
 /// Workspace for adding and routing components
@@ -50,24 +56,110 @@ For process intensive circuits, multi-threaded processing can be enabled via the
 method. DspCircuit allows the user to specify the number of threads in which he/she requires the
 circuit to process (0 threads: multi-threading disabled). A circuit's thread count can be adjusted
 at runtime, allowing the user to increase / decrease the number of threads as required during
-execution.
+execution. Only the threads added (or retired) are started (or stopped), along with their
+per-thread component buffers, and while the circuit is being auto-ticked the change is handed over
+to the ticking thread at its next tick boundary (SetThreadCount() returns once it has taken
+effect), hence the remaining threads carry on processing throughout. SetThreadCount() must
+therefore not be called from within a tick of the circuit. Circuit threads run on workers leased
+from a DspEngine's pool, hence a circuit may be granted fewer threads than requested when the pool
+is exhausted or the engine's circuit thread limit is lower: SetThreadCount() returns the number of
+threads actually granted (as does GetThreadCount() from then on). The engine a circuit leases from
+can be provided on construction or via SetEngine(). A circuit without an engine of its own leases
+from its parent circuit's engine (at the time its thread count is set), or the global engine if it
+has no parent (see DSPatch::GetGlobalEngine()).
+
+SetThreadCount() optionally takes a DspThreadPlacement, pinning the circuit's threads to a set of
+CPUs and / or a NUMA node (a circuit without placement of its own follows its engine's placement,
+see DspEngine::SetPlacement()). When a NUMA node is given, the per-thread state of every component
+in the circuit is allocated on that node too. GetThreadAffinity() reads back the CPU set each
+circuit thread actually runs on, as reported by the OS. Similarly, SetSchedulingProfile() selects
+the OS scheduling policy of the circuit's threads (see DspSchedulingProfile), overriding the
+engine's profile (see DspEngine::SetSchedulingProfile()), and GetThreadScheduling() reports the
+profile actually in effect per thread (E.g. time-sharing when real-time scheduling was refused).
+
+Rather than hand-tuning the thread count, SetThreadScaling() enables an auto-tuner that measures
+how long the circuit's threads are busy per tick and adds or retires threads (within configured
+bounds) to process each tick within a target deadline (see DspThreadScaling). The tuner measures on
+the thread ticking the circuit, while the threads it adds (or retires) are started (or stopped) on
+a thread of its own and swapped in by the ticking thread at a tick boundary, and
+GetThreadScalingStats() reports its measurements along with every decision it has taken (see
+DspThreadScalingStats). SetThreadCount() may still be called while the tuner is enabled, providing
+it with a new starting point.
 
 DspCircuit is derived from DspComponent and therefore inherits all DspComponent behavior. This
 means that a DspCircuit can be added to, and routed within another DspCircuit as a component. This
 also means a circuit object needs to be Tick()ed and Reset()ed as a component (see DspComponent).
 The DspCircuit Process_() method simply runs through it's internal array of components and calls each
 component's Tick() and Reset() methods.
+
+For offline (faster than real-time) processing, Render() ticks and resets the circuit a given
+number of times back to back, handing the circuit's outputs to a DspRenderSink after every tick,
+while TickN() does the same without a sink. In multi-threaded mode, each circuit thread is handed
+its whole share of the ticks at once, hence the threads process tick after tick without waiting on
+the caller in between, and synchronisation is paid once per render rather than once per tick.
+Unlike those of Tick() (which lag by one tick per circuit thread), the outputs of each tick reach
+the sink in tick order as soon as the tick is processed. Render() and TickN() return the number of
+ticks processed, or 0 for a circuit that is auto-ticked, attached to a tick source, or routed
+within another circuit (as it is ticked by these). They must not be called concurrently with
+SetThreadCount(), and the thread count auto-tuner takes no decisions during a multi-threaded render.
+
+Where throughput matters more than latency (E.g. offline data pipelines), Stream() processes a
+given number of ticks without ticking the circuit in lockstep: every component becomes a pipeline
+stage whose outputs are queued for up to queueDepth ticks, and each stage processes its next tick
+as soon as the ticks it reads from its input components are processed and its queue has room for
+the outputs, rather than waiting for the slowest stage of the circuit on every tick. A stage whose
+queue is full waits for the components reading from it to catch up, while a fast stage runs ahead,
+processing several ticks in a row. Stages are processed by the calling thread together with the
+circuit's threads (one tick of a component at a time, and in tick order), hence with no threads, a
+stream still processes each component in batches. A wire that closes a feedback loop delivers the
+output of the previous tick, as when ticked without threads: the first tick streamed reads the
+outputs of the last tick rendered, and once the stream is done, the circuit's threads pick up from
+the ticks streamed as if they had processed them. The outputs of each tick reach the sink (if
+provided) in tick order, though the stages may have processed up to queueDepth ticks further when
+the sink stops the stream. Stream() returns the number of ticks processed (by the sink, if
+provided) under the same conditions as Render(), and the circuit must not be modified while
+streamed.
+
+A DspCircuit can be duplicated via the Clone() method. Clone() creates a new circuit containing a
+clone of every internal component (see DspComponent::Clone_()), with the same parameter values,
+component names, IO and wiring as the original, in a single pass (the source circuit is paused only
+once for the duration of the copy). The new circuit owns the cloned components and deletes them on
+destruction. If any internal component cannot be cloned, Clone() returns NULL.
 */
 
 class DLLEXPORT DspCircuit : public DspComponent
 {
 public:
-    DspCircuit(int threadCount = 0);
+    DspCircuit(int threadCount = 0, DspEngine* engine = NULL);
     ~DspCircuit();
 
-    void SetThreadCount(int threadCount);
+    int SetThreadCount(int threadCount);
+    int SetThreadCount(int threadCount, DspThreadPlacement const& placement);
     int GetThreadCount() const;
 
+    DspThreadPlacement GetThreadPlacement() const;
+    bool GetThreadAffinity(int threadNo, std::vector<int>& cpus);
+
+    void SetSchedulingProfile(DspSchedulingProfile const& profile);
+    DspSchedulingProfile GetSchedulingProfile() const;
+    bool GetThreadScheduling(int threadNo, DspSchedulingProfile& effective);
+
+    void SetThreadScaling(DspThreadScaling const& scaling);
+    DspThreadScaling GetThreadScaling() const;
+    DspThreadScalingStats GetThreadScalingStats() const;
+
+    void SetEngine(DspEngine* engine);
+    DspEngine* GetEngine() const;
+
+    DspCircuit* Clone();
+
+    unsigned long Render(unsigned long tickCount, DspRenderSink* sink);
+    unsigned long Render(unsigned long tickCount, DspRenderSink& sink);
+    unsigned long TickN(unsigned long tickCount);
+
+    unsigned long Stream(unsigned long tickCount, DspRenderSink* sink = NULL, int queueDepth = 8);
+    unsigned long Stream(unsigned long tickCount, DspRenderSink& sink, int queueDepth = 8);
+
     bool AddComponent(DspComponent* component, std::string const& componentName = "");
     bool AddComponent(DspComponent& component, std::string const& componentName = "");
 
@@ -119,6 +211,7 @@ public:
 
 protected:
     virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs);
+    virtual DspComponent* Clone_();
 
 private:
     virtual void _PauseAutoTick();
@@ -131,14 +224,132 @@ private:
     void _DisconnectComponent(int componentIndex);
     void _RemoveComponent(int componentIndex);
 
+    bool _SetThreadCount(int threadCount, bool tuned = false);
+    void _LockThreadCount();
+    void _UnlockThreadCount();
+    void _SwapThreads();
+    void _ScaleThreads(double processTime);
+    void _ApplyThreadScaling(DspThreadScalingStats::Decision decision);
+    DspArena* _GetThreadStateArena();
+
+    unsigned long _RenderThreads(unsigned long tickCount);
+    bool _RenderTick(int threadNo);
+
+    struct _StreamStage;
+
+    bool _LinkStreamStages(DspRenderSink* sink);
+    bool _LinkStreamStage(_StreamStage* stage,
+                          std::map<DspComponent const*, _StreamStage*> const& stages,
+                          std::map<_StreamStage const*, int>& visits);
+    void _StreamWork(int workerNo);
+    bool _StreamStageTicks(_StreamStage* stage);
+    bool _IsStreamStageReady(_StreamStage const* stage, unsigned long tickNo) const;
+    void _StreamProgress();
+
 private:
+    friend class DspCircuitThread;
+    friend class DspComponent;
+
+    DspArena _threadStateArena;
+    std::vector<DspArena*> _nodeArenas;
+    DspEngine* _engine;
+    DspThreadPlacement _placement;
+    DspSchedulingProfile _scheduling;
+
     std::vector<DspComponent*> _components;
+    std::vector<DspComponent*> _ownedComponents;
 
-    std::vector<DspCircuitThread> _circuitThreads;
+    std::vector<DspCircuitThread*> _circuitThreads;
     int _currentThreadIndex;
 
     DspWireBus _inToInWires;
     DspWireBus _outToOutWires;
+
+    // threads and thread states prepared by _SetThreadCount(), swapped in by _SwapThreads()
+    std::vector<DspCircuitThread*> _newCircuitThreads;
+    std::vector< std::vector<DspComponent::_ThreadState*> > _newThreadStates;
+    DspFutex _threadCountChange;  // 1: posted, 2: posted by the tuner, -1: taken back
+    DspFutex _threadCountLock;    // 1: locked, 2: locked while the tuner's change is posted
+
+    // state of a render, handed from circuit thread to circuit thread in tick order
+    DspRenderSink* _renderSink;
+    DspFutex _renderTurn;          // number of the thread whose tick is handed over next
+    unsigned long _renderTickNo;   // number of the tick handed over next
+    bool _renderStopped;           // set once the sink has stopped the render
+
+    // a component (or the render sink) processed as a pipeline stage while streamed, reading the
+    // ticks of the stages it is wired to (see Stream())
+    struct _StreamStage
+    {
+        _StreamStage(DspComponent* newComponent)
+            : component(newComponent)
+            , tickCount(0)
+            , claimed(false)
+        {
+        }
+
+        DspComponent* component;  // NULL: the render sink
+        std::vector<_StreamStage*> inputs;  // stage read by each input wire
+        std::vector<int> wireDelays;        // per input wire (1: feedback, reading the previous tick)
+        std::vector< std::pair<_StreamStage*, int> > readers;  // stage and delay of every wire reading this stage
+        std::atomic<unsigned long> tickCount;  // number of ticks processed
+        std::atomic<bool> claimed;             // set while a thread processes the stage
+    };
+
+    // state of a stream, shared by the threads processing it
+    std::vector<_StreamStage*> _streamStages;
+    unsigned long _streamTickCount;
+    unsigned long _streamDepth;
+    DspFutex _streamProgress;  // bumped whenever a stage processes a tick
+    std::atomic<bool> _streamStopped;
+
+    // thread count auto-tuning: configuration and stats are shared with the ticking thread, while
+    // the measurement window is the ticking thread's alone
+    struct _ScalingWindow
+    {
+        _ScalingWindow()
+            : ticks(0)
+            , processTime(0)
+            , threadCount(0)
+            , threadTicks(0)
+            , busyTime(0)
+            , waitTime(0)
+            , upCount(0)
+            , downCount(0)
+            , settling(false)
+            , checkScaleUp(false)
+            , scaleUpLoad(0)
+            , upBlockedUntil(0)
+            , changing(false)
+        {
+        }
+
+        DspThreadScaling scaling;
+        unsigned long ticks;
+        double processTime;
+        int threadCount;
+        unsigned long threadTicks;
+        double busyTime;
+        double waitTime;
+        int upCount;
+        int downCount;
+        bool settling;
+        bool checkScaleUp;
+        double scaleUpLoad;
+        unsigned long upBlockedUntil;
+        bool changing;  // set while the thread scaler applies the change below
+        DspThreadScalingStats::Decision change;
+    };
+
+    class _ThreadScaler;
+
+    DspThreadScaling _threadScaling;
+    DspThreadScalingStats _threadScalingStats;
+    mutable DspMutex _threadScalingMutex;
+    std::atomic<bool> _threadScalingEnabled;
+    std::atomic<bool> _threadScalingChanged;
+    _ScalingWindow _scalingWindow;
+    _ThreadScaler* _threadScaler;  // applies the tuner's decisions (see _ScaleThreads())
 };
 
 //=================================================================================================
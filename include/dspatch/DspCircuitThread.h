@@ -27,14 +27,17 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 
 //-------------------------------------------------------------------------------------------------
 
+#include <atomic>
 #include <vector>
 
 #include <dspatch/DspThread.h>
 
+class DspCircuit;
 class DspComponent;
+class DspEngine;
 
 //=================================================================================================
-/// Thread class for ticking and reseting circuit components
+/// Job class for ticking and reseting circuit components
 
 /**
 A DspCircuitThread is responsible for ticking and reseting all components in a DspCircuit.
@@ -50,38 +53,84 @@ The Resume() method causes the DspCircuitThread to tick and reset all circuit co
 after which the thread will wait until instructed to resume again. As each component is done
 processing it hands over control to the next waiting circuit thread, therefore, from an external
 control loop (I.e. DspCircuit's Process_() method) we simply loop through our array of
-DspCircuitThreads calling Resume() on each. If a circuit thread is busy processing, a call to
-Resume() will block momentarily until processing is complete, then begin the next iteration
-immediately upon unblocking the calling thread.
+DspCircuitThreads calling Sync() then Resume() on each.
 
 The Sync() method, when called, will block the calling thread until the circuit thread is done
 processing. If the circuit thread is already awaiting the next Resume() request, this method will
-return immediately.
+return immediately. Resume() must therefore only be called once Sync() has returned. Both
+handshakes are DspFutex flags: Resume() publishes the circuit inputs to the thread and Sync()
+acquires its outputs, and neither costs a system call unless the other side is actually asleep.
+
+Resume() may also be given a number of ticks to process back to back before syncing (see
+DspCircuit::Render()), in which case the thread hands each tick over to the circuit provided, via
+DspCircuit::_RenderTick(), as soon as it is processed. Should that return false, the thread stops
+short of the remaining ticks.
+
+Stream() instead has the thread join the circuit provided in streaming it (see
+DspCircuit::Stream()), processing whichever of its components are ready until the stream is done,
+after which the thread syncs as usual. Ticks streamed are not counted by GetTickTimes().
+
+A DspCircuitThread does not own an OS thread. Start() leases a worker thread from the DspEngine
+provided on initialisation and runs the circuit thread's loop on it until Stop() is called, at
+which point the worker is returned to the engine's pool (see DspEngine). Start() returns false if
+the engine has no worker available. The CPUs provided via SetThreadAffinity() are applied to the
+worker before the circuit thread's loop begins (none lets it run on any CPU, whichever CPUs it was
+restricted to before), and GetThreadAffinity() reads back the worker's resulting CPU set (as
+reported by the OS). Likewise, the DspSchedulingProfile provided via SetSchedulingProfile() is
+applied to the worker as the loop begins, and GetThreadScheduling() reads back the profile actually
+in effect (which differs from the one requested when the OS refused it).
+
+Each tick is timed: GetTickTimes() returns the number of ticks processed since Start(), the total
+time spent processing them (including time spent waiting for components to be handed over by the
+other circuit threads), and the total time spent waiting to be resumed, in microseconds. The
+counters may be read while the thread runs (see DspCircuit::SetThreadScaling()).
 */
 
-class DLLEXPORT DspCircuitThread : public DspThread
+class DLLEXPORT DspCircuitThread
 {
 public:
     DspCircuitThread();
     ~DspCircuitThread();
 
-    void Initialise(std::vector<DspComponent*>* components, int threadNo);
+    void Initialise(DspEngine* engine, std::vector<DspComponent*>* components, int threadNo);
 
-    void Start(Priority priority = TimeCriticalPriority);
+    bool Start();
     void Stop();
     void Sync();
     void Resume();
+    void Resume(int tickCount, DspCircuit* renderCircuit);
+    void Stream(DspCircuit* streamCircuit);
+
+    void SetThreadAffinity(std::vector<int> const& cpus);
+    bool GetThreadAffinity(std::vector<int>& cpus);
+
+    void SetSchedulingProfile(DspSchedulingProfile const& profile);
+    bool GetThreadScheduling(DspSchedulingProfile& effective);
+
+    void GetTickTimes(unsigned long& tickCount, double& busyTime, double& waitTime) const;
 
 private:
+    friend class DspEngine;
+
+    DspEngine* _engine;
+    bool _leased;
     std::vector<DspComponent*>* _components;
     int _threadNo;
-    bool _stop;
-    bool _stopped;
-    bool _gotResume, _gotSync;
-    DspMutex _resumeMutex;
-    DspWaitCondition _resumeCondt, _syncCondt;
-
-    virtual void _Run();
+    std::atomic<bool> _stop;
+    std::atomic<bool> _stopped;
+    DspCircuit* _renderCircuit;
+    DspCircuit* _streamCircuit;
+    DspFutex _gotResume, _gotSync;  // _gotResume holds the number of ticks to process
+    DspFutex _placed;
+    std::atomic<unsigned long> _tickCount;
+    std::atomic<long long> _busyTime, _waitTime;  // nanoseconds
+    std::vector<int> _cpus;
+    std::vector<int> _affinity;
+    DspSchedulingProfile _scheduling;
+    DspSchedulingProfile _effectiveScheduling;
+
+    void _Run();
+    void _WaitForPlacement();
 };
 
 //=================================================================================================
@@ -27,12 +27,17 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 
 //-------------------------------------------------------------------------------------------------
 
+#include <dspatch/DspArena.h>
 #include <dspatch/DspSignalBus.h>
 #include <dspatch/DspWireBus.h>
 #include <dspatch/DspComponentThread.h>
 #include <dspatch/DspParameter.h>
+#include <dspatch/DspProfiler.h>
+#include <dspatch/DspTracer.h>
 
 class DspCircuit;
+class DspEngine;
+class DspTickSource;
 
 //=================================================================================================
 /// Abstract base class for all DSPatch components
@@ -70,7 +75,19 @@ method. The Reset() method then informs the component that the last circuit trav
 and hence can execute the next Tick() request. A component's Tick() and Reset() methods can be
 called in a loop from the main application thread, or alternatively, by calling StartAutoTick(), a
 separate thread will spawn, automatically calling Tick() and Reset() methods continuously (This is
-most commonly used to tick over an instance of DspCircuit).
+most commonly used to tick over an instance of DspCircuit). StartAutoTick() auto-ticks the component
+within the global DspEngine (or the engine it is already auto-ticking in), while
+StartAutoTick(engine) auto-ticks it within the specified engine (see DspEngine). Either may be
+given a DspTickPacing, pacing the engine's auto-tick thread (see DspEngine::SetAutoTickPacing()).
+Alternatively, a component can be ticked on external events (E.g. an audio device callback, a timer
+or file descriptor readiness) by attaching it to a DspTickSource instead. PauseAutoTick() and
+ResumeAutoTick() then hold off the source's ticks.
+
+Derived classes that can be duplicated (see DspCircuit::Clone()) should implement the virtual
+Clone_() method. Clone_() should simply return a new instance of the derived component, constructed
+with the same construction arguments as this one. The component name and parameter values are then
+copied onto the new instance by the DSPatch engine (via ParameterUpdating_()). By default, Clone_()
+returns NULL, indicating that the component cannot be cloned.
 */
 
 class DLLEXPORT DspComponent
@@ -129,6 +146,9 @@ public:
     void Reset();
 
     void StartAutoTick();
+    void StartAutoTick(DspTickPacing const& pacing);
+    void StartAutoTick(DspEngine& engine);
+    void StartAutoTick(DspEngine& engine, DspTickPacing const& pacing);
     void StopAutoTick();
     void PauseAutoTick();
     void ResumeAutoTick();
@@ -136,6 +156,7 @@ public:
 protected:
     virtual void Process_(DspSignalBus&, DspSignalBus&);
     virtual bool ParameterUpdating_(int, DspParameter const&);
+    virtual DspComponent* Clone_();
 
     bool AddInput_(std::string const& inputName = "");
     bool AddOutput_(std::string const& outputName = "");
@@ -157,7 +178,14 @@ protected:
     bool SetParameter_(int index, DspParameter const& param);
 
 private:
+    DspEngine& _GetAutoTickEngine();
+    DspTickSource* _GetTickSource() const;
+    bool _IsAutoTicking() const;
     virtual void _PauseAutoTick();
+    void _ResumeAutoTick();
+    static int& _GetEditDepth();
+
+    DspComponent* _Clone();
 
     void _SetParentCircuit(DspCircuit* parentCircuit);
     DspCircuit* _GetParentCircuit();
@@ -167,12 +195,24 @@ private:
     bool _FindOutput(std::string const& signalName, int& returnIndex) const;
     bool _FindOutput(int signalIndex, int& returnIndex) const;
 
+    struct _ThreadState;
+
     void _SetBufferCount(int bufferCount);
     int _GetBufferCount() const;
+    void _GetThreadStates(int bufferCount, std::vector<_ThreadState*>& threadStates);
+    void _SwapThreadStates(std::vector<_ThreadState*>& threadStates, int nextThread);
+    static void _FreeThreadStates(std::vector<_ThreadState*> const& threadStates, int bufferCount);
+    static size_t _GetThreadStateSize();
+
+    void _Process(DspSignalBus& inputs, DspSignalBus& outputs);
+    void _TimeProcess(DspSignalBus& inputs, DspSignalBus& outputs);
 
     void _ThreadTick(int threadNo);
     void _ThreadReset(int threadNo);
 
+    void _StreamTick(unsigned long tickNo, std::vector<int> const& wireDelays);
+    static void _CopySignals(DspSignalBus& fromBus, DspSignalBus& toBus);
+
     bool _SetInputSignal(int inputIndex, DspSignal const* newSignal);
     bool _SetInputSignal(int inputIndex, int threadIndex, DspSignal const* newSignal);
     DspSignal* _GetOutputSignal(int outputIndex);
@@ -184,17 +224,38 @@ private:
 private:
     friend class DspCircuit;
     friend class DspCircuitThread;
+    friend class DspEngine;
+    friend class DspProfiler;
+    friend class DspTickSource;
+    friend class DspTracer;
+
+    // all state touched by one circuit thread, allocated from the parent circuit's DspArena (for the
+    // thread's NUMA node) such that no two threads ever share a cache line
+    struct _ThreadState
+    {
+        _ThreadState(DspArena* newArena)
+            : arena(newArena)
+            , hasTicked(false)
+            , gotRelease(0)
+        {
+        }
+
+        DspArena* arena;
+        bool hasTicked;
+        DspFutex gotRelease;
+        DspSignalBus inputBus;
+        DspSignalBus outputBus;
+    };
 
     DspCircuit* _parentCircuit;
+    DspEngine* _rootEngine;  // engine whose root circuit this is (NULL for all other components)
+    DspTickSource* _tickSource;  // source this component is attached to (if any)
 
     int _bufferCount;
 
     DspSignalBus _inputBus;
     DspSignalBus _outputBus;
 
-    std::vector<DspSignalBus> _inputBuses;
-    std::vector<DspSignalBus> _outputBuses;
-
     std::vector< std::pair<std::string, DspParameter> > _parameters;
 
     std::string _componentName;
@@ -208,13 +269,13 @@ private:
 
     DspComponentThread _componentThread;
 
-    std::vector<bool*> _hasTickeds;  // bool pointers ensure that parallel threads will only read from this vector
-    std::vector<bool> _gotReleases;  // bool pointers not used here as only 1 thread writes to this vector at a time
-    std::vector<DspMutex> _releaseMutexes;
-    std::vector<DspWaitCondition> _releaseCondts;
+    std::vector<_ThreadState*> _threadStates;
 
     Callback_t _callback;
     void* _userData;
+
+    std::atomic<DspProfiler::_Profile*> _profile;  // Process_() timings (see DspProfiler)
+    std::atomic<int> _traceId;                     // name in traces (see DspTracer)
 };
 
 //=================================================================================================
@@ -27,7 +27,11 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 
 //-------------------------------------------------------------------------------------------------
 
+#include <atomic>
+#include <vector>
+
 #include <dspatch/DspThread.h>
+#include <dspatch/DspTickPacing.h>
 
 class DspComponent;
 
@@ -40,7 +44,19 @@ a separate free-running thread. On construction, a reference to the component mu
 the DspThread's _Run() method to use. Once Start() has been called, the thread will begin
 repeatedly executing the _Run() method. On each thread iteration, DspComponentThread simply calls
 the reference component's Tick() and Reset() methods. The Pause() method causes DspComponentThread
-to wait until instructed to Resume() again.
+to wait until instructed to Resume() again. GetTickCount() returns the number of iterations the
+thread has completed since it was last started. The CPUs provided via SetThreadAffinity() are
+applied by the thread itself when started, and GetThreadAffinity() reads back the resulting CPU
+set (as reported by the OS). Likewise, a DspSchedulingProfile provided via SetSchedulingProfile()
+overrides the start priority, and GetThreadScheduling() reads back the profile actually in effect.
+By default the thread ticks free-running, while SetTickPacing() selects a fixed tick rate or an
+idle backoff instead (see DspTickPacing). The pacing may only be changed while the thread is paused
+or stopped.
+
+The thread's flags are atomics and all waits (Pause() waiting for the thread to pause, the thread
+waiting to be resumed or for its next paced tick) are DspFutex waits, while Stop() joins the
+thread. Hence, none of these calls poll, and a paced thread wakes as soon as it is paused or
+stopped.
 */
 
 class DLLEXPORT DspComponentThread : public DspThread
@@ -51,20 +67,47 @@ public:
 
     void Initialise(DspComponent* component);
     bool IsStopped() const;
+    unsigned long GetTickCount() const;
 
     void Start(Priority priority = TimeCriticalPriority);
     void Stop();
     void Pause();
     void Resume();
 
+    void SetThreadAffinity(std::vector<int> const& cpus);
+    bool GetThreadAffinity(std::vector<int>& cpus);
+
+    void SetSchedulingProfile(DspSchedulingProfile const& profile);
+    bool GetThreadScheduling(DspSchedulingProfile& effective);
+
+    void SetTickPacing(DspTickPacing const& pacing);
+    DspTickPacing GetTickPacing() const;
+
 private:
     DspComponent* _component;
-    bool _stop, _pause;
-    bool _stopped;
-    DspMutex _resumeMutex;
-    DspWaitCondition _resumeCondt, _pauseCondt;
+    std::atomic<bool> _stop;
+    std::atomic<bool> _stopped;
+    std::atomic<unsigned long> _tickCount;
+    DspFutex _state;  // _Running, _Pausing, _Paused or _Stopping
+    DspFutex _placed;
+    std::vector<int> _cpus;
+    std::vector<int> _affinity;
+    DspSchedulingProfile _scheduling;
+    DspSchedulingProfile _effectiveScheduling;
+    DspTickPacing _pacing;
+
+    enum _State
+    {
+        _Running,
+        _Pausing,
+        _Paused,
+        _Stopping
+    };
 
     virtual void _Run();
+    void _WaitForPlacement();
+    void _Pace(unsigned long long tickStart, unsigned long long& nextTick, unsigned long& backoff);
+    void _SleepUntil(unsigned long long time);
 };
 
 //=================================================================================================
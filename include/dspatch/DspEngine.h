@@ -0,0 +1,165 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPENGINE_H
+#define DSPENGINE_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <vector>
+
+#include <dspatch/DspThreadPlacement.h>
+#include <dspatch/DspTickPacing.h>
+
+class DspCircuit;
+class DspCircuitThread;
+class DspComponent;
+
+//=================================================================================================
+/// Independent processing domain with its own auto-tick thread and worker pool
+
+/**
+A DspEngine owns a bounded pool of worker threads onto which DspCircuits schedule their circuit
+threads (see DspCircuitThread). Rather than spawning a thread of its own, every DspCircuitThread
+leases a worker from its circuit's engine when started and returns it when stopped. Hence, no
+matter how many circuits (nested or otherwise) request multi-threaded processing, the total number
+of threads processing circuits never exceeds the engine's worker count.
+
+The worker count defaults to the number of CPU cores and may be changed at any time via
+SetWorkerCount(). Workers are created on demand as circuits request them and are kept alive for
+reuse once released. SetCircuitThreadLimit() additionally caps the number of workers any single
+circuit may lease (a negative limit means no limit besides the worker count). When a circuit asks
+for more threads than the engine can grant, the circuit simply runs with fewer threads (see
+DspCircuit::SetThreadCount(), which returns the number of threads granted).
+
+Each engine also owns a "root circuit" and the auto-tick thread that ticks it. Components
+auto-ticked via DspComponent::StartAutoTick(engine) are added to the engine's root circuit, exactly
+as the global engine (see DSPatch::GetGlobalEngine()) does for DspComponent::StartAutoTick(). The
+root circuit's thread count is set via SetRootThreadCount() (which returns the number of threads
+granted), while SetPriority() selects the priority of both the auto-tick thread and the workers
+leased from this engine. Any number of engines can be created, each forming an isolated processing
+domain with its own thread budget and priority. GetComponentCount(), GetAutoTickCount(),
+GetActiveWorkerCount() and GetIdleWorkerCount() report the engine's current load.
+
+SetPlacement() restricts the engine's threads to a set of CPUs and / or a NUMA node (see
+DspThreadPlacement). The placement applies to the auto-tick thread, and to the threads of every
+circuit leasing from this engine that has no placement of its own (see
+DspCircuit::SetThreadCount()). Placement is applied as threads are started, hence SetPlacement()
+should be called before auto-ticking or setting thread counts. GetAutoTickAffinity() reads back the
+CPU set of the running auto-tick thread, as reported by the OS.
+
+SetSchedulingProfile() selects the OS scheduling policy of the engine's threads (see
+DspSchedulingProfile), overriding the mapping from priority (E.g. SCHED_FIFO on Linux) that is used
+otherwise. Like the placement, it applies to the auto-tick thread and to the threads of circuits
+without a profile of their own, and takes effect as threads are started. Where a policy is refused
+(typically for lack of privileges) the threads fall back to time-sharing, hence
+GetAutoTickScheduling() and DspCircuit::GetThreadScheduling() report the profile actually in
+effect.
+
+The auto-tick thread ticks free-running by default, which suits circuits paced by a blocking
+component (E.g. an audio device) but spins a whole core for control-only circuits.
+SetAutoTickPacing() paces it at a fixed tick rate, or backs it off while its ticks are idle,
+instead (see DspTickPacing). The pacing takes effect immediately, even while auto-ticking.
+
+Components auto-ticked by an engine are removed from it when the engine is destroyed, while
+circuits leasing workers from an engine must not be processed after it is destroyed.
+*/
+
+class DLLEXPORT DspEngine
+{
+public:
+    DspEngine(int workerCount = -1);
+    ~DspEngine();
+
+    int SetRootThreadCount(int threadCount);
+    int GetRootThreadCount() const;
+
+    void SetPriority(DspThread::Priority priority);
+    DspThread::Priority GetPriority() const;
+
+    void SetSchedulingProfile(DspSchedulingProfile const& profile);
+    DspSchedulingProfile GetSchedulingProfile() const;
+
+    void SetPlacement(DspThreadPlacement const& placement);
+    DspThreadPlacement GetPlacement() const;
+
+    void SetAutoTickPacing(DspTickPacing const& pacing);
+    DspTickPacing GetAutoTickPacing() const;
+
+    void SetWorkerCount(int workerCount);
+    int GetWorkerCount() const;
+
+    void SetCircuitThreadLimit(int threadLimit);
+    int GetCircuitThreadLimit() const;
+
+    int GetComponentCount() const;
+    unsigned long GetAutoTickCount() const;
+    int GetActiveWorkerCount() const;
+    int GetIdleWorkerCount() const;
+    bool GetAutoTickAffinity(std::vector<int>& cpus) const;
+    bool GetAutoTickScheduling(DspSchedulingProfile& effective) const;
+
+private:
+    class _Worker;
+
+    DspEngine(DspEngine const&);
+    DspEngine& operator=(DspEngine const&);
+
+    bool _AddComponent(DspComponent* component);
+    void _RemoveComponent(DspComponent const* component);
+    void _StartAutoTick();
+    void _StopAutoTick();
+    void _Finalize();
+
+    int _GetThreadLimit(int threadCount) const;
+    void _GetThreadCpus(DspThreadPlacement const& placement, int threadNo, std::vector<int>& cpus) const;
+    DspSchedulingProfile _GetThreadScheduling(DspSchedulingProfile const& profile) const;
+
+    bool _Acquire(DspCircuitThread* job);
+    void _Release(DspCircuitThread* job);
+
+    void _TrimIdleWorkers(std::vector<_Worker*>& idleWorkers);
+
+private:
+    friend class DSPatch;
+    friend class DspCircuit;
+    friend class DspCircuitThread;
+    friend class DspComponent;
+
+    std::vector<_Worker*> _workers;
+    int _workerCount;
+    int _circuitThreadLimit;
+    DspThread::Priority _priority;
+    DspSchedulingProfile _scheduling;
+    DspThreadPlacement _placement;
+    DspTickPacing _pacing;
+
+    mutable DspMutex _workersMutex;
+
+    DspCircuit* _rootCircuit;
+};
+
+//=================================================================================================
+
+#endif  // DSPENGINE_H
@@ -0,0 +1,271 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPPLANARBUFFER_H
+#define DSPPLANARBUFFER_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstring>
+
+//=================================================================================================
+/// Non-owning view of a range of channels within a DspPlanarBuffer
+
+/**
+A DspChannelView references a contiguous range of channels within a DspPlanarBuffer (see
+DspPlanarBuffer::GetChannels()). No sample data is copied when a view is created, hence a view is
+only valid for as long as the buffer it references is neither resized nor destroyed.
+*/
+
+template <class SampleType>
+class DspChannelView
+{
+public:
+    explicit DspChannelView(SampleType* data = NULL, int channelCount = 0, int frameCount = 0, int channelStride = 0)
+        : _data(data)
+        , _channelCount(channelCount)
+        , _frameCount(frameCount)
+        , _channelStride(channelStride)
+    {
+    }
+
+    int GetChannelCount() const
+    {
+        return _channelCount;
+    }
+
+    int GetFrameCount() const
+    {
+        return _frameCount;
+    }
+
+    int GetChannelStride() const
+    {
+        return _channelStride;
+    }
+
+    SampleType* GetChannel(int channel) const
+    {
+        if (channel >= 0 && channel < _channelCount)
+        {
+            return _data + channel * _channelStride;
+        }
+        else
+        {
+            return NULL;
+        }
+    }
+
+private:
+    SampleType* _data;
+    int _channelCount;
+    int _frameCount;
+    int _channelStride;
+};
+
+//=================================================================================================
+/// Planar multichannel sample buffer
+
+/**
+A DspPlanarBuffer holds a block of multichannel sample data (channels x frames) in a single
+contiguous allocation, channel after channel (planar / non-interleaved). Every channel begins on
+a cache line boundary (the channel stride is padded accordingly), so each channel can be handed to
+aligned SIMD loops as is. A DspPlanarBuffer can be passed between components as a signal value,
+allowing any number of channels to travel across a single wire as a single memory block.
+
+Copying a DspPlanarBuffer into another of equal or larger capacity (as happens when a signal value
+is passed from an output to an input) reuses the destination's allocation. GetChannels() returns a
+DspChannelView slice over a range of channels without copying, while the (explicit) DspChannelView
+constructor overload copies such a slice into a new, independent buffer.
+
+SampleType must be a plain arithmetic type (E.g. float, double, short).
+*/
+
+template <class SampleType>
+class DspPlanarBuffer
+{
+public:
+    static const int Alignment = 64;  // in bytes
+
+    DspPlanarBuffer(int channelCount = 0, int frameCount = 0)
+        : _memory(NULL)
+        , _data(NULL)
+        , _capacity(0)
+        , _channelCount(0)
+        , _frameCount(0)
+        , _channelStride(0)
+    {
+        Resize(channelCount, frameCount);
+    }
+
+    DspPlanarBuffer(DspPlanarBuffer const& other)
+        : _memory(NULL)
+        , _data(NULL)
+        , _capacity(0)
+        , _channelCount(0)
+        , _frameCount(0)
+        , _channelStride(0)
+    {
+        *this = other;
+    }
+
+    explicit DspPlanarBuffer(DspChannelView<SampleType> const& view)
+        : _memory(NULL)
+        , _data(NULL)
+        , _capacity(0)
+        , _channelCount(0)
+        , _frameCount(0)
+        , _channelStride(0)
+    {
+        Resize(view.GetChannelCount(), view.GetFrameCount());
+
+        for (int i = 0; i < _channelCount; i++)
+        {
+            memcpy(GetChannel(i), view.GetChannel(i), _frameCount * sizeof(SampleType));
+        }
+    }
+
+    ~DspPlanarBuffer()
+    {
+        delete[] _memory;
+    }
+
+    DspPlanarBuffer& operator=(DspPlanarBuffer const& other)
+    {
+        if (this != &other)
+        {
+            Resize(other._channelCount, other._frameCount);
+
+            if (_data != NULL)
+            {
+                memcpy(_data, other._data, _channelCount * _channelStride * sizeof(SampleType));
+            }
+        }
+        return *this;
+    }
+
+    void Resize(int channelCount, int frameCount)
+    {
+        if (channelCount < 0 || frameCount < 0)
+        {
+            return;
+        }
+
+        int channelStride = _StrideFor(frameCount);
+        size_t size = (size_t)channelCount * channelStride;
+
+        // only reallocate if the current allocation is too small
+        if (size > _capacity)
+        {
+            delete[] _memory;
+
+            _memory = new char[size * sizeof(SampleType) + Alignment];
+            _data = reinterpret_cast<SampleType*>(
+                (reinterpret_cast<size_t>(_memory) + Alignment - 1) & ~(size_t)(Alignment - 1));
+            _capacity = size;
+
+            memset(_data, 0, size * sizeof(SampleType));
+        }
+
+        _channelCount = channelCount;
+        _frameCount = frameCount;
+        _channelStride = channelStride;
+    }
+
+    void Clear()
+    {
+        if (_data != NULL)
+        {
+            memset(_data, 0, _channelCount * _channelStride * sizeof(SampleType));
+        }
+    }
+
+    int GetChannelCount() const
+    {
+        return _channelCount;
+    }
+
+    int GetFrameCount() const
+    {
+        return _frameCount;
+    }
+
+    int GetChannelStride() const
+    {
+        return _channelStride;
+    }
+
+    SampleType* GetChannel(int channel)
+    {
+        if (channel >= 0 && channel < _channelCount)
+        {
+            return _data + channel * _channelStride;
+        }
+        else
+        {
+            return NULL;
+        }
+    }
+
+    SampleType const* GetChannel(int channel) const
+    {
+        return const_cast<DspPlanarBuffer*>(this)->GetChannel(channel);
+    }
+
+    DspChannelView<SampleType> GetChannels()
+    {
+        return DspChannelView<SampleType>(_data, _channelCount, _frameCount, _channelStride);
+    }
+
+    DspChannelView<SampleType> GetChannels(int firstChannel, int channelCount)
+    {
+        if (firstChannel < 0 || channelCount < 0 || firstChannel + channelCount > _channelCount)
+        {
+            return DspChannelView<SampleType>();
+        }
+
+        return DspChannelView<SampleType>(GetChannel(firstChannel), channelCount, _frameCount, _channelStride);
+    }
+
+private:
+    static int _StrideFor(int frameCount)
+    {
+        // round each channel up to a whole number of cache lines
+        int samplesPerLine = Alignment / sizeof(SampleType);
+        return (frameCount + samplesPerLine - 1) / samplesPerLine * samplesPerLine;
+    }
+
+private:
+    char* _memory;
+    SampleType* _data;
+    size_t _capacity;  // in samples
+    int _channelCount;
+    int _frameCount;
+    int _channelStride;  // in samples
+};
+
+//=================================================================================================
+
+#endif  // DSPPLANARBUFFER_H
@@ -0,0 +1,166 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPPROFILER_H
+#define DSPPROFILER_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <dspatch/DspThread.h>
+
+class DspComponent;
+
+//=================================================================================================
+/// Process_() timings of a single component
+
+/**
+A DspComponentProfile reports the Process_() calls of one component measured by the DspProfiler
+(see DspProfiler::GetProfiles()): "callCount" calls taking "totalTime" in total and "maxTime" at
+most. "histogram" counts the calls per latency bucket, where bucket i counts calls taking less than
+GetBucketLimit(i) (and at least the limit of bucket i - 1), while the last bucket also counts any
+calls taking longer. GetPercentile() estimates the time within which the given percentage of calls
+completed from the histogram, rounded up to a bucket limit. Times are in microseconds.
+*/
+
+struct DspComponentProfile
+{
+    static const int bucketCount = 32;
+
+    DspComponentProfile()
+        : component(NULL)
+        , callCount(0)
+        , totalTime(0)
+        , maxTime(0)
+        , histogram(bucketCount, 0)
+    {
+    }
+
+    static double GetBucketLimit(int bucket)
+    {
+        // log2 buckets from 2 nanoseconds up
+        return (double)(2ULL << bucket) / 1000;
+    }
+
+    double GetMeanTime() const
+    {
+        return callCount > 0 ? totalTime / callCount : 0;
+    }
+
+    double GetPercentile(double percentile) const
+    {
+        unsigned long long calls = 0;
+
+        for (int i = 0; i < bucketCount && callCount > 0; i++)
+        {
+            calls += histogram[i];
+
+            if (calls * 100.0 >= percentile * callCount)
+            {
+                return GetBucketLimit(i) < maxTime ? GetBucketLimit(i) : maxTime;
+            }
+        }
+
+        return maxTime;
+    }
+
+    DspComponent const* component;
+    std::string componentName;
+    unsigned long long callCount;
+    double totalTime;
+    double maxTime;
+    std::vector<unsigned long long> histogram;
+};
+
+//=================================================================================================
+/// Per-component Process_() timing instrumentation
+
+/**
+While enabled via SetEnabled(), the DspProfiler times every Process_() call made by the DSPatch
+engine, whether a component is ticked directly, by a circuit thread, or streamed (see
+DspCircuit::Stream()). A circuit's Process_() time therefore includes the time of all of its
+components. Disabling the profiler leaves the engine a single (predictable) branch per Process_()
+call, hence it may be switched on and off at any time, even while circuits are auto-ticking.
+
+Timings are accumulated into counters owned by the thread that measured them, each on cache lines
+of its own, such that threads never contend on the same counters and no locks are taken while
+recording. The counters of a component are allocated on the first call a thread times, which
+therefore locks and allocates (once per component and thread, after the call's time is taken, so
+the profile is unaffected): a real-time thread pays this one-off cost as profiling starts. Reading
+the profiles merges the counters of all threads: GetProfile() returns the profile of a single
+component (false if it was never timed), while GetProfiles() lists all components timed, ordered by
+their total time (longest first). Reset() restarts all profiles from zero.
+
+StartSnapshots() spawns a thread that hands all profiles to the callback provided every "interval"
+microseconds, until StopSnapshots() is called. The profiles of a component are dropped when the
+component is destroyed.
+*/
+
+class DLLEXPORT DspProfiler
+{
+public:
+    typedef void (*SnapshotCallback_t)(std::vector<DspComponentProfile> const& profiles, void* userData);
+
+    static void SetEnabled(bool enabled);
+
+    static bool IsEnabled()
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    static void Reset();
+
+    static bool GetProfile(DspComponent const* component, DspComponentProfile& profile);
+    static void GetProfiles(std::vector<DspComponentProfile>& profiles);
+
+    static void StartSnapshots(unsigned long interval, SnapshotCallback_t callback, void* userData = NULL);
+    static void StopSnapshots();
+
+private:
+    friend class DspComponent;
+
+    struct _Counters;
+    struct _Profile;
+    struct _State;
+    class _SnapshotThread;
+
+    static const int _threadSlotCount = 32;
+
+    static _State& _GetState();
+
+    static void _Record(DspComponent* component, unsigned long long time);
+    static _Counters* _AddCounters(DspComponent* component, int threadSlot);
+    static void _ReadProfile(_Profile const* profile, DspComponentProfile& result);
+    static bool _IsLonger(DspComponentProfile const& lhs, DspComponentProfile const& rhs);
+    static void _Release(DspComponent* component);
+
+    static std::atomic<bool> _enabled;
+};
+
+//=================================================================================================
+
+#endif  // DSPPROFILER_H
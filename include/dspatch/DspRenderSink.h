@@ -0,0 +1,56 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPRENDERSINK_H
+#define DSPRENDERSINK_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <dspatch/DspSignalBus.h>
+
+//=================================================================================================
+/// Abstract base class for receiving the outputs of a rendered circuit
+
+/**
+A DspRenderSink receives a circuit's outputs, tick by tick, as the circuit is rendered via
+DspCircuit::Render() (or streamed via DspCircuit::Stream()). Classes derived from DspRenderSink
+must implement the pure virtual method: Consume(), which is called once per tick with the tick's
+number (counting from 0 for the first tick of the render) and the circuit's output bus. Consume()
+is called in tick order, though not necessarily from the same thread, and never concurrently. The
+outputs are only valid for the duration of the call, hence values to be kept must be copied out.
+
+Returning false from Consume() stops the render. Ticks already in flight on other circuit threads
+at that point are still processed, but are not handed to the sink.
+*/
+
+class DLLEXPORT DspRenderSink
+{
+public:
+    virtual ~DspRenderSink();
+    virtual bool Consume(unsigned long tickNo, DspSignalBus const& outputs) = 0;
+};
+
+//=================================================================================================
+
+#endif  // DSPRENDERSINK_H
@@ -0,0 +1,195 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPRINGBUFFER_H
+#define DSPRINGBUFFER_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <vector>
+
+//=================================================================================================
+/// Lock-free single-producer / single-consumer ring of slots
+
+/**
+A DspRingBuffer hands values from one thread (the producer) to another (the consumer) without
+either side ever taking a lock or waiting, hence it is safe to use from real-time threads (E.g. an
+audio device callback). The ring holds up to GetCapacity() slots, allocated up front by Resize(),
+so that neither side allocates while streaming.
+
+The producer fills the slot returned by GetWriteSlot() in place, then publishes it with
+CommitWrite(). Likewise, the consumer reads the slot returned by GetReadSlot(), then hands it back
+with CommitRead(). GetWriteSlot() returns NULL while the ring is full, and GetReadSlot() returns
+NULL while it is empty. Push() and Pop() copy a single value in or out instead. As slots are reused
+rather than reconstructed, slots holding buffers (E.g. a DspPlanarBuffer) keep their allocations
+once sized via GetSlot().
+
+Resize(), Clear() and GetSlot() may only be called while neither side is using the ring.
+DspRingBuffer never blocks: a side that needs to wait for data or space should wait on a DspFutex
+signalled by the other side.
+*/
+
+template <class T>
+class DspRingBuffer
+{
+public:
+    DspRingBuffer(int capacity = 0)
+        : _capacity(0)
+        , _writePos(0)
+        , _readPos(0)
+    {
+        Resize(capacity);
+    }
+
+    void Resize(int capacity)
+    {
+        _slots.resize(capacity > 0 ? capacity : 0);
+        _capacity = _slots.size();
+        Clear();
+    }
+
+    void Clear()
+    {
+        _writePos.store(0, std::memory_order_relaxed);
+        _readPos.store(0, std::memory_order_relaxed);
+    }
+
+    int GetCapacity() const
+    {
+        return _capacity;
+    }
+
+    T& GetSlot(int index)
+    {
+        return _slots[index];
+    }
+
+    int GetReadCount() const
+    {
+        return _GetCount(_writePos.load(std::memory_order_acquire), _readPos.load(std::memory_order_relaxed));
+    }
+
+    int GetWriteCount() const
+    {
+        return _capacity - _GetCount(_writePos.load(std::memory_order_relaxed), _readPos.load(std::memory_order_acquire));
+    }
+
+    T* GetWriteSlot()
+    {
+        int writePos = _writePos.load(std::memory_order_relaxed);
+
+        if (_GetCount(writePos, _readPos.load(std::memory_order_acquire)) == _capacity)
+        {
+            return NULL;  // full
+        }
+
+        return &_slots[_GetIndex(writePos)];
+    }
+
+    void CommitWrite()
+    {
+        _writePos.store(_GetNext(_writePos.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    T* GetReadSlot()
+    {
+        int readPos = _readPos.load(std::memory_order_relaxed);
+
+        if (_writePos.load(std::memory_order_acquire) == readPos)
+        {
+            return NULL;  // empty
+        }
+
+        return &_slots[_GetIndex(readPos)];
+    }
+
+    void CommitRead()
+    {
+        _readPos.store(_GetNext(_readPos.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    bool Push(T const& value)
+    {
+        T* slot = GetWriteSlot();
+
+        if (slot == NULL)
+        {
+            return false;
+        }
+
+        *slot = value;
+        CommitWrite();
+        return true;
+    }
+
+    bool Pop(T& value)
+    {
+        T* slot = GetReadSlot();
+
+        if (slot == NULL)
+        {
+            return false;
+        }
+
+        value = *slot;
+        CommitRead();
+        return true;
+    }
+
+private:
+    DspRingBuffer(DspRingBuffer const&);
+    DspRingBuffer& operator=(DspRingBuffer const&);
+
+    // positions run over twice the capacity, such that a full ring can be told from an empty one
+    int _GetCount(int writePos, int readPos) const
+    {
+        return writePos >= readPos ? writePos - readPos : writePos + 2 * _capacity - readPos;
+    }
+
+    int _GetIndex(int pos) const
+    {
+        return pos < _capacity ? pos : pos - _capacity;
+    }
+
+    int _GetNext(int pos) const
+    {
+        return pos + 1 < 2 * _capacity ? pos + 1 : 0;
+    }
+
+private:
+    std::vector<T> _slots;
+    int _capacity;
+
+    // the producer and consumer positions live on separate cache lines
+    char _pad1[64];
+    std::atomic<int> _writePos;
+    char _pad2[64];
+    std::atomic<int> _readPos;
+    char _pad3[64];
+};
+
+//=================================================================================================
+
+#endif  // DSPRINGBUFFER_H
@@ -0,0 +1,83 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPSCHEDULINGPROFILE_H
+#define DSPSCHEDULINGPROFILE_H
+
+//=================================================================================================
+/// OS scheduling policy and parameters for a group of threads
+
+/**
+A DspSchedulingProfile describes how the OS should schedule a group of threads (E.g. a circuit's
+threads, see DspCircuit::SetSchedulingProfile(), or an engine's threads, see
+DspEngine::SetSchedulingProfile()). "policy" selects one of:
+
+ - OtherPolicy: regular time-sharing, weighted by "nice" (-20: highest to 19: lowest).
+ - RoundRobinPolicy / FifoPolicy: real-time scheduling at "priority" (1: lowest to 99: highest).
+ - DeadlinePolicy: a CPU budget of "runtime" microseconds every "period" microseconds, to be
+   completed within "deadline" microseconds of the period's start (Linux only).
+ - InheritPolicy: no policy of its own (the default), a circuit's threads then follow their
+   engine's profile, while an engine's threads are left as the OS created them.
+
+Real-time and deadline policies usually require privileges. When such a policy is refused and
+"fallback" is set (the default), the thread falls back to OtherPolicy at "nice", hence a profile
+requesting FifoPolicy with a negative nice value degrades to the best unprivileged alternative.
+Since the profile actually in effect may therefore differ from the one requested, it can be read
+back once the threads have started (see DspThread::GetScheduling()).
+*/
+
+struct DspSchedulingProfile
+{
+    enum Policy
+    {
+        InheritPolicy,
+        OtherPolicy,
+        RoundRobinPolicy,
+        FifoPolicy,
+        DeadlinePolicy
+    };
+
+    DspSchedulingProfile(Policy newPolicy = InheritPolicy, int newPriority = 0, int newNice = 0)
+        : policy(newPolicy)
+        , priority(newPriority)
+        , nice(newNice)
+        , runtime(0)
+        , deadline(0)
+        , period(0)
+        , fallback(true)
+    {
+    }
+
+    Policy policy;
+    int priority;
+    int nice;
+    unsigned long runtime;
+    unsigned long deadline;
+    unsigned long period;
+    bool fallback;
+};
+
+//=================================================================================================
+
+#endif  // DSPSCHEDULINGPROFILE_H
@@ -62,6 +62,9 @@ public:
     template <class ValueType>
     ValueType const* GetValue() const;
 
+    template <class ValueType>
+    ValueType* PrepareValue();
+
     bool SetSignal(DspSignal const* newSignal);
 
     void ClearValue();
@@ -125,6 +128,23 @@ ValueType const* DspSignal::GetValue() const
     }
 }
 
+//-------------------------------------------------------------------------------------------------
+
+template <class ValueType>
+ValueType* DspSignal::PrepareValue()
+{
+    // reuse the value held, even if cleared (along with its allocations)
+    ValueType* value = DspRunType::RunTypeCast<ValueType>(&_signalValue);
+    if (value == NULL)
+    {
+        _signalValue = ValueType();
+        value = DspRunType::RunTypeCast<ValueType>(&_signalValue);
+    }
+
+    _valueAvailable = true;
+    return value;
+}
+
 //=================================================================================================
 
 #endif  // DSPSIGNAL_H
@@ -38,6 +38,10 @@ receives signals into it's "inputs" DspSignalBus and provides signals to it's "o
 DspSignalBus. Although DspSignals can be acquired from a DspSignalBus, the DspSignalBus class
 provides public getters and setters for manipulating it's internal DspSignal values directly,
 abstracting the need to retrieve and interface with the contained DspSignals themself.
+
+Where SetValue() copies a value built elsewhere into a signal, PrepareValue() returns the signal's
+value of the given type for the component to write in place, reusing the value the signal held
+before (and its allocations) where it is of that type, or else a default-constructed value.
 */
 
 class DLLEXPORT DspSignalBus
@@ -74,6 +78,12 @@ public:
     template <class ValueType>
     ValueType const* GetValue(std::string const& signalName) const;
 
+    template <class ValueType>
+    ValueType* PrepareValue(int signalIndex);
+
+    template <class ValueType>
+    ValueType* PrepareValue(std::string const& signalName);
+
     void ClearValue(int signalIndex);
     void ClearValue(std::string const& signalName);
 
@@ -160,7 +170,7 @@ bool DspSignalBus::GetValue(std::string const& signalName, ValueType& returnValu
 template <class ValueType>
 ValueType const* DspSignalBus::GetValue(int signalIndex) const
 {
-    if (signalIndex < _signals.size())
+    if ((size_t)signalIndex < _signals.size())
     {
         return _signals[signalIndex].GetValue<ValueType>();
     }
@@ -187,6 +197,38 @@ ValueType const* DspSignalBus::GetValue(std::string const& signalName) const
     }
 }
 
+//-------------------------------------------------------------------------------------------------
+
+template <class ValueType>
+ValueType* DspSignalBus::PrepareValue(int signalIndex)
+{
+    if ((size_t)signalIndex < _signals.size())
+    {
+        return _signals[signalIndex].PrepareValue<ValueType>();
+    }
+    else
+    {
+        return NULL;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+template <class ValueType>
+ValueType* DspSignalBus::PrepareValue(std::string const& signalName)
+{
+    int signalIndex;
+
+    if (FindSignal(signalName, signalIndex))
+    {
+        return _signals[signalIndex].PrepareValue<ValueType>();
+    }
+    else
+    {
+        return NULL;
+    }
+}
+
 //=================================================================================================
 
 #endif  // DSPSIGNALBUS_H
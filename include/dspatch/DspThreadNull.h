@@ -25,17 +25,30 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 #ifndef DSPTHREADNULL_H
 #define DSPTHREADNULL_H
 
+//-------------------------------------------------------------------------------------------------
+
+#include <dspatch/DspSchedulingProfile.h>
+
+#include <vector>
+
 //=================================================================================================
 /// Cross-platform, object-oriented thread
 
 /**
-An class that is required to run actions in a parallel thread can be derived from DspThread in
-order to inherit multi-threading abilities. The Start() method initiates a parallel thread and
-executes the private virtual _Run() method in that thread. The derived class must override this
-_Run() method with one that executes the required parallel actions. Other threads may use the
-static MsSleep() and SetPriority() methods without having to derive from, or create an instance of
-DspThread. Priority for the created thread, or calling threads (via SetPriority()), may be selected
-from the public enumeration: Priority.
+An class that is required to run actions in a parallel thread can be derived from DspThread in order
+to inherit multi-threading abilities. The Start() method initiates a parallel thread and executes
+the private virtual _Run() method in that thread. The derived class must override this _Run() method
+with one that executes the required parallel actions. Other threads may use the static MsSleep(),
+GetMonotonicTime(), SetPriority() and GetCpuCount() methods without having to derive from, or create
+an instance of DspThread. Priority for the created thread, or calling threads (via SetPriority()),
+may be selected from the public enumeration: Priority. For finer control, SetScheduling() applies a
+DspSchedulingProfile (policy, real-time priority, nice value or deadline budget) to the calling
+thread, falling back to time-sharing where the policy is refused, and reports the profile actually
+in effect (also available via GetScheduling()). GetPriorityProfile() returns the profile a Priority
+maps to. Likewise, SetAffinity() restricts the calling thread to a set of CPUs (or lifts any such
+restriction, given none), GetAffinity() reads back the calling thread's current CPU set, and
+GetNodeCpus() lists the CPUs of a NUMA node. GetMonotonicTime() reads a monotonic clock, in
+microseconds.
 */
 
 class DspThread
@@ -69,9 +82,45 @@ public:
     static void SetPriority(Priority priority)
     {
     }
+    static DspSchedulingProfile GetPriorityProfile(Priority)
+    {
+        return DspSchedulingProfile();
+    }
+    static bool SetScheduling(DspSchedulingProfile const&, DspSchedulingProfile& effective)
+    {
+        effective = DspSchedulingProfile();
+        return false;
+    }
+    static bool GetScheduling(DspSchedulingProfile& profile)
+    {
+        profile = DspSchedulingProfile();
+        return false;
+    }
     static void MsSleep(int milliseconds)
     {
     }
+    static unsigned long long GetMonotonicTime()
+    {
+        return 0;
+    }
+    static int GetCpuCount()
+    {
+        return 1;
+    }
+    static bool SetAffinity(std::vector<int> const&)
+    {
+        return false;
+    }
+    static bool GetAffinity(std::vector<int>& cpus)
+    {
+        cpus.clear();
+        return false;
+    }
+    static bool GetNodeCpus(int, std::vector<int>& cpus)
+    {
+        cpus.clear();
+        return false;
+    }
 };
 
 //=================================================================================================
@@ -81,12 +130,26 @@ public:
 DspMutex is a simple mutex that can lock a critical section of code for exclusive access by
 the calling thread. Other threads attempting to acquire a lock while another has acquired it
 will wait at the Lock() method call until the thread that owns the mutex calls Unlock().
+
+Options may be combined on construction to suit locks shared with real-time threads.
+PriorityInherit lets the thread owning the mutex inherit the priority of the highest priority
+thread waiting for it (PTHREAD_PRIO_INHERIT), so that a real-time thread waiting on a lock held by
+a low priority thread is not held up by medium priority threads (priority inversion). AdaptiveSpin
+makes Lock() retry up to "spinCount" times before blocking, avoiding a context switch for locks
+only held briefly (spinning is skipped on single CPU systems, where it cannot succeed). A
+DspWaitCondition may wait on a mutex with any options.
 */
 
 class DspMutex
 {
 public:
-    DspMutex()
+    enum Option
+    {
+        PriorityInherit = 0x1,
+        AdaptiveSpin = 0x2
+    };
+
+    DspMutex(int = 0, int = 1000)
     {
     }
 
@@ -130,6 +193,71 @@ public:
     }
 };
 
+//=================================================================================================
+/// Cross-platform, object-oriented atomic wait
+
+/**
+A DspFutex is an integer that threads can wait on. Store() sets the value (with release semantics)
+and Load() reads it (with acquire semantics), such that writes made before a Store() are visible to
+a thread once it has loaded the stored value. CompareExchange() atomically replaces an expected
+value, such that a flag can be consumed without losing a concurrent Store(). Wait(value) puts the
+calling thread to sleep as long as the DspFutex still holds "value", until another thread calls
+WakeAll(). WaitUntil(value, time) does the same, but gives up at "time" (in microseconds, see
+DspThread::GetMonotonicTime()). As both may also return spuriously, callers re-check the value in a
+loop:
+
+    while (futex.Load() == 0)
+    {
+        futex.Wait(0);
+    }
+
+Unlike a DspWaitCondition, no mutex is involved: waits are backed by futexes on Linux and
+WaitOnAddress() on Windows, and WakeAll() costs no system call when no thread is waiting.
+*/
+
+class DspFutex
+{
+public:
+    DspFutex(int value = 0)
+        : _value(value)
+    {
+    }
+
+    virtual ~DspFutex()
+    {
+    }
+
+    int Load() const
+    {
+        return _value;
+    }
+    void Store(int value)
+    {
+        _value = value;
+    }
+    bool CompareExchange(int expected, int desired)
+    {
+        if (_value != expected)
+        {
+            return false;
+        }
+        _value = desired;
+        return true;
+    }
+    static void Wait(int)
+    {
+    }
+    static void WaitUntil(int, unsigned long long)
+    {
+    }
+    static void WakeAll()
+    {
+    }
+
+private:
+    int _value;
+};
+
 //=================================================================================================
 
 #endif  // DSPTHREADNULL_H
@@ -0,0 +1,77 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPTHREADPLACEMENT_H
+#define DSPTHREADPLACEMENT_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <vector>
+
+#include <dspatch/DspThread.h>
+
+//=================================================================================================
+/// CPU affinity and NUMA node hint for a group of threads
+
+/**
+A DspThreadPlacement describes where a group of threads (E.g. a circuit's threads, see
+DspCircuit::SetThreadCount(), or an engine's threads, see DspEngine::SetPlacement()) should run.
+"cpus" lists the CPUs the threads may run on, while "numaNode" names the NUMA node the threads and
+the per-thread buffers they process should be placed on. When "cpus" is empty, the CPUs of
+"numaNode" are used instead. When "pinThreads" is set, thread i is pinned to the single CPU:
+cpus[i % cpus.size()], rather than all threads sharing the whole CPU set. A default constructed
+DspThreadPlacement places nothing: its threads may run on any CPU.
+*/
+
+struct DspThreadPlacement
+{
+    DspThreadPlacement(int newNumaNode = -1, bool newPinThreads = false)
+        : numaNode(newNumaNode)
+        , pinThreads(newPinThreads)
+    {
+    }
+
+    void GetThreadCpus(int threadNo, std::vector<int>& threadCpus) const
+    {
+        threadCpus = cpus;
+
+        if (threadCpus.empty() && numaNode >= 0)
+        {
+            DspThread::GetNodeCpus(numaNode, threadCpus);
+        }
+
+        if (pinThreads && !threadCpus.empty())
+        {
+            threadCpus.assign(1, threadCpus[threadNo % threadCpus.size()]);
+        }
+    }
+
+    std::vector<int> cpus;
+    int numaNode;
+    bool pinThreads;
+};
+
+//=================================================================================================
+
+#endif  // DSPTHREADPLACEMENT_H
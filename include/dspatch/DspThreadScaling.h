@@ -0,0 +1,139 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPTHREADSCALING_H
+#define DSPTHREADSCALING_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <vector>
+
+//=================================================================================================
+/// Bounds and thresholds for automatic scaling of a circuit's thread count
+
+/**
+A DspThreadScaling configures a circuit's thread count auto-tuner (see
+DspCircuit::SetThreadScaling()). The tuner keeps the circuit's thread count between
+"minThreadCount" and "maxThreadCount", aiming to process each tick within "deadline" microseconds.
+
+Load is measured over windows of "window" ticks. Every circuit thread processes one tick in N (for
+N threads), hence has N x deadline to complete its tick, and the window's "load" is the mean time a
+thread is busy per tick (including time spent waiting on other threads to hand components over)
+divided by N x deadline (a circuit without threads simply divides the time its Process_() takes by
+the deadline). When the load exceeds "scaleUpLoad" for "holdWindows" consecutive windows a thread
+is added, and when the load predicted for one thread less stays below "scaleDownLoad" for
+"holdWindows" consecutive windows a thread is retired. The gap between the two thresholds, the hold
+count, and the window discarded after every change (to let the threads settle) keep the tuner from
+oscillating. A thread added that did not bring at least half the load reduction expected of it
+(E.g. as the circuit's components form one serial chain) is retired again, after which no threads
+are added for 8 x "holdWindows" windows. The same goes for a thread the engine could not grant.
+
+A default constructed DspThreadScaling (deadline 0) disables the tuner.
+*/
+
+struct DspThreadScaling
+{
+    DspThreadScaling(int newMinThreadCount = 0, int newMaxThreadCount = 0, unsigned long newDeadline = 0)
+        : minThreadCount(newMinThreadCount)
+        , maxThreadCount(newMaxThreadCount)
+        , deadline(newDeadline)
+        , window(256)
+        , scaleUpLoad(0.85)
+        , scaleDownLoad(0.5)
+        , holdWindows(3)
+    {
+    }
+
+    bool IsEnabled() const
+    {
+        return deadline > 0 && window > 0 && maxThreadCount >= minThreadCount;
+    }
+
+    int minThreadCount;
+    int maxThreadCount;
+    unsigned long deadline;
+    unsigned long window;
+    double scaleUpLoad;
+    double scaleDownLoad;
+    int holdWindows;
+};
+
+//=================================================================================================
+/// Measurements and decisions of a circuit's thread count auto-tuner
+
+/**
+DspThreadScalingStats reports the state of a circuit's thread count auto-tuner (see
+DspCircuit::GetThreadScalingStats()). "busyTime", "waitTime" (the mean time a thread waited for its
+next tick) and "load" (see DspThreadScaling) describe the last window measured, and "windowCount"
+the number of windows measured in total. Every decision taken is appended to "decisions" (the
+latest "historySize" decisions are kept, while "decisionCount" counts them all), noting its action,
+the window it was taken in, the thread count before and after (the count actually granted), and the
+measurements it was based on. Times are in microseconds.
+*/
+
+struct DspThreadScalingStats
+{
+    enum Action
+    {
+        ScaleUp,
+        ScaleDown,
+        Revert,
+        Clamp
+    };
+
+    struct Decision
+    {
+        Action action;
+        unsigned long window;
+        int fromThreadCount;
+        int toThreadCount;
+        double busyTime;
+        double waitTime;
+        double load;
+    };
+
+    static const size_t historySize = 64;
+
+    DspThreadScalingStats()
+        : windowCount(0)
+        , threadCount(0)
+        , busyTime(0)
+        , waitTime(0)
+        , load(0)
+        , decisionCount(0)
+    {
+    }
+
+    unsigned long windowCount;
+    int threadCount;
+    double busyTime;
+    double waitTime;
+    double load;
+    unsigned long decisionCount;
+    std::vector<Decision> decisions;
+};
+
+//=================================================================================================
+
+#endif  // DSPTHREADSCALING_H
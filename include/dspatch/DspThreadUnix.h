@@ -27,9 +27,30 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 
 //-------------------------------------------------------------------------------------------------
 
+#include <dspatch/DspSchedulingProfile.h>
+
 #include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <linux/futex.h>
+#endif
+
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
 //=================================================================================================
 
 class DspThread
@@ -37,6 +58,7 @@ class DspThread
 public:
     DspThread()
         : _threadAttatched(false)
+        , _priority(NormalPriority)
     {
     }
 
@@ -60,56 +82,325 @@ public:
 
     virtual void Start(Priority priority = NormalPriority)
     {
+        _priority = priority;
+
         pthread_create(&_thread, NULL, _ThreadFunc, this);
         _threadAttatched = true;
-
-        _SetPriority(_thread, priority);
     }
 
     virtual void Stop()
     {
         if (_threadAttatched)
         {
-            pthread_detach(_thread);
+            // a thread cannot join itself, let it clean up after itself instead
+            if (pthread_equal(_thread, pthread_self()))
+            {
+                pthread_detach(_thread);
+            }
+            else
+            {
+                pthread_join(_thread, NULL);
+            }
             _threadAttatched = false;
         }
     }
 
     static void SetPriority(Priority priority)
     {
-        _SetPriority(pthread_self(), priority);
+        DspSchedulingProfile effective;
+        SetScheduling(GetPriorityProfile(priority), effective);
+    }
+
+    static DspSchedulingProfile GetPriorityProfile(Priority priority)
+    {
+        // real-time FIFO, or time-sharing at an equivalent nice value when unprivileged
+        DspSchedulingProfile profile(DspSchedulingProfile::FifoPolicy);
+        profile.priority = ((priority - IdlePriority) * (99 - 1) / TimeCriticalPriority) + 1;
+        profile.nice = 19 - ((priority - IdlePriority) * (19 + 20) / TimeCriticalPriority);
+        return profile;
+    }
+
+    static bool SetScheduling(DspSchedulingProfile const& profile, DspSchedulingProfile& effective)
+    {
+        bool applied = _SetScheduling(profile);
+
+        if (!applied && profile.fallback && profile.policy != DspSchedulingProfile::OtherPolicy)
+        {
+            _SetScheduling(DspSchedulingProfile(DspSchedulingProfile::OtherPolicy, 0, profile.nice));
+        }
+
+        GetScheduling(effective);
+        return applied;
+    }
+
+    static bool GetScheduling(DspSchedulingProfile& profile)
+    {
+        profile = DspSchedulingProfile(DspSchedulingProfile::OtherPolicy);
+
+#if defined(__linux__) && defined(SYS_sched_getattr)
+        _SchedAttr attr;
+        memset(&attr, 0, sizeof(attr));
+
+        if (syscall(SYS_sched_getattr, 0, &attr, sizeof(attr), 0) == 0)
+        {
+            profile.policy = _GetPolicy(attr.schedPolicy);
+            profile.priority = attr.schedPriority;
+            profile.nice = attr.schedNice;
+            if (profile.policy == DspSchedulingProfile::DeadlinePolicy)
+            {
+                profile.runtime = (unsigned long)(attr.schedRuntime / 1000);
+                profile.deadline = (unsigned long)(attr.schedDeadline / 1000);
+                profile.period = (unsigned long)(attr.schedPeriod / 1000);
+            }
+            return true;
+        }
+#endif
+
+        int policy;
+        struct sched_param param;
+
+        if (pthread_getschedparam(pthread_self(), &policy, &param) != 0)
+        {
+            return false;
+        }
+
+        profile.policy = _GetPolicy(policy);
+        profile.priority = param.sched_priority;
+        return true;
     }
 
     static void MsSleep(int milliseconds)
     {
-        usleep(milliseconds);
+        struct timespec duration;
+        duration.tv_sec = milliseconds / 1000;
+        duration.tv_nsec = (milliseconds % 1000) * 1000000L;
+
+        nanosleep(&duration, NULL);
+    }
+
+    static unsigned long long GetMonotonicTime()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return (unsigned long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    }
+
+    static int GetCpuCount()
+    {
+        long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+        return cpuCount > 0 ? (int)cpuCount : 1;
+    }
+
+    static bool SetAffinity(std::vector<int> const& cpus)
+    {
+#ifdef __linux__
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+
+        for (size_t i = 0; i < cpus.size(); i++)
+        {
+            if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE)
+            {
+                CPU_SET(cpus[i], &cpuSet);
+            }
+        }
+
+        // no CPUs: any CPU (the OS drops those the process may not use)
+        for (int i = 0; cpus.empty() && i < CPU_SETSIZE; i++)
+        {
+            CPU_SET(i, &cpuSet);
+        }
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+        return false;
+#endif
+    }
+
+    static bool GetAffinity(std::vector<int>& cpus)
+    {
+        cpus.clear();
+
+#ifdef __linux__
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+
+        if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) != 0)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < CPU_SETSIZE; i++)
+        {
+            if (CPU_ISSET(i, &cpuSet))
+            {
+                cpus.push_back(i);
+            }
+        }
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static bool GetNodeCpus(int numaNode, std::vector<int>& cpus)
+    {
+        cpus.clear();
+
+#ifdef __linux__
+        // parse the node's cpulist (E.g. "0-3,8-11")
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", numaNode);
+
+        FILE* file = fopen(path, "r");
+        if (file == NULL)
+        {
+            return false;
+        }
+
+        int first, last;
+        char separator;
+        while (fscanf(file, "%d", &first) == 1)
+        {
+            last = first;
+            separator = (char)fgetc(file);
+            if (separator == '-')
+            {
+                if (fscanf(file, "%d", &last) != 1)
+                {
+                    break;
+                }
+                separator = (char)fgetc(file);
+            }
+
+            for (int i = first; i <= last; i++)
+            {
+                cpus.push_back(i);
+            }
+
+            if (separator != ',')
+            {
+                break;
+            }
+        }
+
+        fclose(file);
+        return !cpus.empty();
+#else
+        return false;
+#endif
     }
 
 private:
     static void* _ThreadFunc(void* pv)
     {
-        (reinterpret_cast<DspThread*>(pv))->_Run();
+        DspThread* thread = reinterpret_cast<DspThread*>(pv);
+
+        // scheduling is applied by the thread itself, as some policies only apply to the caller
+        SetPriority(thread->_priority);
+
+        thread->_Run();
         return NULL;
     }
 
     virtual void _Run() = 0;
 
-    static void _SetPriority(pthread_t threadID, Priority priority)
+    // struct sched_attr (not declared by all C libraries)
+    struct _SchedAttr
     {
-        int policy;
-        struct sched_param param;
+        uint32_t size;
+        uint32_t schedPolicy;
+        uint64_t schedFlags;
+        int32_t schedNice;
+        uint32_t schedPriority;
+        uint64_t schedRuntime;
+        uint64_t schedDeadline;
+        uint64_t schedPeriod;
+    };
 
-        pthread_getschedparam(threadID, &policy, &param);
+    static DspSchedulingProfile::Policy _GetPolicy(int policy)
+    {
+        switch (policy)
+        {
+            case SCHED_FIFO:
+                return DspSchedulingProfile::FifoPolicy;
+            case SCHED_RR:
+                return DspSchedulingProfile::RoundRobinPolicy;
+            case SCHED_DEADLINE:
+                return DspSchedulingProfile::DeadlinePolicy;
+            default:
+                return DspSchedulingProfile::OtherPolicy;
+        }
+    }
 
-        policy = SCHED_FIFO;
-        param.sched_priority = ((priority - IdlePriority) * (99 - 1) / TimeCriticalPriority) + 1;
+    static bool _SetScheduling(DspSchedulingProfile const& profile)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
 
-        pthread_setschedparam(threadID, policy, &param);
+        switch (profile.policy)
+        {
+            case DspSchedulingProfile::InheritPolicy:
+                return true;
+
+            case DspSchedulingProfile::OtherPolicy:
+                if (pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) != 0)
+                {
+                    return false;
+                }
+#ifdef __linux__
+                // on Linux, nice values are per-thread
+                return setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), profile.nice) == 0;
+#else
+                return profile.nice == 0;
+#endif
+
+            case DspSchedulingProfile::RoundRobinPolicy:
+            case DspSchedulingProfile::FifoPolicy:
+            {
+                int policy = profile.policy == DspSchedulingProfile::FifoPolicy ? SCHED_FIFO : SCHED_RR;
+
+                param.sched_priority = profile.priority;
+                if (param.sched_priority < sched_get_priority_min(policy))
+                {
+                    param.sched_priority = sched_get_priority_min(policy);
+                }
+                if (param.sched_priority > sched_get_priority_max(policy))
+                {
+                    param.sched_priority = sched_get_priority_max(policy);
+                }
+
+                return pthread_setschedparam(pthread_self(), policy, &param) == 0;
+            }
+
+            case DspSchedulingProfile::DeadlinePolicy:
+            {
+#if defined(__linux__) && defined(SYS_sched_setattr)
+                _SchedAttr attr;
+                memset(&attr, 0, sizeof(attr));
+
+                attr.size = sizeof(attr);
+                attr.schedPolicy = SCHED_DEADLINE;
+                attr.schedRuntime = (uint64_t)profile.runtime * 1000;
+                attr.schedDeadline = (uint64_t)(profile.deadline != 0 ? profile.deadline : profile.period) * 1000;
+                attr.schedPeriod = (uint64_t)profile.period * 1000;
+
+                return syscall(SYS_sched_setattr, 0, &attr, 0) == 0;
+#else
+                return false;
+#endif
+            }
+        }
+
+        return false;
     }
 
 private:
     pthread_t _thread;
     bool _threadAttatched;
+    Priority _priority;
 };
 
 //=================================================================================================
@@ -117,9 +408,33 @@ private:
 class DspMutex
 {
 public:
-    DspMutex()
+    enum Option
     {
-        pthread_mutex_init(&_mutex, NULL);
+        PriorityInherit = 0x1,
+        AdaptiveSpin = 0x2
+    };
+
+    DspMutex(int options = 0, int spinCount = 1000)
+        : _spinCount(0)
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+
+#if defined(_POSIX_THREAD_PRIO_INHERIT) && _POSIX_THREAD_PRIO_INHERIT > 0
+        if (options & PriorityInherit)
+        {
+            pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+        }
+#endif
+
+        // spinning only pays off if the owner can run (and unlock) meanwhile
+        if (options & AdaptiveSpin && DspThread::GetCpuCount() > 1)
+        {
+            _spinCount = spinCount;
+        }
+
+        pthread_mutex_init(&_mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
     }
 
     virtual ~DspMutex()
@@ -129,6 +444,15 @@ public:
 
     void Lock()
     {
+        for (int i = 0; i < _spinCount; i++)
+        {
+            if (pthread_mutex_trylock(&_mutex) == 0)
+            {
+                return;
+            }
+            _CpuRelax();
+        }
+
         pthread_mutex_lock(&_mutex);
     }
 
@@ -137,9 +461,20 @@ public:
         pthread_mutex_unlock(&_mutex);
     }
 
+private:
+    static void _CpuRelax()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+        __asm__ __volatile__("pause");
+#elif defined(__aarch64__) || (defined(__arm__) && __ARM_ARCH >= 7)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
 private:
     friend class DspWaitCondition;
 
+    int _spinCount;
     pthread_mutex_t _mutex;
 };
 
@@ -174,4 +509,130 @@ private:
 
 //=================================================================================================
 
+class DspFutex
+{
+public:
+    DspFutex(int value = 0)
+        : _value(value)
+        , _waiters(0)
+    {
+#ifndef __linux__
+        pthread_mutex_init(&_mutex, NULL);
+        pthread_cond_init(&_cond, NULL);
+#endif
+    }
+
+    virtual ~DspFutex()
+    {
+#ifndef __linux__
+        pthread_cond_destroy(&_cond);
+        pthread_mutex_destroy(&_mutex);
+#endif
+    }
+
+    int Load() const
+    {
+        return _value.load(std::memory_order_acquire);
+    }
+
+    void Store(int value)
+    {
+        _value.store(value, std::memory_order_release);
+    }
+
+    bool CompareExchange(int expected, int desired)
+    {
+        return _value.compare_exchange_strong(expected, desired, std::memory_order_acq_rel);
+    }
+
+    void Wait(int value)
+    {
+        _waiters.fetch_add(1, std::memory_order_seq_cst);
+
+#ifdef __linux__
+        // the kernel only puts us to sleep if the value still equals "value"
+        syscall(SYS_futex, reinterpret_cast<int*>(&_value), FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+        pthread_mutex_lock(&_mutex);
+        if (_value.load(std::memory_order_acquire) == value)
+        {
+            pthread_cond_wait(&_cond, &_mutex);
+        }
+        pthread_mutex_unlock(&_mutex);
+#endif
+
+        _waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void WaitUntil(int value, unsigned long long time)
+    {
+        _waiters.fetch_add(1, std::memory_order_seq_cst);
+
+#ifdef __linux__
+        // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout
+        struct timespec deadline;
+        deadline.tv_sec = time / 1000000;
+        deadline.tv_nsec = (time % 1000000) * 1000;
+
+        syscall(SYS_futex, reinterpret_cast<int*>(&_value), FUTEX_WAIT_BITSET_PRIVATE, value, &deadline, NULL,
+                FUTEX_BITSET_MATCH_ANY);
+#else
+        unsigned long long now = DspThread::GetMonotonicTime();
+
+        if (time > now)
+        {
+            // the condition waits against the realtime clock
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+
+            unsigned long long nsec = deadline.tv_nsec + (time - now) * 1000;
+            deadline.tv_sec += nsec / 1000000000;
+            deadline.tv_nsec = nsec % 1000000000;
+
+            pthread_mutex_lock(&_mutex);
+            if (_value.load(std::memory_order_acquire) == value)
+            {
+                pthread_cond_timedwait(&_cond, &_mutex, &deadline);
+            }
+            pthread_mutex_unlock(&_mutex);
+        }
+#endif
+
+        _waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void WakeAll()
+    {
+        // pairs with the increment in Wait(): either we see the waiter, or it sees the new value
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (_waiters.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<int*>(&_value), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+        pthread_mutex_lock(&_mutex);
+        pthread_cond_broadcast(&_cond);
+        pthread_mutex_unlock(&_mutex);
+#endif
+    }
+
+private:
+    DspFutex(DspFutex const&);
+    DspFutex& operator=(DspFutex const&);
+
+    std::atomic<int> _value;
+    std::atomic<int> _waiters;
+
+#ifndef __linux__
+    pthread_mutex_t _mutex;
+    pthread_cond_t _cond;
+#endif
+};
+
+//=================================================================================================
+
 #endif  // DSPTHREADUNIX_H
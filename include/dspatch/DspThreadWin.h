@@ -27,8 +27,21 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 
 //-------------------------------------------------------------------------------------------------
 
+#include <dspatch/DspSchedulingProfile.h>
+
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0602  // WaitOnAddress() requires Windows 8
+#endif
+
 #include <windows.h>
 
+#include <atomic>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma comment(lib, "Synchronization.lib")  // WaitOnAddress()
+#endif
+
 //=================================================================================================
 
 class DspThread
@@ -36,11 +49,13 @@ class DspThread
 public:
     DspThread()
         : _threadHandle(NULL)
+        , _threadId(0)
     {
     }
 
     DspThread(DspThread const&)
         : _threadHandle(NULL)
+        , _threadId(0)
     {
     }
 
@@ -64,16 +79,23 @@ public:
 
     virtual void Start(Priority priority = NormalPriority)
     {
-        DWORD threadId;
-        _threadHandle = CreateThread(NULL, 0, _ThreadFunc, this, CREATE_SUSPENDED, &threadId);
+        _threadHandle = CreateThread(NULL, 0, _ThreadFunc, this, CREATE_SUSPENDED, &_threadId);
         SetThreadPriority(_threadHandle, priority);
         ResumeThread(_threadHandle);
     }
 
     virtual void Stop()
     {
-        CloseHandle(_threadHandle);
-        _threadHandle = NULL;
+        if (_threadHandle != NULL)
+        {
+            // a thread cannot join itself
+            if (_threadId != GetCurrentThreadId())
+            {
+                WaitForSingleObject(_threadHandle, INFINITE);
+            }
+            CloseHandle(_threadHandle);
+            _threadHandle = NULL;
+        }
     }
 
     static void SetPriority(Priority priority)
@@ -81,11 +103,146 @@ public:
         SetThreadPriority(GetCurrentThread(), priority);
     }
 
+    static DspSchedulingProfile GetPriorityProfile(Priority priority)
+    {
+        // Windows has no real-time policies per thread, so map priorities onto nice values only
+        DspSchedulingProfile profile(DspSchedulingProfile::OtherPolicy);
+        profile.nice = _GetNice(priority);
+        return profile;
+    }
+
+    static bool SetScheduling(DspSchedulingProfile const& profile, DspSchedulingProfile& effective)
+    {
+        bool applied = true;
+
+        switch (profile.policy)
+        {
+            case DspSchedulingProfile::InheritPolicy:
+                break;
+
+            case DspSchedulingProfile::OtherPolicy:
+                applied = SetThreadPriority(GetCurrentThread(), _GetPriority(profile.nice)) != 0;
+                break;
+
+            case DspSchedulingProfile::RoundRobinPolicy:
+            case DspSchedulingProfile::FifoPolicy:
+            case DspSchedulingProfile::DeadlinePolicy:
+                // not supported
+                applied = false;
+                if (profile.fallback)
+                {
+                    SetThreadPriority(GetCurrentThread(), _GetPriority(profile.nice));
+                }
+                break;
+        }
+
+        GetScheduling(effective);
+        return applied;
+    }
+
+    static bool GetScheduling(DspSchedulingProfile& profile)
+    {
+        int priority = GetThreadPriority(GetCurrentThread());
+
+        profile = DspSchedulingProfile(DspSchedulingProfile::OtherPolicy);
+        profile.nice = _GetNice(priority);
+
+        return priority != THREAD_PRIORITY_ERROR_RETURN;
+    }
+
     static void MsSleep(int milliseconds)
     {
         Sleep(milliseconds);
     }
 
+    static unsigned long long GetMonotonicTime()
+    {
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+
+        return (unsigned long long)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+               (unsigned long long)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+    }
+
+    static int GetCpuCount()
+    {
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        return systemInfo.dwNumberOfProcessors > 0 ? (int)systemInfo.dwNumberOfProcessors : 1;
+    }
+
+    static bool SetAffinity(std::vector<int> const& cpus)
+    {
+        DWORD_PTR mask = 0;
+        for (size_t i = 0; i < cpus.size(); i++)
+        {
+            if (cpus[i] >= 0 && cpus[i] < (int)(sizeof(DWORD_PTR) * 8))
+            {
+                mask |= (DWORD_PTR)1 << cpus[i];
+            }
+        }
+
+        // no CPUs: any CPU of the process
+        DWORD_PTR systemMask;
+        if (cpus.empty() && !GetProcessAffinityMask(GetCurrentProcess(), &mask, &systemMask))
+        {
+            return false;
+        }
+
+        return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+    }
+
+    static bool GetAffinity(std::vector<int>& cpus)
+    {
+        cpus.clear();
+
+        // there is no getter for a thread's affinity, so set the process mask and restore
+        DWORD_PTR processMask, systemMask;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+        {
+            return false;
+        }
+
+        DWORD_PTR mask = SetThreadAffinityMask(GetCurrentThread(), processMask);
+        if (mask == 0)
+        {
+            return false;
+        }
+        SetThreadAffinityMask(GetCurrentThread(), mask);
+
+        for (int i = 0; i < (int)(sizeof(DWORD_PTR) * 8); i++)
+        {
+            if (mask & ((DWORD_PTR)1 << i))
+            {
+                cpus.push_back(i);
+            }
+        }
+
+        return true;
+    }
+
+    static bool GetNodeCpus(int numaNode, std::vector<int>& cpus)
+    {
+        cpus.clear();
+
+        ULONGLONG mask;
+        if (numaNode < 0 || !GetNumaNodeProcessorMask((UCHAR)numaNode, &mask))
+        {
+            return false;
+        }
+
+        for (int i = 0; i < 64; i++)
+        {
+            if (mask & ((ULONGLONG)1 << i))
+            {
+                cpus.push_back(i);
+            }
+        }
+
+        return !cpus.empty();
+    }
+
 private:
     static DWORD WINAPI _ThreadFunc(LPVOID pv)
     {
@@ -95,8 +252,31 @@ private:
 
     virtual void _Run() = 0;
 
+    static int _GetNice(int priority)
+    {
+        return priority >= TimeCriticalPriority ? -20
+             : priority >= HighestPriority      ? -10
+             : priority >= HighPriority         ? -5
+             : priority >= NormalPriority       ? 0
+             : priority >= LowPriority          ? 5
+             : priority >= LowestPriority       ? 10
+                                                : 19;
+    }
+
+    static int _GetPriority(int nice)
+    {
+        return nice <= -20 ? TimeCriticalPriority
+             : nice <= -10 ? HighestPriority
+             : nice <= -5  ? HighPriority
+             : nice < 5    ? NormalPriority
+             : nice < 10   ? LowPriority
+             : nice < 19   ? LowestPriority
+                           : IdlePriority;
+    }
+
 private:
     HANDLE _threadHandle;
+    DWORD _threadId;
 };
 
 //=================================================================================================
@@ -104,14 +284,22 @@ private:
 class DspMutex
 {
 public:
-    DspMutex()
+    enum Option
     {
-        InitializeCriticalSection(&_cs);
+        PriorityInherit = 0x1,  // not supported (Windows boosts starved lock owners itself)
+        AdaptiveSpin = 0x2
+    };
+
+    DspMutex(int options = 0, int spinCount = 1000)
+        : _spinCount(options & AdaptiveSpin ? spinCount : 0)
+    {
+        InitializeCriticalSectionAndSpinCount(&_cs, _spinCount);
     }
 
-    DspMutex(DspMutex const&)
+    DspMutex(DspMutex const& other)
+        : _spinCount(other._spinCount)
     {
-        InitializeCriticalSection(&_cs);
+        InitializeCriticalSectionAndSpinCount(&_cs, _spinCount);
     }
 
     virtual ~DspMutex()
@@ -130,6 +318,7 @@ public:
     }
 
 private:
+    DWORD _spinCount;
     CRITICAL_SECTION _cs;
 };
 
@@ -175,4 +364,62 @@ private:
 
 //=================================================================================================
 
+class DspFutex
+{
+public:
+    DspFutex(int value = 0)
+        : _value(value)
+    {
+    }
+
+    virtual ~DspFutex()
+    {
+    }
+
+    int Load() const
+    {
+        return _value.load(std::memory_order_acquire);
+    }
+
+    void Store(int value)
+    {
+        _value.store(value, std::memory_order_release);
+    }
+
+    bool CompareExchange(int expected, int desired)
+    {
+        return _value.compare_exchange_strong(expected, desired, std::memory_order_acq_rel);
+    }
+
+    void Wait(int value)
+    {
+        // only sleeps if the value still equals "value"
+        WaitOnAddress(&_value, &value, sizeof(value), INFINITE);
+    }
+
+    void WaitUntil(int value, unsigned long long time)
+    {
+        unsigned long long now = DspThread::GetMonotonicTime();
+
+        if (time > now)
+        {
+            // WaitOnAddress() times out in whole milliseconds (rounded up here)
+            WaitOnAddress(&_value, &value, sizeof(value), (DWORD)((time - now + 999) / 1000));
+        }
+    }
+
+    void WakeAll()
+    {
+        WakeByAddressAll(&_value);
+    }
+
+private:
+    DspFutex(DspFutex const&);
+    DspFutex& operator=(DspFutex const&);
+
+    std::atomic<int> _value;
+};
+
+//=================================================================================================
+
 #endif  // DSPTHREADWIN_H
@@ -0,0 +1,76 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPTICKPACING_H
+#define DSPTICKPACING_H
+
+//=================================================================================================
+/// Pacing policy for an auto-tick thread
+
+/**
+A DspTickPacing selects how fast an engine's auto-tick thread ticks (see
+DspEngine::SetAutoTickPacing() and DspComponent::StartAutoTick()). "mode" selects one of:
+
+ - FreeRunning: tick again as soon as the last tick returns (the default). Suited to circuits
+   paced by a component that blocks, E.g. on an audio device.
+ - FixedRate: tick every "period" microseconds, as measured by the monotonic clock. Ticks are
+   scheduled at absolute times, such that timing errors do not accumulate. When a tick overruns
+   the next one, the ticks missed are dropped rather than run back to back.
+ - IdleBackoff: tick free-running for as long as ticks take at least "idleTime" microseconds (as
+   they do when a component blocks), but sleep after every shorter (idle) tick. The first sleep
+   lasts "minBackoff" microseconds, doubling with every consecutive idle tick up to "maxBackoff",
+   hence a circuit that has nothing to wait for ticks at least every "maxBackoff" microseconds.
+
+The auto-tick thread sleeps on its pause / stop state, hence pausing or stopping auto-tick never
+waits for a sleep to run out.
+*/
+
+struct DspTickPacing
+{
+    enum Mode
+    {
+        FreeRunning,
+        FixedRate,
+        IdleBackoff
+    };
+
+    DspTickPacing(Mode newMode = FreeRunning, unsigned long newPeriod = 0)
+        : mode(newMode)
+        , period(newPeriod)
+        , idleTime(50)
+        , minBackoff(100)
+        , maxBackoff(10000)
+    {
+    }
+
+    Mode mode;
+    unsigned long period;
+    unsigned long idleTime;
+    unsigned long minBackoff;
+    unsigned long maxBackoff;
+};
+
+//=================================================================================================
+
+#endif  // DSPTICKPACING_H
@@ -0,0 +1,211 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPTICKSOURCE_H
+#define DSPTICKSOURCE_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <vector>
+
+#include <dspatch/DspThread.h>
+
+class DspComponent;
+
+//=================================================================================================
+/// Abstract base class for anything that drives a component's ticks
+
+/**
+Rather than being auto-ticked by an engine's free-running (or paced) thread, a component (usually a
+DspCircuit) can be ticked whenever some external event occurs, by attaching it to a DspTickSource.
+Three sources are provided: DspCallbackTickSource ticks from within a callback (E.g. an audio device
+callback), DspTimerTickSource ticks on a timer, and DspFdTickSource ticks whenever a file
+descriptor becomes readable.
+
+Attach() selects the component to tick. Only a component that is neither part of a circuit nor
+auto-ticking may be attached, and while attached it can neither be auto-ticked nor added to a
+circuit. Start() then starts the source, and Stop() stops it. On every event, the source calls the
+component's Tick() and Reset() methods, just as an auto-tick thread would. GetTickCount() returns
+the number of ticks issued since the source was last started.
+
+Ticks from a source are held off by the component's PauseAutoTick() (hence also by every circuit
+edit, see DspCircuit), exactly like auto-ticks are. A pause waits for the tick in flight to finish,
+after which sources with a thread of their own wait to be resumed, while callback ticks are skipped
+(a callback must never block).
+
+Derived classes implement Start_() and Stop_(), and call Tick_() on every event. Sources that need
+a thread of their own call StartThread_() and StopThread_(), and implement Run_(), which should
+return once IsStarted() is false. WaitUntil_() sleeps until a given time or until the source is
+stopped. As the base destructor cannot call Stop_(), derived destructors must call Stop().
+*/
+
+class DLLEXPORT DspTickSource
+{
+public:
+    DspTickSource();
+    virtual ~DspTickSource();
+
+    bool Attach(DspComponent* component);
+    bool Attach(DspComponent& component);
+    void Detach();
+    DspComponent* GetComponent() const;
+
+    bool Start();
+    void Stop();
+    bool IsStarted() const;
+
+    unsigned long GetTickCount() const;
+
+protected:
+    virtual bool Start_() = 0;
+    virtual void Stop_() = 0;
+    virtual void Run_();
+
+    bool Tick_(bool waitIfPaused);
+
+    bool StartThread_(DspThread::Priority priority);
+    void StopThread_();
+    bool WaitUntil_(unsigned long long time);
+
+private:
+    DspTickSource(DspTickSource const&);
+    DspTickSource& operator=(DspTickSource const&);
+
+    void _Pause();
+    void _Resume();
+    void _SetState(int set, int clear);
+
+private:
+    friend class DspCircuit;
+    friend class DspComponent;
+
+    class _Thread;
+
+    enum _State
+    {
+        _Idle = 0,
+        _Ticking = 1,  // state bits
+        _Paused = 2,
+        _Stopped = 4
+    };
+
+    DspComponent* _component;
+    DspFutex _state;
+    int _pauseCount;
+    std::atomic<unsigned long> _tickCount;
+    _Thread* _thread;
+};
+
+//=================================================================================================
+/// Tick source driven by an external callback
+
+/**
+A DspCallbackTickSource ticks its component from within an external callback (E.g. an audio device
+callback, see the DspAudioDevice example component): the callback simply calls Tick(). Tick()
+returns false when the tick was skipped, as the source is stopped, nothing is attached, or ticks
+are paused. Tick() never blocks other than for the tick itself.
+*/
+
+class DLLEXPORT DspCallbackTickSource : public DspTickSource
+{
+public:
+    DspCallbackTickSource();
+    ~DspCallbackTickSource();
+
+    bool Tick();
+
+protected:
+    virtual bool Start_();
+    virtual void Stop_();
+};
+
+//=================================================================================================
+/// Tick source driven by a timer
+
+/**
+A DspTimerTickSource ticks its component every "period" microseconds from a thread of its own,
+started at the priority given. Ticks are scheduled at absolute times of the monotonic clock, such
+that timing errors do not accumulate, and ticks missed (as a tick overran the next) are dropped
+rather than run back to back. The period may only be changed while the source is stopped.
+*/
+
+class DLLEXPORT DspTimerTickSource : public DspTickSource
+{
+public:
+    DspTimerTickSource(unsigned long period = 1000, DspThread::Priority priority = DspThread::TimeCriticalPriority);
+    ~DspTimerTickSource();
+
+    void SetPeriod(unsigned long period);
+    unsigned long GetPeriod() const;
+
+protected:
+    virtual bool Start_();
+    virtual void Stop_();
+    virtual void Run_();
+
+private:
+    unsigned long _period;
+    DspThread::Priority _priority;
+};
+
+//=================================================================================================
+/// Tick source driven by file descriptor readiness
+
+/**
+A DspFdTickSource ticks its component whenever at least one of its file descriptors is readable
+(E.g. a socket, pipe, timerfd or MIDI device), waiting for readiness in a thread of its own via
+epoll. One tick is issued per wake up, however many descriptors are ready. Readiness is
+level-triggered, hence the component must drain (or remove) the descriptors it is ticked for,
+otherwise it is ticked again straight away. Descriptors may be added and removed at any time.
+
+DspFdTickSource is only available on Linux. Elsewhere Start() fails.
+*/
+
+class DLLEXPORT DspFdTickSource : public DspTickSource
+{
+public:
+    DspFdTickSource(DspThread::Priority priority = DspThread::TimeCriticalPriority);
+    ~DspFdTickSource();
+
+    bool AddFd(int fd);
+    bool RemoveFd(int fd);
+    int GetFdCount() const;
+
+protected:
+    virtual bool Start_();
+    virtual void Stop_();
+    virtual void Run_();
+
+private:
+    std::vector<int> _fds;
+    mutable DspMutex _fdsMutex;
+    DspThread::Priority _priority;
+    int _epollFd;
+    int _stopFd;
+};
+
+//=================================================================================================
+
+#endif  // DSPTICKSOURCE_H
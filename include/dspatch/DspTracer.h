@@ -0,0 +1,117 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#ifndef DSPTRACER_H
+#define DSPTRACER_H
+
+//-------------------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <ostream>
+#include <string>
+
+#include <dspatch/DspThread.h>
+
+class DspComponent;
+
+//=================================================================================================
+/// Timeline tracing of tick execution
+
+/**
+Between Start() and Stop(), the DspTracer records when each thread executes what: every circuit
+thread tick ("Tick"), every Process_() call (named after its component), every wait for another
+circuit thread to hand a component over ("Wait", see DspCircuit::SetThreadCount()) or for a
+streamed stage to become ready (see DspCircuit::Stream()), every wait for a circuit thread to sync
+("Sync"), and every graph edit, from PauseAutoTick() to its ResumeAutoTick() ("Edit", a single span
+per outermost call: edits made within it are part of it). Waits are only recorded when a thread
+actually had to wait.
+
+Each thread records into a ring buffer of its own, keeping the latest 32768 events, hence recording
+takes no locks (a thread's ring is allocated on the first event it records). Start() discards the
+events of any previous trace. While not tracing, the engine pays a single (predictable) branch per
+Process_() call and wait.
+
+WriteChromeTrace() writes the events recorded as Chrome trace-event JSON, and SaveChromeTrace()
+writes them to a file (returning false if it could not be written). Traces load into
+chrome://tracing as well as the Perfetto UI, with one track per thread, showing how the circuit
+threads interleave and where they stall. Both may be called while tracing, in which case events
+overwritten whilst being written are left out.
+*/
+
+class DLLEXPORT DspTracer
+{
+public:
+    static void Start();
+    static void Stop();
+
+    static bool IsTracing()
+    {
+        return _tracing.load(std::memory_order_relaxed);
+    }
+
+    static void WriteChromeTrace(std::ostream& stream);
+    static bool SaveChromeTrace(std::string const& filePath);
+
+private:
+    friend class DspCircuit;
+    friend class DspCircuitThread;
+    friend class DspComponent;
+
+    enum _EventType
+    {
+        _TickEvent,
+        _ProcessEvent,
+        _WaitEvent,
+        _SyncEvent,
+        _EditBegin,
+        _EditEnd
+    };
+
+    struct _Event;
+    struct _Ring;
+    struct _State;
+    class _RingOwner;
+
+    static const int _ringSize = 32768;
+
+    static _State& _GetState();
+
+    static unsigned long long _GetTime();
+    static void _RecordComponent(_EventType type, DspComponent* component, unsigned long long start, unsigned long long end);
+    static void _RecordThread(_EventType type, int threadNo, unsigned long long start, unsigned long long end);
+    static void _Record(_EventType type, int id, unsigned long long start, unsigned long long end);
+
+    static _Ring* _AddRing();
+    static void _RetireRing(_Ring* ring);
+    static int _AddName(DspComponent* component);
+    static void _Rename(DspComponent* component);
+    static void _WriteString(std::ostream& stream, std::string const& string);
+    static void _WriteTime(std::ostream& stream, unsigned long long time);
+
+    static std::atomic<bool> _tracing;
+};
+
+//=================================================================================================
+
+#endif  // DSPTRACER_H
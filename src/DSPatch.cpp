@@ -26,90 +26,25 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 
 //=================================================================================================
 
-DspCircuit* DSPatch::_globalCircuit = new DspCircuit();
-
-//=================================================================================================
-
-void DSPatch::SetGlobalThreadCount(int threadCount)
+int DSPatch::SetGlobalThreadCount(int threadCount)
 {
-    if (_globalCircuit != NULL)
-    {
-        _globalCircuit->SetThreadCount(threadCount);
-    }
+    return GetGlobalEngine().SetRootThreadCount(threadCount);
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DSPatch::Finalize()
+DspEngine& DSPatch::GetGlobalEngine()
 {
-    delete _globalCircuit;
-    _globalCircuit = NULL;
-}
-
-//=================================================================================================
-
-bool DSPatch::_IsThisGlobalCircuit(DspComponent const* thisComponent)
-{
-    if (_globalCircuit != NULL)
-    {
-        return _globalCircuit == thisComponent;
-    }
-
-    return false;
-}
-
-//-------------------------------------------------------------------------------------------------
-
-bool DSPatch::_AddGlobalComponent(DspComponent* component)
-{
-    if (_globalCircuit != NULL)
-    {
-        return _globalCircuit->AddComponent(component);
-    }
-
-    return false;
+    // never deleted: circuits (and their threads) may outlive Finalize()
+    static DspEngine* globalEngine = new DspEngine();
+    return *globalEngine;
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DSPatch::_RemoveGlobalComponent(DspComponent const* component)
-{
-    if (_globalCircuit != NULL)
-    {
-        return _globalCircuit->RemoveComponent(component);
-    }
-}
-
-//-------------------------------------------------------------------------------------------------
-
-int DSPatch::_GetGlobalComponentCount()
-{
-    if (_globalCircuit != NULL)
-    {
-        return _globalCircuit->GetComponentCount();
-    }
-
-    return 0;
-}
-
-//-------------------------------------------------------------------------------------------------
-
-void DSPatch::_StartGlobalAutoTick()
-{
-    if (_globalCircuit != NULL)
-    {
-        _globalCircuit->StartAutoTick();
-    }
-}
-
-//-------------------------------------------------------------------------------------------------
-
-void DSPatch::_StopGlobalAutoTick()
+void DSPatch::Finalize()
 {
-    if (_globalCircuit != NULL)
-    {
-        _globalCircuit->StopAutoTick();
-    }
+    GetGlobalEngine()._Finalize();
 }
 
 //=================================================================================================
@@ -0,0 +1,145 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <dspatch/DspArena.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//=================================================================================================
+
+DspArena::DspArena(size_t blockSize, int blocksPerChunk, int numaNode)
+    : _blockSize((blockSize + CacheLineSize - 1) / CacheLineSize * CacheLineSize)
+    , _blocksPerChunk(blocksPerChunk > 0 ? blocksPerChunk : 1)
+    , _numaNode(numaNode)
+    , _nextBlock(NULL)
+    , _chunkEnd(NULL)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspArena::~DspArena()
+{
+    for (size_t i = 0; i < _chunks.size(); i++)
+    {
+        delete[] _chunks[i];
+    }
+}
+
+//=================================================================================================
+
+void* DspArena::Allocate()
+{
+    // reuse a freed block if there is one
+    if (!_freeBlocks.empty())
+    {
+        void* block = _freeBlocks.back();
+        _freeBlocks.pop_back();
+        return block;
+    }
+
+    // otherwise carve the next block from the current chunk (allocating a new chunk if required)
+    if (_nextBlock == _chunkEnd)
+    {
+        size_t chunkSize = _blockSize * _blocksPerChunk;
+        size_t alignment = CacheLineSize;
+
+#ifdef __linux__
+        // node bound chunks occupy whole pages
+        if (_numaNode >= 0)
+        {
+            alignment = sysconf(_SC_PAGESIZE);
+            chunkSize = (chunkSize + alignment - 1) / alignment * alignment;
+        }
+#endif
+
+        char* chunk = new char[chunkSize + alignment];
+        _chunks.push_back(chunk);
+
+        _nextBlock = reinterpret_cast<char*>(
+            (reinterpret_cast<size_t>(chunk) + alignment - 1) & ~(alignment - 1));
+        _chunkEnd = _nextBlock + _blockSize * _blocksPerChunk;
+
+        if (_numaNode >= 0)
+        {
+            _BindToNode(_nextBlock, chunkSize);
+        }
+    }
+
+    void* block = _nextBlock;
+    _nextBlock += _blockSize;
+    return block;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspArena::Free(void* block)
+{
+    if (block != NULL)
+    {
+        _freeBlocks.push_back(block);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+size_t DspArena::GetBlockSize() const
+{
+    return _blockSize;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspArena::GetNumaNode() const
+{
+    return _numaNode;
+}
+
+//=================================================================================================
+
+void DspArena::_BindToNode(char* memory, size_t size)
+{
+#ifdef __linux__
+    // mbind(MPOL_PREFERRED, MPOL_MF_MOVE): prefer the node for these pages, moving any already touched
+    static const int mpolPreferred = 1;
+    static const unsigned mpolMfMove = 1 << 1;
+    static const int maxNodes = 1024;
+
+    if (_numaNode < maxNodes)
+    {
+        unsigned long nodeMask[maxNodes / (8 * sizeof(unsigned long))] = {0};
+        nodeMask[_numaNode / (8 * sizeof(unsigned long))] |= 1UL << (_numaNode % (8 * sizeof(unsigned long)));
+
+        syscall(SYS_mbind, memory, size, mpolPreferred, nodeMask, maxNodes, mpolMfMove);
+    }
+#else
+    (void)memory;
+    (void)size;
+#endif
+}
+
+//=================================================================================================
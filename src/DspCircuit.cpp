@@ -22,16 +22,128 @@ but WITHOUT ANY WARRANTY; without even the implied warranty of
 MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 ************************************************************************/
 
+#include <DSPatch.h>
 #include <dspatch/DspCircuit.h>
 #include <dspatch/DspCircuitThread.h>
+#include <dspatch/DspTickSource.h>
 #include <dspatch/DspWire.h>
 
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+//=================================================================================================
+// applies the thread count changes decided by the tuner (see DspCircuit::_ScaleThreads()), as
+// starting and stopping threads and allocating their thread states must not hold up the ticking
+// thread
+
+class DspCircuit::_ThreadScaler : public DspThread
+{
+public:
+    _ThreadScaler(DspCircuit* circuit)
+        : _circuit(circuit)
+        , _request(_Idle)
+    {
+    }
+
+    ~_ThreadScaler()
+    {
+        Stop();
+    }
+
+    virtual void Stop()
+    {
+        // take no more requests, and take back a change waiting on a tick (see _LockThreadCount())
+        int request;
+        while (!_request.CompareExchange(request = _request.Load(), _Stopping))
+        {
+        }
+        _request.WakeAll();
+
+        _circuit->_LockThreadCount();
+        _circuit->_UnlockThreadCount();
+
+        DspThread::Stop();
+    }
+
+    // called by the ticking thread: never blocks, fails if the last change is still under way
+    bool Post(DspThreadScalingStats::Decision const& decision)
+    {
+        if (_request.Load() != _Idle)
+        {
+            return false;
+        }
+
+        _decision = decision;
+
+        if (!_request.CompareExchange(_Idle, _Posted))
+        {
+            return false;
+        }
+        _request.WakeAll();
+
+        return true;
+    }
+
+    bool IsIdle() const
+    {
+        return _request.Load() == _Idle;
+    }
+
+    bool IsStopping() const
+    {
+        return _request.Load() == _Stopping;
+    }
+
+private:
+    enum _Request
+    {
+        _Idle,
+        _Posted,
+        _Stopping
+    };
+
+    virtual void _Run()
+    {
+        int request;
+        while ((request = _request.Load()) != _Stopping)
+        {
+            if (request == _Idle)
+            {
+                _request.Wait(_Idle);
+                continue;
+            }
+
+            _circuit->_ApplyThreadScaling(_decision);
+
+            _request.CompareExchange(_Posted, _Idle);
+            _request.WakeAll();
+        }
+    }
+
+private:
+    DspCircuit* _circuit;
+    DspFutex _request;
+    DspThreadScalingStats::Decision _decision;  // written by Post() while idle
+};
+
 //=================================================================================================
 
-DspCircuit::DspCircuit(int threadCount)
-    : _currentThreadIndex(0)
+DspCircuit::DspCircuit(int threadCount, DspEngine* engine)
+    : _threadStateArena(_GetThreadStateSize())
+    , _engine(engine)
+    , _currentThreadIndex(0)
     , _inToInWires(true)
     , _outToOutWires(false)
+    , _renderSink(NULL)
+    , _renderTickNo(0)
+    , _renderStopped(false)
+    , _streamTickCount(0)
+    , _streamDepth(0)
+    , _streamStopped(false)
+    , _threadScalingEnabled(false)
+    , _threadScalingChanged(false)
+    , _threadScaler(NULL)
 {
     SetThreadCount(threadCount);
 }
@@ -41,49 +153,384 @@ DspCircuit::DspCircuit(int threadCount)
 DspCircuit::~DspCircuit()
 {
     StopAutoTick();
+
+    delete _threadScaler;
+
     RemoveAllComponents();
     SetThreadCount(0);
+
+    // delete components created by Clone()
+    for (size_t i = 0; i < _ownedComponents.size(); i++)
+    {
+        delete _ownedComponents[i];
+    }
+
+    for (size_t i = 0; i < _nodeArenas.size(); i++)
+    {
+        delete _nodeArenas[i];
+    }
 }
 
 //=================================================================================================
 
-void DspCircuit::SetThreadCount(int threadCount)
+int DspCircuit::SetThreadCount(int threadCount)
 {
     if ((size_t)threadCount != _circuitThreads.size())
     {
-        PauseAutoTick();
+        // no pause: only the threads added or retired are started or stopped (see _SetThreadCount())
+        _SetThreadCount(threadCount);
+    }
+
+    return GetThreadCount();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspCircuit::SetThreadCount(int threadCount, DspThreadPlacement const& placement)
+{
+    PauseAutoTick();
+
+    // release all threads and thread states, then place them anew
+    _SetThreadCount(0);
+    _placement = placement;
+    _SetThreadCount(threadCount);
+
+    ResumeAutoTick();
+
+    return GetThreadCount();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspCircuit::GetThreadCount() const
+{
+    return _circuitThreads.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspThreadPlacement DspCircuit::GetThreadPlacement() const
+{
+    return _placement;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCircuit::GetThreadAffinity(int threadNo, std::vector<int>& cpus)
+{
+    if (threadNo < 0 || (size_t)threadNo >= _circuitThreads.size())
+    {
+        cpus.clear();
+        return false;
+    }
+
+    return _circuitThreads[threadNo]->GetThreadAffinity(cpus);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::SetSchedulingProfile(DspSchedulingProfile const& profile)
+{
+    PauseAutoTick();
+
+    // restart all threads with the new profile
+    int threadCount = _circuitThreads.size();
+
+    _SetThreadCount(0);
+    _scheduling = profile;
+    _SetThreadCount(threadCount);
+
+    ResumeAutoTick();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspSchedulingProfile DspCircuit::GetSchedulingProfile() const
+{
+    return _scheduling;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCircuit::GetThreadScheduling(int threadNo, DspSchedulingProfile& effective)
+{
+    if (threadNo < 0 || (size_t)threadNo >= _circuitThreads.size())
+    {
+        effective = DspSchedulingProfile();
+        return false;
+    }
+
+    return _circuitThreads[threadNo]->GetThreadScheduling(effective);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::SetThreadScaling(DspThreadScaling const& scaling)
+{
+    _threadScalingMutex.Lock();
+    _threadScaling = scaling;
+    _threadScalingMutex.Unlock();
+
+    // the tuner's changes are applied on a thread of its own, started with the tuner
+    if (scaling.IsEnabled() && _threadScaler == NULL)
+    {
+        _threadScaler = new _ThreadScaler(this);
+        _threadScaler->Start(DspThread::NormalPriority);
+    }
+
+    // the ticking thread picks the new configuration up on its next tick
+    _threadScalingChanged.store(true, std::memory_order_release);
+    _threadScalingEnabled.store(scaling.IsEnabled(), std::memory_order_release);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspThreadScaling DspCircuit::GetThreadScaling() const
+{
+    _threadScalingMutex.Lock();
+    DspThreadScaling scaling = _threadScaling;
+    _threadScalingMutex.Unlock();
+
+    return scaling;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspThreadScalingStats DspCircuit::GetThreadScalingStats() const
+{
+    _threadScalingMutex.Lock();
+    DspThreadScalingStats stats = _threadScalingStats;
+    _threadScalingMutex.Unlock();
 
-        // stop all threads
-        for (size_t i = 0; i < _circuitThreads.size(); i++)
+    return stats;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::SetEngine(DspEngine* engine)
+{
+    if (engine != _engine)
+    {
+        // return all threads to the current engine and lease them again from the new one
+        int threadCount = _circuitThreads.size();
+
+        SetThreadCount(0);
+        _engine = engine;
+        SetThreadCount(threadCount);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspEngine* DspCircuit::GetEngine() const
+{
+    if (_engine != NULL)
+    {
+        return _engine;
+    }
+    else if (_parentCircuit != NULL)
+    {
+        return _parentCircuit->GetEngine();
+    }
+    else
+    {
+        return &DSPatch::GetGlobalEngine();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspCircuit* DspCircuit::Clone()
+{
+    PauseAutoTick();
+    DspCircuit* circuit = static_cast<DspCircuit*>(_Clone());
+    ResumeAutoTick();
+
+    return circuit;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspCircuit::Render(unsigned long tickCount, DspRenderSink* sink)
+{
+    // only a circuit ticked by nothing else can be rendered (N.B. an auto-ticked circuit is routed
+    // within its engine's root circuit)
+    if (_parentCircuit != NULL || _GetTickSource() != NULL)
+    {
+        return 0;
+    }
+
+    _renderSink = sink;
+    _renderTickNo = 0;
+    _renderStopped = false;
+
+    unsigned long ticksProcessed = 0;
+
+    while (ticksProcessed < tickCount && !_renderStopped)
+    {
+        if (_circuitThreads.size() == 0)
+        {
+            Tick();
+
+            if (sink != NULL)
+            {
+                _renderStopped = !sink->Consume(_renderTickNo, _outputBus);
+            }
+            _renderTickNo++;
+
+            Reset();
+
+            ticksProcessed++;
+        }
+        else
+        {
+            // (the thread count auto-tuner may have added threads during the last tick)
+            ticksProcessed += _RenderThreads(tickCount - ticksProcessed);
+        }
+    }
+
+    _renderSink = NULL;
+
+    return ticksProcessed;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspCircuit::Render(unsigned long tickCount, DspRenderSink& sink)
+{
+    return Render(tickCount, &sink);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspCircuit::TickN(unsigned long tickCount)
+{
+    return Render(tickCount, NULL);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspCircuit::Stream(unsigned long tickCount, DspRenderSink* sink, int queueDepth)
+{
+    // only a circuit ticked by nothing else can be streamed (see Render())
+    if (_parentCircuit != NULL || _GetTickSource() != NULL || tickCount == 0)
+    {
+        return 0;
+    }
+
+    // wait for the ticks still in flight from earlier Tick()s
+    for (size_t i = 0; i < _circuitThreads.size(); i++)
+    {
+        _circuitThreads[i]->Sync();
+    }
+
+    // components wired to components outside this circuit are ticked along with them instead
+    if (!_LinkStreamStages(sink))
+    {
+        return Render(tickCount, sink);
+    }
+
+    _renderSink = sink;
+    _streamTickCount = tickCount;
+    _streamDepth = std::max(2, queueDepth);
+    _streamStopped.store(false);
+
+    // every component's thread states become the queue of its outputs: a ring of buses, one per
+    // tick, initially holding the outputs of the last tick (as tick -1, read by feedback wires).
+    // With circuit threads, the last tick's outputs are in the thread state of the thread before
+    // the one to tick next (kept alive until the old thread states are freed below)
+    std::vector<DspComponent::_ThreadState*> threadStates;
+    int threadCount = _circuitThreads.size();
+
+    for (size_t i = 0; i < _components.size(); i++)
+    {
+        DspComponent* component = _components[i];
+
+        DspSignalBus* lastOutputs = &component->_outputBus;
+        if (threadCount > 0)
         {
-            _circuitThreads[i].Stop();
+            lastOutputs = &component->_threadStates[(_currentThreadIndex + threadCount - 1) % threadCount]->outputBus;
         }
 
-        // resize thread array
-        _circuitThreads.resize(threadCount);
+        component->_GetThreadStates(_streamDepth, threadStates);
+        component->_SwapThreadStates(threadStates, 0);
 
-        // initialise and start all threads
-        for (size_t i = 0; i < _circuitThreads.size(); i++)
+        if (lastOutputs != &component->_threadStates[_streamDepth - 1]->outputBus)
         {
-            _circuitThreads[i].Initialise(&_components, i);
-            _circuitThreads[i].Start();
+            DspComponent::_CopySignals(*lastOutputs, component->_threadStates[_streamDepth - 1]->outputBus);
         }
 
-        // set all components to the new thread count
-        for (size_t i = 0; i < _components.size(); i++)
+        DspComponent::_FreeThreadStates(threadStates, _streamDepth);
+    }
+
+    // process the stages on this thread along with the circuit threads
+    for (size_t i = 0; i < _circuitThreads.size(); i++)
+    {
+        _circuitThreads[i]->Stream(this);
+    }
+
+    _StreamWork(0);
+
+    for (size_t i = 0; i < _circuitThreads.size(); i++)
+    {
+        _circuitThreads[i]->Sync();
+    }
+
+    unsigned long ticksProcessed = sink != NULL ? _streamStages.back()->tickCount.load() : tickCount;
+
+    // go back to a set of buses per circuit thread, handing the outputs of the streamed ticks to
+    // the threads as if they had ticked them: the thread to tick next gets those of the tick the
+    // thread count before it, on up to the thread before it, which gets the last tick's (without
+    // circuit threads, the component itself gets the last tick's)
+    for (size_t i = 0; i < _components.size(); i++)
+    {
+        DspComponent* component = _components[i];
+        unsigned long ticksStreamed = _streamStages[i]->tickCount.load();
+        unsigned long lastTickNo = ticksStreamed + _streamDepth - 1;
+        unsigned long maxTicksBack = std::min((unsigned long)_streamDepth - 1, ticksStreamed);
+
+        if (threadCount == 0)
         {
-            _components[i]->_SetBufferCount(threadCount);
+            DspComponent::_CopySignals(component->_threadStates[lastTickNo % _streamDepth]->outputBus, component->_outputBus);
         }
 
-        ResumeAutoTick();
+        // the buses holding the outputs are reused by other threads, so the outputs are copied out
+        std::vector<DspSignalBus> threadOutputs;
+
+        for (int j = 0; j < threadCount; j++)
+        {
+            int ticksAhead = (j - _currentThreadIndex + threadCount) % threadCount;
+            unsigned long ticksBack = std::min((unsigned long)(threadCount - 1 - ticksAhead), maxTicksBack);
+
+            threadOutputs.push_back(component->_threadStates[(lastTickNo - ticksBack) % _streamDepth]->outputBus);
+        }
+
+        component->_GetThreadStates(threadCount, threadStates);
+        component->_SwapThreadStates(threadStates, _currentThreadIndex);
+        DspComponent::_FreeThreadStates(threadStates, threadCount);
+
+        for (int j = 0; j < threadCount; j++)
+        {
+            DspComponent::_CopySignals(threadOutputs[j], component->_threadStates[j]->outputBus);
+        }
     }
+
+    for (size_t i = 0; i < _streamStages.size(); i++)
+    {
+        delete _streamStages[i];
+    }
+    _streamStages.clear();
+
+    _renderSink = NULL;
+
+    return ticksProcessed;
 }
 
 //-------------------------------------------------------------------------------------------------
 
-int DspCircuit::GetThreadCount() const
+unsigned long DspCircuit::Stream(unsigned long tickCount, DspRenderSink& sink, int queueDepth)
 {
-    return _circuitThreads.size();
+    return Stream(tickCount, &sink, queueDepth);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -106,6 +553,10 @@ bool DspCircuit::AddComponent(DspComponent* component, std::string const& compon
         {
             return false;  // if the component is already part of another circuit
         }
+        if (component->_tickSource != NULL)
+        {
+            return false;  // if the component is ticked by a tick source
+        }
         if (_FindComponent(component, componentIndex))
         {
             return false;  // if the component is already in the array
@@ -115,13 +566,15 @@ bool DspCircuit::AddComponent(DspComponent* component, std::string const& compon
             return false;  // if the component name is already in the array
         }
 
-        // components within the circuit need to have as many buffers as there are threads in the circuit
         component->_SetParentCircuit(this);
-        component->_SetBufferCount(_circuitThreads.size());
         component->SetComponentName(compName);
 
         PauseAutoTick();
+
+        // components within the circuit need to have as many buffers as there are threads in the circuit
+        component->_SetBufferCount(_circuitThreads.size());
         _components.push_back(component);
+
         ResumeAutoTick();
 
         return true;
@@ -270,6 +723,27 @@ void DspCircuit::Process_(DspSignalBus& inputs, DspSignalBus& outputs)
     DspWire* wire;
     DspSignal* signal;
 
+    // time this tick for the thread count auto-tuner
+    typedef std::chrono::steady_clock Clock;
+    bool scaling = _threadScalingEnabled.load(std::memory_order_acquire);
+    Clock::time_point tickStart;
+
+    if (scaling)
+    {
+        tickStart = Clock::now();
+    }
+
+    // take over a pending thread count change at this tick boundary (claiming the tuner's first,
+    // such that it can no longer be taken back)
+    int threadCountChange = _threadCountChange.Load();
+    if (threadCountChange == 1 || (threadCountChange == 2 && _threadCountChange.CompareExchange(2, 1)))
+    {
+        _SwapThreads();
+
+        _threadCountChange.Store(0);
+        _threadCountChange.WakeAll();
+    }
+
     // process in a single thread if this circuit has no threads
     // =========================================================
     if (_circuitThreads.size() == 0)
@@ -306,7 +780,7 @@ void DspCircuit::Process_(DspSignalBus& inputs, DspSignalBus& outputs)
     // ======================================================
     else
     {
-        _circuitThreads[_currentThreadIndex].Sync();  // sync with thread x
+        _circuitThreads[_currentThreadIndex]->Sync();  // sync with thread x
 
         // set all circuit outputs from connected internal component outputs
         for (int i = 0; i < _outToOutWires.GetWireCount(); i++)
@@ -324,14 +798,95 @@ void DspCircuit::Process_(DspSignalBus& inputs, DspSignalBus& outputs)
             wire->linkedComponent->_SetInputSignal(wire->toSignalIndex, _currentThreadIndex, signal);
         }
 
-        _circuitThreads[_currentThreadIndex].Resume();  // resume thread x
+        _circuitThreads[_currentThreadIndex]->Resume();  // resume thread x
 
         if ((size_t)++_currentThreadIndex >= _circuitThreads.size())  // shift to thread x+1
         {
             _currentThreadIndex = 0;
         }
     }
-}
+
+    if (scaling)
+    {
+        _ScaleThreads(std::chrono::duration<double, std::micro>(Clock::now() - tickStart).count());
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspComponent* DspCircuit::Clone_()
+{
+    DspCircuit* circuit = new DspCircuit(_circuitThreads.size(), _engine);
+
+    // replicate circuit IO
+    for (int i = 0; i < _inputBus.GetSignalCount(); i++)
+    {
+        circuit->AddInput_(_inputBus.GetSignal(i)->GetSignalName());
+    }
+    for (int i = 0; i < _outputBus.GetSignalCount(); i++)
+    {
+        circuit->AddOutput_(_outputBus.GetSignal(i)->GetSignalName());
+    }
+
+    // clone all internal components
+    std::map<DspComponent const*, DspComponent*> clones;
+
+    circuit->_components.reserve(_components.size());
+    circuit->_ownedComponents.reserve(_components.size());
+
+    for (size_t i = 0; i < _components.size(); i++)
+    {
+        DspComponent* clone = _components[i]->_Clone();
+
+        if (clone == NULL)
+        {
+            delete circuit;  // this component does not support cloning
+            return NULL;
+        }
+
+        clone->_SetParentCircuit(circuit);
+        clone->_SetBufferCount(circuit->_circuitThreads.size());
+
+        circuit->_components.push_back(clone);
+        circuit->_ownedComponents.push_back(clone);
+        clones[_components[i]] = clone;
+    }
+
+    // replicate wiring between internal components
+    std::map<DspComponent const*, DspComponent*>::const_iterator clone;
+    DspWire* wire;
+
+    for (size_t i = 0; i < _components.size(); i++)
+    {
+        DspWireBus& inputWires = _components[i]->_inputWires;
+
+        for (int j = 0; j < inputWires.GetWireCount(); j++)
+        {
+            wire = inputWires.GetWire(j);
+            clone = clones.find(wire->linkedComponent);
+
+            if (clone != clones.end())  // wires to components outside this circuit are not cloned
+            {
+                circuit->_components[i]->_inputWires.AddWire(clone->second, wire->fromSignalIndex, wire->toSignalIndex);
+            }
+        }
+    }
+
+    // replicate wiring to and from circuit IO
+    for (int i = 0; i < _inToInWires.GetWireCount(); i++)
+    {
+        wire = _inToInWires.GetWire(i);
+        circuit->_inToInWires.AddWire(clones[wire->linkedComponent], wire->fromSignalIndex, wire->toSignalIndex);
+    }
+
+    for (int i = 0; i < _outToOutWires.GetWireCount(); i++)
+    {
+        wire = _outToOutWires.GetWire(i);
+        circuit->_outToOutWires.AddWire(clones[wire->linkedComponent], wire->fromSignalIndex, wire->toSignalIndex);
+    }
+
+    return circuit;
+}
 
 //=================================================================================================
 
@@ -350,7 +905,7 @@ void DspCircuit::_PauseAutoTick()
     // sync all threads
     for (size_t i = 0; i < _circuitThreads.size(); i++)
     {
-        _circuitThreads[i].Sync();
+        _circuitThreads[i]->Sync();
     }
 }
 
@@ -443,6 +998,764 @@ void DspCircuit::_DisconnectComponent(int componentIndex)
 
 //-------------------------------------------------------------------------------------------------
 
+bool DspCircuit::_SetThreadCount(int threadCount, bool tuned)
+{
+    // one thread count change at a time: the tuner's thread scaler skips its change when busy, or
+    // when stopped meanwhile (see _ThreadScaler::Stop())
+    if (tuned)
+    {
+        if (!_threadCountLock.CompareExchange(0, 1))
+        {
+            return false;
+        }
+
+        if (_threadScaler->IsStopping())
+        {
+            _UnlockThreadCount();
+            return false;
+        }
+    }
+    else
+    {
+        _LockThreadCount();
+    }
+
+    DspEngine* engine = GetEngine();
+
+    // bound the thread count by the engine's worker count and circuit thread limit
+    size_t oldCount = _circuitThreads.size();
+    size_t newCount = engine->_GetThreadLimit(threadCount);
+
+    // keep the threads we have, and start only those we're short of
+    _newCircuitThreads.assign(_circuitThreads.begin(), _circuitThreads.begin() + std::min(oldCount, newCount));
+
+    for (size_t i = oldCount; i < newCount; i++)
+    {
+        std::vector<int> cpus;
+        engine->_GetThreadCpus(_placement, i, cpus);
+
+        DspCircuitThread* circuitThread = new DspCircuitThread();
+        circuitThread->Initialise(engine, &_components, i);
+        circuitThread->SetThreadAffinity(cpus);
+        circuitThread->SetSchedulingProfile(engine->_GetThreadScheduling(_scheduling));
+
+        if (!circuitThread->Start())
+        {
+            // no more workers available, run with the threads we have
+            delete circuitThread;
+            break;
+        }
+
+        _newCircuitThreads.push_back(circuitThread);
+    }
+
+    newCount = _newCircuitThreads.size();
+    bool takenBack = false;
+
+    if (newCount != oldCount)
+    {
+        // likewise, only allocate (or retire) the thread states of the threads added (or retired)
+        _newThreadStates.resize(_components.size());
+
+        for (size_t i = 0; i < _components.size(); i++)
+        {
+            _components[i]->_GetThreadStates(newCount, _newThreadStates[i]);
+        }
+
+        // while being auto-ticked (or tuned, ticked by whichever thread), the ticking thread swaps
+        // the new threads in at its next tick boundary (see Process_()), hence threads that carry
+        // on are never stopped nor paused. As the tuned circuit may not be ticked again, its
+        // change can be taken back until then (see _LockThreadCount())
+        if (tuned)
+        {
+            _threadCountChange.Store(2);
+            _threadCountLock.Store(2);
+            _threadCountLock.WakeAll();
+
+            int change;
+            while ((change = _threadCountChange.Load()) > 0)
+            {
+                _threadCountChange.Wait(change);
+            }
+
+            takenBack = change < 0;
+            _threadCountChange.Store(0);
+        }
+        else if (_IsAutoTicking())
+        {
+            _threadCountChange.Store(1);
+
+            while (_threadCountChange.Load() != 0)
+            {
+                _threadCountChange.Wait(1);
+            }
+        }
+        else
+        {
+            // hold off the ticks of a tick source meanwhile (see DspTickSource)
+            DspTickSource* tickSource = _GetTickSource();
+
+            if (tickSource != NULL)
+            {
+                tickSource->_Pause();
+            }
+
+            _SwapThreads();
+
+            if (tickSource != NULL)
+            {
+                tickSource->_Resume();
+            }
+        }
+
+        if (takenBack)
+        {
+            // the new arrays were never swapped in, stop and free the threads added
+            for (size_t i = oldCount; i < newCount; i++)
+            {
+                _newCircuitThreads[i]->Stop();
+                delete _newCircuitThreads[i];
+            }
+
+            for (size_t i = 0; i < _components.size(); i++)
+            {
+                DspComponent::_FreeThreadStates(_newThreadStates[i], oldCount);
+            }
+        }
+        else
+        {
+            // the previous threads and thread states are now in the "new" arrays, stop and free
+            // the ones retired
+            for (size_t i = newCount; i < oldCount; i++)
+            {
+                _newCircuitThreads[i]->Stop();
+                delete _newCircuitThreads[i];
+            }
+
+            for (size_t i = 0; i < _components.size(); i++)
+            {
+                DspComponent::_FreeThreadStates(_newThreadStates[i], newCount);
+            }
+        }
+    }
+
+    _newCircuitThreads.clear();
+    _newThreadStates.clear();
+
+    _UnlockThreadCount();
+
+    return !takenBack;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::_LockThreadCount()
+{
+    while (!_threadCountLock.CompareExchange(0, 1))
+    {
+        // take back a change of the tuner's that is waiting on a tick to take it over, as the
+        // circuit may not be ticked again (E.g. SetThreadCount() between Tick()s)
+        int lock = _threadCountLock.Load();
+
+        if (lock == 2 && _threadCountChange.CompareExchange(2, -1))
+        {
+            _threadCountChange.WakeAll();
+        }
+
+        if (lock != 0)
+        {
+            _threadCountLock.Wait(lock);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::_UnlockThreadCount()
+{
+    _threadCountLock.Store(0);
+    _threadCountLock.WakeAll();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::_SwapThreads()
+{
+    // wait for in-flight ticks, such that every component's release token rests with the thread
+    // to tick next (and no thread touches its thread states)
+    for (size_t i = 0; i < _circuitThreads.size(); i++)
+    {
+        _circuitThreads[i]->Sync();
+    }
+
+    _circuitThreads.swap(_newCircuitThreads);
+
+    if ((size_t)_currentThreadIndex >= _circuitThreads.size())
+    {
+        _currentThreadIndex = 0;
+    }
+
+    for (size_t i = 0; i < _components.size(); i++)
+    {
+        _components[i]->_SwapThreadStates(_newThreadStates[i], _currentThreadIndex);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::_ScaleThreads(double processTime)
+{
+    _ScalingWindow& window = _scalingWindow;
+
+    // pick up a new configuration (restarting the tuner)
+    if (_threadScalingChanged.exchange(false, std::memory_order_acq_rel))
+    {
+        window = _ScalingWindow();
+
+        _threadScalingMutex.Lock();
+        window.scaling = _threadScaling;
+        _threadScalingMutex.Unlock();
+    }
+
+    DspThreadScaling const& scaling = window.scaling;
+    int threadCount = _circuitThreads.size();
+
+    // wait for the change handed to the thread scaler to be applied (or skipped), then see that a
+    // thread added pays off, or hold off adding threads the engine has none to give
+    if (window.changing)
+    {
+        if (!_threadScaler->IsIdle())
+        {
+            return;
+        }
+
+        window.changing = false;
+
+        if (window.change.action == DspThreadScalingStats::ScaleUp)
+        {
+            if (threadCount == window.change.fromThreadCount)
+            {
+                window.upBlockedUntil = window.change.window + 8 * scaling.holdWindows;
+            }
+            else if (window.change.fromThreadCount > 0)
+            {
+                window.checkScaleUp = true;
+                window.scaleUpLoad = window.change.load;
+            }
+        }
+    }
+
+    // sum the tick counters of all threads
+    unsigned long threadTicks = 0;
+    double busyTime = 0;
+    double waitTime = 0;
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        unsigned long ticks;
+        double busy, wait;
+        _circuitThreads[i]->GetTickTimes(ticks, busy, wait);
+
+        threadTicks += ticks;
+        busyTime += busy;
+        waitTime += wait;
+    }
+
+    // start a new window with the thread counters as they are now
+    if (window.ticks == 0 || threadCount != window.threadCount)
+    {
+        window.ticks = 0;
+        window.processTime = 0;
+        window.threadCount = threadCount;
+        window.threadTicks = threadTicks;
+        window.busyTime = busyTime;
+        window.waitTime = waitTime;
+    }
+
+    window.processTime += processTime;
+
+    if (++window.ticks < scaling.window)
+    {
+        return;
+    }
+
+    // measure the window
+    double busy = window.processTime / window.ticks;
+    double wait = 0;
+
+    if (threadCount > 0)
+    {
+        if (threadTicks == window.threadTicks)
+        {
+            return;  // the threads have not ticked yet, keep measuring
+        }
+
+        busy = (busyTime - window.busyTime) / (threadTicks - window.threadTicks);
+        wait = (waitTime - window.waitTime) / (threadTicks - window.threadTicks);
+    }
+
+    double load = busy / (std::max(threadCount, 1) * (double)scaling.deadline);
+    double loadWithLess = busy / (std::max(threadCount - 1, 1) * (double)scaling.deadline);
+
+    window.ticks = 0;
+
+    _threadScalingMutex.Lock();
+    unsigned long windowNo = ++_threadScalingStats.windowCount;
+    _threadScalingStats.threadCount = threadCount;
+    _threadScalingStats.busyTime = busy;
+    _threadScalingStats.waitTime = wait;
+    _threadScalingStats.load = load;
+    _threadScalingMutex.Unlock();
+
+    // discard the first window after a change, the threads are still settling
+    if (window.settling)
+    {
+        window.settling = false;
+        return;
+    }
+
+    // decide on a new thread count
+    int newThreadCount = threadCount;
+    DspThreadScalingStats::Action action = DspThreadScalingStats::Clamp;
+
+    if (threadCount < scaling.minThreadCount || threadCount > scaling.maxThreadCount)
+    {
+        newThreadCount = std::min(std::max(threadCount, scaling.minThreadCount), scaling.maxThreadCount);
+        action = DspThreadScalingStats::Clamp;
+    }
+    else if (window.checkScaleUp &&
+             load > window.scaleUpLoad * (1.0 - 0.5 / threadCount))  // < half the reduction expected
+    {
+        newThreadCount = threadCount - 1;
+        action = DspThreadScalingStats::Revert;
+        window.upBlockedUntil = windowNo + 8 * scaling.holdWindows;
+    }
+    else if (load > scaling.scaleUpLoad)
+    {
+        window.downCount = 0;
+
+        if (++window.upCount >= scaling.holdWindows && threadCount < scaling.maxThreadCount &&
+            windowNo >= window.upBlockedUntil)
+        {
+            newThreadCount = threadCount + 1;
+            action = DspThreadScalingStats::ScaleUp;
+        }
+    }
+    else if (loadWithLess < scaling.scaleDownLoad && threadCount > scaling.minThreadCount)
+    {
+        window.upCount = 0;
+
+        if (++window.downCount >= scaling.holdWindows)
+        {
+            newThreadCount = threadCount - 1;
+            action = DspThreadScalingStats::ScaleDown;
+        }
+    }
+    else
+    {
+        window.upCount = 0;
+        window.downCount = 0;
+    }
+
+    window.checkScaleUp = false;
+
+    if (newThreadCount == threadCount)
+    {
+        return;
+    }
+
+    // hand the change to the thread scaler, which records the decision once applied
+    DspThreadScalingStats::Decision decision;
+    decision.action = action;
+    decision.window = windowNo;
+    decision.fromThreadCount = threadCount;
+    decision.toThreadCount = newThreadCount;
+    decision.busyTime = busy;
+    decision.waitTime = wait;
+    decision.load = load;
+
+    if (!_threadScaler->Post(decision))
+    {
+        return;
+    }
+
+    window.changing = true;
+    window.change = decision;
+
+    window.upCount = 0;
+    window.downCount = 0;
+    window.settling = true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::_ApplyThreadScaling(DspThreadScalingStats::Decision decision)
+{
+    if (!_SetThreadCount(decision.toThreadCount, true))
+    {
+        return;  // a change by SetThreadCount() is under way
+    }
+
+    decision.toThreadCount = _circuitThreads.size();
+
+    _threadScalingMutex.Lock();
+    if (_threadScalingStats.decisions.size() >= DspThreadScalingStats::historySize)
+    {
+        _threadScalingStats.decisions.erase(_threadScalingStats.decisions.begin());
+    }
+    _threadScalingStats.decisions.push_back(decision);
+    ++_threadScalingStats.decisionCount;
+    _threadScalingStats.threadCount = decision.toThreadCount;
+    _threadScalingMutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspCircuit::_RenderThreads(unsigned long tickCount)
+{
+    size_t threadCount = _circuitThreads.size();
+
+    // wait for the ticks still in flight from earlier Tick()s
+    for (size_t i = 0; i < threadCount; i++)
+    {
+        _circuitThreads[i]->Sync();
+    }
+
+    // hand each thread its share of the batch (up to 2^20 ticks each): tick i goes to thread
+    // (current + i) % threadCount, exactly as it would tick by tick
+    unsigned long batchSize = std::min(tickCount, (unsigned long)threadCount << 20);
+    unsigned long firstTickNo = _renderTickNo;
+
+    _renderTurn.Store(_currentThreadIndex);
+
+    for (size_t i = 0; i < threadCount && i < batchSize; i++)
+    {
+        int threadTicks = (batchSize - i + threadCount - 1) / threadCount;
+
+        _circuitThreads[(_currentThreadIndex + i) % threadCount]->Resume(threadTicks, _renderSink != NULL ? this : NULL);
+    }
+
+    for (size_t i = 0; i < threadCount; i++)
+    {
+        _circuitThreads[i]->Sync();
+    }
+
+    // when the sink stopped the render, only the ticks handed over (or in flight at the time) were
+    // processed, these being the first of the batch
+    unsigned long ticksProcessed = _renderSink != NULL ? _renderTickNo - firstTickNo : batchSize;
+
+    _currentThreadIndex = (_currentThreadIndex + ticksProcessed) % threadCount;
+
+    return ticksProcessed;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCircuit::_RenderTick(int threadNo)
+{
+    // wait for this thread's turn, such that ticks reach the sink in tick order
+    int renderTurn = _renderTurn.Load();
+
+    while (renderTurn != threadNo)
+    {
+        _renderTurn.Wait(renderTurn);
+        renderTurn = _renderTurn.Load();
+    }
+
+    if (!_renderStopped)
+    {
+        // set all circuit outputs from connected internal component outputs
+        for (int i = 0; i < _outToOutWires.GetWireCount(); i++)
+        {
+            DspWire* wire = _outToOutWires.GetWire(i);
+            DspSignal* signal = wire->linkedComponent->_GetOutputSignal(wire->fromSignalIndex, threadNo);
+            _outputBus.SetSignal(wire->toSignalIndex, signal);
+        }
+
+        _renderStopped = !_renderSink->Consume(_renderTickNo, _outputBus);
+    }
+    _renderTickNo++;
+
+    bool renderStopped = _renderStopped;
+
+    // pass the turn on to the thread processing the next tick
+    _renderTurn.Store((threadNo + 1) % _circuitThreads.size());
+    _renderTurn.WakeAll();
+
+    return !renderStopped;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCircuit::_LinkStreamStages(DspRenderSink* sink)
+{
+    std::map<DspComponent const*, _StreamStage*> stages;
+    std::map<_StreamStage const*, int> visits;
+
+    for (size_t i = 0; i < _components.size(); i++)
+    {
+        _streamStages.push_back(new _StreamStage(_components[i]));
+        stages[_components[i]] = _streamStages.back();
+    }
+
+    bool linked = true;
+
+    for (size_t i = 0; i < _components.size() && linked; i++)
+    {
+        linked = _LinkStreamStage(_streamStages[i], stages, visits);
+    }
+
+    // the sink reads the circuit outputs
+    if (sink != NULL && linked)
+    {
+        _StreamStage* sinkStage = new _StreamStage(NULL);
+        _streamStages.push_back(sinkStage);
+
+        for (int i = 0; i < _outToOutWires.GetWireCount() && linked; i++)
+        {
+            std::map<DspComponent const*, _StreamStage*>::const_iterator stage =
+                stages.find(_outToOutWires.GetWire(i)->linkedComponent);
+
+            linked = stage != stages.end();
+
+            if (linked)
+            {
+                sinkStage->inputs.push_back(stage->second);
+                sinkStage->wireDelays.push_back(0);
+                stage->second->readers.push_back(std::make_pair(sinkStage, 0));
+            }
+        }
+    }
+
+    if (!linked)
+    {
+        for (size_t i = 0; i < _streamStages.size(); i++)
+        {
+            delete _streamStages[i];
+        }
+        _streamStages.clear();
+    }
+
+    return linked;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCircuit::_LinkStreamStage(_StreamStage* stage,
+                                  std::map<DspComponent const*, _StreamStage*> const& stages,
+                                  std::map<_StreamStage const*, int>& visits)
+{
+    // follow the input wires in the order Tick() does: a wire to a stage still being linked (one
+    // further up the recursion) closes a feedback loop, hence delivers the previous tick
+    int& visit = visits[stage];
+    if (visit != 0)
+    {
+        return true;
+    }
+    visit = 1;
+
+    DspWireBus& inputWires = stage->component->_inputWires;
+
+    for (int i = 0; i < inputWires.GetWireCount(); i++)
+    {
+        std::map<DspComponent const*, _StreamStage*>::const_iterator input =
+            stages.find(inputWires.GetWire(i)->linkedComponent);
+
+        if (input == stages.end() || !_LinkStreamStage(input->second, stages, visits))
+        {
+            return false;
+        }
+
+        int wireDelay = visits[input->second] == 1 ? 1 : 0;
+
+        stage->inputs.push_back(input->second);
+        stage->wireDelays.push_back(wireDelay);
+        input->second->readers.push_back(std::make_pair(stage, wireDelay));
+    }
+
+    visits[stage] = 2;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::_StreamWork(int workerNo)
+{
+    // spread the threads over the stages, each going round them from there
+    size_t stageCount = _streamStages.size();
+    size_t firstStage = stageCount * workerNo / (_circuitThreads.size() + 1);
+
+    while (!_streamStopped.load())
+    {
+        int progress = _streamProgress.Load();
+
+        bool finished = true;
+        bool processed = false;
+
+        for (size_t i = 0; i < stageCount; i++)
+        {
+            _StreamStage* stage = _streamStages[(firstStage + i) % stageCount];
+
+            if (stage->tickCount.load() < _streamTickCount)
+            {
+                finished = false;
+                processed |= _StreamStageTicks(stage);
+            }
+        }
+
+        if (finished)
+        {
+            break;
+        }
+
+        // nothing was ready, wait for another thread to process a tick
+        if (!processed)
+        {
+            unsigned long long waitStart = DspTracer::IsTracing() ? DspTracer::_GetTime() : 0;
+
+            _streamProgress.Wait(progress);
+
+            if (waitStart != 0)
+            {
+                DspTracer::_RecordComponent(DspTracer::_WaitEvent, NULL, waitStart, DspTracer::_GetTime());
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCircuit::_StreamStageTicks(_StreamStage* stage)
+{
+    bool unclaimed = false;
+    if (!stage->claimed.compare_exchange_strong(unclaimed, true))
+    {
+        return false;
+    }
+
+    // process as many ticks in a row as are ready, up to a queue's worth
+    unsigned long tickNo = stage->tickCount.load();
+    unsigned long lastTickNo = tickNo + _streamDepth;
+    bool processed = false;
+
+    while (tickNo < lastTickNo && !_streamStopped.load() && _IsStreamStageReady(stage, tickNo))
+    {
+        if (stage->component != NULL)
+        {
+            stage->component->_StreamTick(tickNo, stage->wireDelays);
+        }
+        else
+        {
+            // set all circuit outputs from connected internal component outputs, and hand them over
+            _outputBus.ClearAllValues();
+
+            for (int i = 0; i < _outToOutWires.GetWireCount(); i++)
+            {
+                DspWire* wire = _outToOutWires.GetWire(i);
+                DspSignal* signal = wire->linkedComponent->_GetOutputSignal(wire->fromSignalIndex, tickNo % _streamDepth);
+                _outputBus.SetSignal(wire->toSignalIndex, signal);
+            }
+
+            if (!_renderSink->Consume(tickNo, _outputBus))
+            {
+                _streamStopped.store(true);
+            }
+        }
+
+        stage->tickCount.store(++tickNo);
+        processed = true;
+
+        _StreamProgress();
+    }
+
+    stage->claimed.store(false);
+
+    // another thread may have passed this stage over while claimed, as it became ready
+    if (_IsStreamStageReady(stage, tickNo))
+    {
+        _StreamProgress();
+    }
+
+    return processed;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCircuit::_IsStreamStageReady(_StreamStage const* stage, unsigned long tickNo) const
+{
+    if (tickNo >= _streamTickCount)
+    {
+        return false;
+    }
+
+    // the ticks read must have been processed...
+    for (size_t i = 0; i < stage->inputs.size(); i++)
+    {
+        unsigned long wireDelay = stage->wireDelays[i];
+
+        if (tickNo >= wireDelay && stage->inputs[i]->tickCount.load() <= tickNo - wireDelay)
+        {
+            return false;
+        }
+    }
+
+    // ...and the tick queued in the slot to be overwritten must have been read by all readers
+    for (size_t i = 0; i < stage->readers.size(); i++)
+    {
+        if (stage->readers[i].first->tickCount.load() + _streamDepth <= tickNo + stage->readers[i].second)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuit::_StreamProgress()
+{
+    int progress = _streamProgress.Load();
+
+    while (!_streamProgress.CompareExchange(progress, (int)((unsigned int)progress + 1)))
+    {
+        progress = _streamProgress.Load();
+    }
+
+    _streamProgress.WakeAll();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspArena* DspCircuit::_GetThreadStateArena()
+{
+    // thread states live on the NUMA node of the circuit threads that process them
+    int numaNode = _placement.numaNode;
+    if (numaNode < 0)
+    {
+        numaNode = GetEngine()->GetPlacement().numaNode;
+    }
+
+    if (numaNode < 0)
+    {
+        return &_threadStateArena;
+    }
+
+    for (size_t i = 0; i < _nodeArenas.size(); i++)
+    {
+        if (_nodeArenas[i]->GetNumaNode() == numaNode)
+        {
+            return _nodeArenas[i];
+        }
+    }
+
+    _nodeArenas.push_back(new DspArena(_GetThreadStateSize(), 64, numaNode));
+    return _nodeArenas.back();
+}
+
+//-------------------------------------------------------------------------------------------------
+
 void DspCircuit::_RemoveComponent(int componentIndex)
 {
     _DisconnectComponent(componentIndex);
@@ -450,6 +1763,7 @@ void DspCircuit::_RemoveComponent(int componentIndex)
     // set the removed component's parent circuit to NULL
     if (_components[componentIndex]->_GetParentCircuit() != NULL)
     {
+        _components[componentIndex]->_SetBufferCount(0);  // return thread states to their arenas
         _components[componentIndex]->_SetParentCircuit(NULL);
     }
     // setting a component's parent to NULL (above) calls _RemoveComponent (hence the following code will run)
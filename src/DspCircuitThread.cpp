@@ -22,18 +22,28 @@ but WITHOUT ANY WARRANTY; without even the implied warranty of
 MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 ************************************************************************/
 
+#include <dspatch/DspCircuit.h>
 #include <dspatch/DspCircuitThread.h>
 #include <dspatch/DspComponent.h>
+#include <dspatch/DspEngine.h>
+
+#include <chrono>
 
 //=================================================================================================
 
 DspCircuitThread::DspCircuitThread()
-    : _components(NULL)
+    : _engine(NULL)
+    , _leased(false)
+    , _components(NULL)
     , _threadNo(0)
     , _stop(false)
     , _stopped(true)
-    , _gotResume(false)
-    , _gotSync(false)
+    , _renderCircuit(NULL)
+    , _streamCircuit(NULL)
+    , _gotSync(1)
+    , _tickCount(0)
+    , _busyTime(0)
+    , _waitTime(0)
 {
 }
 
@@ -46,94 +56,206 @@ DspCircuitThread::~DspCircuitThread()
 
 //=================================================================================================
 
-void DspCircuitThread::Initialise(std::vector<DspComponent*>* components, int threadNo)
+void DspCircuitThread::Initialise(DspEngine* engine, std::vector<DspComponent*>* components, int threadNo)
 {
+    _engine = engine;
     _components = components;
     _threadNo = threadNo;
 }
 
 //-------------------------------------------------------------------------------------------------
 
-void DspCircuitThread::Start(Priority priority)
+bool DspCircuitThread::Start()
 {
-    if (_stopped)
+    if (_stopped.load(std::memory_order_acquire) && _engine != NULL)
     {
-        _stop = false;
-        _stopped = false;
-        _gotResume = false;
-        _gotSync = true;
-        DspThread::Start(priority);
+        _stop.store(false, std::memory_order_relaxed);
+        _stopped.store(false, std::memory_order_relaxed);
+        _gotResume.Store(0);
+        _gotSync.Store(1);
+        _placed.Store(0);
+        _affinity.clear();
+        _tickCount.store(0, std::memory_order_relaxed);
+        _busyTime.store(0, std::memory_order_relaxed);
+        _waitTime.store(0, std::memory_order_relaxed);
+
+        // lease a worker from the engine to run on (this publishes the above to the worker)
+        _leased = _engine->_Acquire(this);
+        if (!_leased)
+        {
+            _stopped.store(true, std::memory_order_release);
+        }
     }
+
+    return !_stopped.load(std::memory_order_acquire);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DspCircuitThread::Stop()
 {
-    _stop = true;
-
-    while (_stopped != true)
+    if (!_leased)
     {
-        _syncCondt.WakeAll();
-        _resumeCondt.WakeAll();
-        MsSleep(1);
+        return;
     }
 
-    DspThread::Stop();
+    // wake the loop to see the stop flag
+    _stop.store(true, std::memory_order_release);
+    _gotResume.Store(1);
+    _gotResume.WakeAll();
+
+    // return the worker to the engine (this waits for the loop to exit)
+    _engine->_Release(this);
+    _leased = false;
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DspCircuitThread::Sync()
 {
-    _resumeMutex.Lock();
+    if (_gotSync.Load() != 0)
+    {
+        return;
+    }
 
-    if (!_gotSync)  // if haven't already got sync
+    unsigned long long syncStart = DspTracer::IsTracing() ? DspTracer::_GetTime() : 0;
+
+    while (_gotSync.Load() == 0)
     {
-        _syncCondt.Wait(_resumeMutex);  // wait for sync
+        _gotSync.Wait(0);  // wait for sync
     }
 
-    _resumeMutex.Unlock();
+    if (syncStart != 0)
+    {
+        DspTracer::_RecordThread(DspTracer::_SyncEvent, _threadNo, syncStart, DspTracer::_GetTime());
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DspCircuitThread::Resume()
 {
-    _resumeMutex.Lock();
+    Resume(1, NULL);
+}
 
-    _gotSync = false;  // reset the sync flag
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuitThread::Resume(int tickCount, DspCircuit* renderCircuit)
+{
+    _renderCircuit = renderCircuit;
 
-    _gotResume = true;  // set the resume flag
-    _resumeCondt.WakeAll();
+    _gotSync.Store(0);  // reset the sync flag
 
-    _resumeMutex.Unlock();
+    _gotResume.Store(tickCount);  // set the resume flag (publishes the above to the thread)
+    _gotResume.WakeAll();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuitThread::Stream(DspCircuit* streamCircuit)
+{
+    _streamCircuit = streamCircuit;
+
+    Resume(1, NULL);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuitThread::SetThreadAffinity(std::vector<int> const& cpus)
+{
+    _cpus = cpus;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCircuitThread::GetThreadAffinity(std::vector<int>& cpus)
+{
+    _WaitForPlacement();
+
+    cpus = _affinity;
+    return !cpus.empty();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuitThread::SetSchedulingProfile(DspSchedulingProfile const& profile)
+{
+    _scheduling = profile;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCircuitThread::GetThreadScheduling(DspSchedulingProfile& effective)
+{
+    _WaitForPlacement();
+
+    effective = _effectiveScheduling;
+    return _placed.Load() != 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuitThread::GetTickTimes(unsigned long& tickCount, double& busyTime, double& waitTime) const
+{
+    tickCount = _tickCount.load(std::memory_order_relaxed);
+    busyTime = _busyTime.load(std::memory_order_relaxed) / 1000.0;
+    waitTime = _waitTime.load(std::memory_order_relaxed) / 1000.0;
 }
 
 //=================================================================================================
 
 void DspCircuitThread::_Run()
 {
+    // apply this thread's affinity and scheduling to the worker, then read back what the OS
+    // actually gave us (without CPUs, the worker is released from those of its previous lease, or
+    // of the thread that started it)
+    DspThread::SetAffinity(_cpus);
+
+    DspThread::SetScheduling(_scheduling, _effectiveScheduling);
+    DspThread::GetAffinity(_affinity);
+
+    _placed.Store(1);  // publishes _affinity and _effectiveScheduling
+    _placed.WakeAll();
+
     if (_components != NULL)
     {
-        while (!_stop)
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point idleSince = Clock::now();
+
+        while (true)
         {
-            _resumeMutex.Lock();
+            // wait for resume, and reset the resume flag (without losing a Stop() meanwhile)
+            int tickCount = _gotResume.Load();
 
-            _gotSync = true;  // set the sync flag
+            while (tickCount == 0 || !_gotResume.CompareExchange(tickCount, 0))
+            {
+                if (tickCount == 0)
+                {
+                    _gotResume.Wait(0);
+                }
 
-            _syncCondt.WakeAll();
+                tickCount = _gotResume.Load();
+            }
 
-            if (!_gotResume)  // if haven't already got resume
+            if (_stop.load(std::memory_order_acquire))
             {
-                _resumeCondt.Wait(_resumeMutex);  // wait for resume
+                break;
             }
-            _gotResume = false;  // reset the resume flag
 
-            _resumeMutex.Unlock();
+            // join in streaming a circuit (see DspCircuit::Stream())
+            if (_streamCircuit != NULL)
+            {
+                _streamCircuit->_StreamWork(_threadNo + 1);
+                _streamCircuit = NULL;
+
+                tickCount = 0;
+                idleSince = Clock::now();
+            }
 
-            if (!_stop)
+            for (int tick = 0; tick < tickCount; tick++)
             {
+                Clock::time_point tickStart = Clock::now();
+
                 for (size_t i = 0; i < _components->size(); i++)
                 {
                     (*_components)[i]->_ThreadTick(_threadNo);
@@ -142,11 +264,52 @@ void DspCircuitThread::_Run()
                 {
                     (*_components)[i]->_ThreadReset(_threadNo);
                 }
+
+                // account this tick's busy time, and the time spent waiting for it
+                Clock::time_point tickEnd = Clock::now();
+
+                _waitTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(tickStart - idleSince).count(),
+                                    std::memory_order_relaxed);
+                _busyTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(tickEnd - tickStart).count(),
+                                    std::memory_order_relaxed);
+                _tickCount.fetch_add(1, std::memory_order_relaxed);
+                idleSince = tickEnd;
+
+                if (DspTracer::IsTracing())
+                {
+                    DspTracer::_RecordThread(DspTracer::_TickEvent, _threadNo,
+                                             std::chrono::duration_cast<std::chrono::nanoseconds>(tickStart.time_since_epoch()).count(),
+                                             std::chrono::duration_cast<std::chrono::nanoseconds>(tickEnd.time_since_epoch()).count());
+                }
+
+                // hand a rendered tick over to its circuit (see DspCircuit::Render())
+                if (_renderCircuit != NULL && !_renderCircuit->_RenderTick(_threadNo))
+                {
+                    break;
+                }
             }
+
+            _gotSync.Store(1);  // set the sync flag (publishes this iteration's outputs)
+            _gotSync.WakeAll();
         }
     }
 
-    _stopped = true;
+    _stopped.store(true, std::memory_order_release);
+
+    // release Sync() callers
+    _gotSync.Store(1);
+    _gotSync.WakeAll();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCircuitThread::_WaitForPlacement()
+{
+    // wait for the worker to apply the affinity and scheduling
+    while (_placed.Load() == 0 && !_stopped.load(std::memory_order_acquire))
+    {
+        _placed.Wait(0);
+    }
 }
 
 //=================================================================================================
@@ -27,12 +27,18 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 #include <dspatch/DspCircuit.h>
 #include <dspatch/DspComponent.h>
 #include <dspatch/DspComponentThread.h>
+#include <dspatch/DspTickSource.h>
 #include <dspatch/DspWire.h>
 
+#include <algorithm>
+#include <new>
+
 //=================================================================================================
 
 DspComponent::DspComponent()
     : _parentCircuit(NULL)
+    , _rootEngine(NULL)
+    , _tickSource(NULL)
     , _bufferCount(0)
     , _componentName("")
     , _isAutoTickRunning(false)
@@ -41,6 +47,8 @@ DspComponent::DspComponent()
     , _hasTicked(false)
     , _callback(NULL)
     , _userData(NULL)
+    , _profile(NULL)
+    , _traceId(0)
 {
     _componentThread.Initialise(this);
 }
@@ -53,10 +61,16 @@ DspComponent::~DspComponent()
     {
         _parentCircuit->RemoveComponent(this);
     }
+    if (_tickSource != NULL)
+    {
+        _tickSource->Detach();
+    }
 
     StopAutoTick();
     _SetBufferCount(0);
     DisconnectAllInputs();
+
+    DspProfiler::_Release(this);
 }
 
 //=================================================================================================
@@ -74,6 +88,11 @@ void DspComponent::SetCallback(Callback_t const& callback, void* userData)
 void DspComponent::SetComponentName(std::string const& componentName)
 {
     _componentName = componentName;
+
+    if (_traceId.load(std::memory_order_relaxed) != 0)
+    {
+        DspTracer::_Rename(this);
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -109,14 +128,10 @@ void DspComponent::DisconnectInput(std::string const& inputName)
 {
     int inputIndex;
 
-    PauseAutoTick();
-
     if (_FindInput(inputName, inputIndex))
     {
         DisconnectInput(inputIndex);
     }
-
-    ResumeAutoTick();
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -289,7 +304,7 @@ void DspComponent::Tick()
         _outputBus.ClearAllValues();
 
         // 4. call Process_() with newly aquired inputs
-        Process_(_inputBus, _outputBus);
+        _Process(_inputBus, _outputBus);
     }
 }
 
@@ -308,57 +323,99 @@ void DspComponent::Reset()
 
 void DspComponent::StartAutoTick()
 {
-    // Global scoped components (components not within a circuit) are added to the "global circuit" in
-    // order to be auto-ticked. Technically it is only the global circuit that auto-ticks -This in turn
-    // auto-ticks all components contained.
+    StartAutoTick(_GetAutoTickEngine());
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponent::StartAutoTick(DspTickPacing const& pacing)
+{
+    StartAutoTick(_GetAutoTickEngine(), pacing);
+}
 
-    // if this is the global circuit
-    if (DSPatch::_IsThisGlobalCircuit(this))
+//-------------------------------------------------------------------------------------------------
+
+void DspComponent::StartAutoTick(DspEngine& engine)
+{
+    // Global scoped components (components not within a circuit) are added to the "root circuit" of
+    // an engine in order to be auto-ticked. Technically it is only the root circuit that auto-ticks
+    // -This in turn auto-ticks all components contained.
+
+    // if this is an engine's root circuit
+    if (_rootEngine != NULL)
     {
         if (_componentThread.IsStopped())
         {
-            _componentThread.Start();
+            // the auto-tick thread may run on any of the engine's CPUs
+            DspThreadPlacement placement = _rootEngine->GetPlacement();
+            placement.pinThreads = false;
+
+            std::vector<int> cpus;
+            _rootEngine->_GetThreadCpus(placement, 0, cpus);
+
+            _componentThread.SetThreadAffinity(cpus);
+            _componentThread.SetSchedulingProfile(_rootEngine->_GetThreadScheduling(DspSchedulingProfile()));
+            _componentThread.SetTickPacing(_rootEngine->GetAutoTickPacing());
+            _componentThread.Start(_rootEngine->GetPriority());
 
             _isAutoTickRunning = true;
             _isAutoTickPaused = false;
         }
         else
         {
-            ResumeAutoTick();
+            _ResumeAutoTick();  // (not an edit)
         }
     }
-    // else if this component has no parent or it's parent is the global circuit
-    else if (_parentCircuit == NULL || DSPatch::_IsThisGlobalCircuit(_parentCircuit))
+    // else if this component has no parent (nor tick source) or it's parent is an engine's root circuit
+    else if (_parentCircuit == NULL ? _tickSource == NULL : _parentCircuit->_rootEngine != NULL)
     {
-        DSPatch::_AddGlobalComponent(this);
-        DSPatch::_StartGlobalAutoTick();
+        // if auto-ticking in another engine, stop that first
+        if (_parentCircuit != NULL && _parentCircuit->_rootEngine != &engine)
+        {
+            StopAutoTick();
+        }
+
+        engine._AddComponent(this);
+        engine._StartAutoTick();
     }
 }
 
 //-------------------------------------------------------------------------------------------------
 
+void DspComponent::StartAutoTick(DspEngine& engine, DspTickPacing const& pacing)
+{
+    // the pacing applies to the engine's auto-tick thread, hence to all components it auto-ticks
+    engine.SetAutoTickPacing(pacing);
+    StartAutoTick(engine);
+}
+
+//-------------------------------------------------------------------------------------------------
+
 void DspComponent::StopAutoTick()
 {
-    // If a component is part of the global circuit, a call to StopAutoTick() removes it from the
-    // global circuit as to stop it from being auto-ticked. When all components are removed, the
-    // global circuit auto-ticking is stopped.
+    // If a component is part of an engine's root circuit, a call to StopAutoTick() removes it from
+    // the root circuit as to stop it from being auto-ticked. When all components are removed, the
+    // root circuit auto-ticking is stopped.
 
-    // if this is the global circuit
-    if (DSPatch::_IsThisGlobalCircuit(this) && !_componentThread.IsStopped())
+    // if this is an engine's root circuit
+    if (_rootEngine != NULL && !_componentThread.IsStopped())
     {
         _componentThread.Stop();
 
         _isAutoTickRunning = false;
         _isAutoTickPaused = false;
+        _pauseCount = 0;
     }
-    // else if this component's parent is the global circuit
-    else if (DSPatch::_IsThisGlobalCircuit(_parentCircuit))
+    // else if this component's parent is an engine's root circuit
+    else if (_parentCircuit != NULL && _parentCircuit->_rootEngine != NULL)
     {
-        DSPatch::_RemoveGlobalComponent(this);
+        DspEngine* engine = _parentCircuit->_rootEngine;
+
+        engine->_RemoveComponent(this);
 
-        if (DSPatch::_GetGlobalComponentCount() == 0)
+        if (engine->GetComponentCount() == 0)
         {
-            DSPatch::_StopGlobalAutoTick();
+            engine->_StopAutoTick();
         }
     }
 }
@@ -367,6 +424,15 @@ void DspComponent::StopAutoTick()
 
 void DspComponent::PauseAutoTick()
 {
+    // a graph edit spans from here to ResumeAutoTick() (see DspTracer), recorded by the outermost
+    // call only: edits made within it on the same thread (E.g. by a circuit method editing one of
+    // its components) are part of the same span
+    if (_GetEditDepth()++ == 0 && DspTracer::IsTracing())
+    {
+        unsigned long long time = DspTracer::_GetTime();
+        DspTracer::_RecordComponent(DspTracer::_EditBegin, this, time, time);
+    }
+
     _PauseAutoTick();
 }
 
@@ -374,19 +440,15 @@ void DspComponent::PauseAutoTick()
 
 void DspComponent::ResumeAutoTick()
 {
-    // A call to ResumeAutoTick() recursively traverses it's parent circuits until it reaches the
-    // global circuit. When the global circuit is reached, it's auto-tick is resumed.
+    _ResumeAutoTick();
 
-    // if this is the global circuit
-    if (DSPatch::_IsThisGlobalCircuit(this) && _isAutoTickPaused && --_pauseCount == 0)
-    {
-        _componentThread.Resume();
-        _isAutoTickPaused = false;
-        _isAutoTickRunning = true;
-    }
-    else if (_parentCircuit != NULL)
+    int& editDepth = _GetEditDepth();
+
+    // (a ResumeAutoTick() without a PauseAutoTick() ends no edit)
+    if (editDepth > 0 && --editDepth == 0 && DspTracer::IsTracing())
     {
-        _parentCircuit->ResumeAutoTick();  // recursive call to find the global circuit
+        unsigned long long time = DspTracer::_GetTime();
+        DspTracer::_RecordComponent(DspTracer::_EditEnd, this, time, time);
     }
 }
 
@@ -405,11 +467,18 @@ bool DspComponent::ParameterUpdating_(int, DspParameter const&)
 
 //-------------------------------------------------------------------------------------------------
 
+DspComponent* DspComponent::Clone_()
+{
+    return NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 bool DspComponent::AddInput_(std::string const& inputName)
 {
-    for (size_t i = 0; i < _inputBuses.size(); i++)
+    for (int i = 0; i < _bufferCount; i++)
     {
-        _inputBuses[i]._AddSignal(inputName);
+        _threadStates[i]->inputBus._AddSignal(inputName);
     }
     if (_inputBus._AddSignal(inputName))
     {
@@ -426,9 +495,9 @@ bool DspComponent::AddInput_(std::string const& inputName)
 
 bool DspComponent::AddOutput_(std::string const& outputName)
 {
-    for (size_t i = 0; i < _outputBuses.size(); i++)
+    for (int i = 0; i < _bufferCount; i++)
     {
-        _outputBuses[i]._AddSignal(outputName);
+        _threadStates[i]->outputBus._AddSignal(outputName);
     }
     if (_outputBus._AddSignal(outputName))
     {
@@ -457,6 +526,10 @@ int DspComponent::AddParameter_(std::string const& paramName, DspParameter const
 
 bool DspComponent::RemoveInput_()
 {
+    for (int i = 0; i < _bufferCount; i++)
+    {
+        _threadStates[i]->inputBus._RemoveSignal();
+    }
     if (_inputBus._RemoveSignal())
     {
         if (_callback)
@@ -472,6 +545,10 @@ bool DspComponent::RemoveInput_()
 
 bool DspComponent::RemoveOutput_()
 {
+    for (int i = 0; i < _bufferCount; i++)
+    {
+        _threadStates[i]->outputBus._RemoveSignal();
+    }
     if (_outputBus._RemoveSignal())
     {
         if (_callback)
@@ -503,9 +580,9 @@ bool DspComponent::RemoveParameter_()
 
 void DspComponent::RemoveAllInputs_()
 {
-    for (size_t i = 0; i < _inputBuses.size(); i++)
+    for (int i = 0; i < _bufferCount; i++)
     {
-        _inputBuses[i]._RemoveAllSignals();
+        _threadStates[i]->inputBus._RemoveAllSignals();
     }
     _inputBus._RemoveAllSignals();
     if (_callback)
@@ -518,9 +595,9 @@ void DspComponent::RemoveAllInputs_()
 
 void DspComponent::RemoveAllOutputs_()
 {
-    for (size_t i = 0; i < _outputBuses.size(); i++)
+    for (int i = 0; i < _bufferCount; i++)
     {
-        _outputBuses[i]._RemoveAllSignals();
+        _threadStates[i]->outputBus._RemoveAllSignals();
     }
     _outputBus._RemoveAllSignals();
     if (_callback)
@@ -592,30 +669,149 @@ bool DspComponent::SetParameter_(int index, DspParameter const& param)
 
 //=================================================================================================
 
+DspEngine& DspComponent::_GetAutoTickEngine()
+{
+    // keep to the engine this component is already auto-ticking in, otherwise use the global engine
+    if (_rootEngine != NULL)
+    {
+        return *_rootEngine;
+    }
+    else if (_parentCircuit != NULL && _parentCircuit->_rootEngine != NULL)
+    {
+        return *_parentCircuit->_rootEngine;
+    }
+    else
+    {
+        return DSPatch::GetGlobalEngine();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspTickSource* DspComponent::_GetTickSource() const
+{
+    // only top-level components are attached to tick sources
+    if (_parentCircuit != NULL)
+    {
+        return _parentCircuit->_GetTickSource();
+    }
+
+    return _tickSource;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspComponent::_IsAutoTicking() const
+{
+    // a component is auto-ticked while the root circuit it is part of is auto-ticking (not paused)
+    if (_rootEngine != NULL)
+    {
+        return _isAutoTickRunning;
+    }
+    else if (_parentCircuit != NULL)
+    {
+        return _parentCircuit->_IsAutoTicking();
+    }
+
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 void DspComponent::_PauseAutoTick()
 {
-    // A call to PauseAutoTick() recursively traverses it's parent circuits until it reaches the
-    // global circuit. When the global circuit is reached, it's auto-tick is paused.
+    // A call to PauseAutoTick() recursively traverses it's parent circuits until it reaches a root
+    // circuit. When the root circuit is reached, it's auto-tick is paused.
 
-    // if this is the global circuit
-    if (DSPatch::_IsThisGlobalCircuit(this) && !_componentThread.IsStopped())
+    // if this is an engine's root circuit
+    if (_rootEngine != NULL && !_componentThread.IsStopped())
     {
         if (_isAutoTickRunning)
         {
-            ++_pauseCount;
             _componentThread.Pause();
             _isAutoTickPaused = true;
             _isAutoTickRunning = false;
         }
+
+        // count nested pauses too, so that only the outermost ResumeAutoTick() resumes
+        if (_isAutoTickPaused)
+        {
+            ++_pauseCount;
+        }
     }
     else if (_parentCircuit != NULL)
     {
-        _parentCircuit->PauseAutoTick();  // recursive call to find the global circuit
+        _parentCircuit->_PauseAutoTick();  // recursive call to find the root circuit
+    }
+    // else if this component is ticked by a tick source, hold off its ticks instead
+    else if (_tickSource != NULL)
+    {
+        _tickSource->_Pause();
     }
 }
 
 //-------------------------------------------------------------------------------------------------
 
+void DspComponent::_ResumeAutoTick()
+{
+    // A call to ResumeAutoTick() recursively traverses it's parent circuits until it reaches a root
+    // circuit. When the root circuit is reached, it's auto-tick is resumed.
+
+    // if this is an engine's root circuit
+    if (_rootEngine != NULL && _isAutoTickPaused && --_pauseCount == 0)
+    {
+        _componentThread.Resume();
+        _isAutoTickPaused = false;
+        _isAutoTickRunning = true;
+    }
+    else if (_parentCircuit != NULL)
+    {
+        _parentCircuit->_ResumeAutoTick();  // recursive call to find the root circuit
+    }
+    else if (_tickSource != NULL)
+    {
+        _tickSource->_Resume();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int& DspComponent::_GetEditDepth()
+{
+    // PauseAutoTick() calls the calling thread is within
+    static thread_local int editDepth = 0;
+    return editDepth;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspComponent* DspComponent::_Clone()
+{
+    DspComponent* clone = Clone_();
+
+    if (clone != NULL)
+    {
+        clone->_componentName = _componentName;
+
+        // copy parameter values through the clone's own ParameterUpdating_() so that any internal
+        // state associated with a parameter is updated along with it
+        for (size_t i = 0; i < _parameters.size() && i < clone->_parameters.size(); i++)
+        {
+            DspParameter const& param = _parameters[i].second;
+
+            if (param.IsSet() && param.Type() != DspParameter::Trigger &&
+                param.Type() == clone->_parameters[i].second.Type())
+            {
+                clone->ParameterUpdating_(i, param);
+            }
+        }
+    }
+
+    return clone;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 void DspComponent::_SetParentCircuit(DspCircuit* parentCircuit)
 {
     if (_parentCircuit != parentCircuit && parentCircuit != this)
@@ -687,69 +883,127 @@ bool DspComponent::_FindOutput(int signalIndex, int& returnIndex) const
 void DspComponent::_SetBufferCount(int bufferCount)
 {
     // _bufferCount is the current thread count / bufferCount is new thread count
+    std::vector<_ThreadState*> threadStates;
 
-    // delete excess _hasTickeds (if new buffer count is less than current)
-    for (int i = _bufferCount - 1; i >= (int)bufferCount; i--)
-    {
-        delete _hasTickeds[i];
-    }
+    _GetThreadStates(bufferCount, threadStates);
+    _SwapThreadStates(threadStates, 0);
+    _FreeThreadStates(threadStates, bufferCount);
+}
 
-    // resize local buffer array
-    _hasTickeds.resize(bufferCount);
+//-------------------------------------------------------------------------------------------------
 
-    // create excess _hasTickeds (if new buffer count is more than current)
-    for (int i = _bufferCount; i < bufferCount; i++)
-    {
-        _hasTickeds[i] = new bool();
-    }
+int DspComponent::_GetBufferCount() const
+{
+    return _bufferCount;
+}
 
-    _inputBuses.resize(bufferCount);
-    _outputBuses.resize(bufferCount);
+//-------------------------------------------------------------------------------------------------
 
-    _gotReleases.resize(bufferCount);
-    _releaseMutexes.resize(bufferCount);
-    _releaseCondts.resize(bufferCount);
+void DspComponent::_GetThreadStates(int bufferCount, std::vector<_ThreadState*>& threadStates)
+{
+    // keep the current thread states up to the new buffer count
+    threadStates.assign(_threadStates.begin(), _threadStates.begin() + std::min(_bufferCount, bufferCount));
 
+    // create excess thread states (if new buffer count is more than current), allocated from the
+    // parent circuit's arena for the NUMA node of the threads that own them
     for (int i = _bufferCount; i < bufferCount; i++)
     {
-        *_hasTickeds[i] = false;
-        _gotReleases[i] = false;
+        DspArena* arena = _parentCircuit->_GetThreadStateArena();
+        _ThreadState* threadState = new (arena->Allocate()) _ThreadState(arena);
 
         for (int j = 0; j < _inputBus.GetSignalCount(); j++)
         {
-            _inputBuses[i]._AddSignal(_inputBus.GetSignal(j)->GetSignalName());
+            threadState->inputBus._AddSignal(_inputBus.GetSignal(j)->GetSignalName());
         }
 
         for (int j = 0; j < _outputBus.GetSignalCount(); j++)
         {
-            _outputBuses[i]._AddSignal(_outputBus.GetSignal(j)->GetSignalName());
+            threadState->outputBus._AddSignal(_outputBus.GetSignal(j)->GetSignalName());
         }
+
+        threadStates.push_back(threadState);
     }
+}
 
-    if (bufferCount > 0)
+//-------------------------------------------------------------------------------------------------
+
+void DspComponent::_SwapThreadStates(std::vector<_ThreadState*>& threadStates, int nextThread)
+{
+    // all circuit threads must be synced at this point
+    _threadStates.swap(threadStates);
+    _bufferCount = _threadStates.size();
+
+    // hand the release token to the thread to tick next
+    for (int i = 0; i < _bufferCount; i++)
     {
-        _gotReleases[0] = true;
+        _threadStates[i]->gotRelease.Store(i == nextThread ? 1 : 0);
     }
+}
+
+//-------------------------------------------------------------------------------------------------
 
-    _bufferCount = bufferCount;
+void DspComponent::_FreeThreadStates(std::vector<_ThreadState*> const& threadStates, int bufferCount)
+{
+    // return thread states beyond bufferCount to their arena
+    for (size_t i = bufferCount; i < threadStates.size(); i++)
+    {
+        DspArena* arena = threadStates[i]->arena;
+        threadStates[i]->~_ThreadState();
+        arena->Free(threadStates[i]);
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
 
-int DspComponent::_GetBufferCount() const
+size_t DspComponent::_GetThreadStateSize()
 {
-    return _bufferCount;
+    return sizeof(_ThreadState);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponent::_Process(DspSignalBus& inputs, DspSignalBus& outputs)
+{
+    // a single branch when neither profiling nor tracing
+    if (DspProfiler::IsEnabled() | DspTracer::IsTracing())
+    {
+        _TimeProcess(inputs, outputs);
+    }
+    else
+    {
+        Process_(inputs, outputs);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponent::_TimeProcess(DspSignalBus& inputs, DspSignalBus& outputs)
+{
+    unsigned long long start = DspTracer::_GetTime();
+    Process_(inputs, outputs);
+    unsigned long long end = DspTracer::_GetTime();
+
+    if (DspProfiler::IsEnabled())
+    {
+        DspProfiler::_Record(this, end - start);
+    }
+    if (DspTracer::IsTracing())
+    {
+        DspTracer::_RecordComponent(DspTracer::_ProcessEvent, this, start, end);
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DspComponent::_ThreadTick(int threadNo)
 {
+    _ThreadState* threadState = _threadStates[threadNo];
+
     // continue only if this component has not already been ticked
-    if (*_hasTickeds[threadNo] == false)
+    if (threadState->hasTicked == false)
     {
         // 1. set _hasTicked flag
-        *_hasTickeds[threadNo] = true;
+        threadState->hasTicked = true;
 
         // 2. get outputs required from input components
         for (int i = 0; i < _inputWires.GetWireCount(); i++)
@@ -757,18 +1011,18 @@ void DspComponent::_ThreadTick(int threadNo)
             DspWire* wire = _inputWires.GetWire(i);
             wire->linkedComponent->_ThreadTick(threadNo);
 
-            DspSignal* signal = wire->linkedComponent->_outputBuses[threadNo].GetSignal(wire->fromSignalIndex);
-            _inputBuses[threadNo].SetSignal(wire->toSignalIndex, signal);
+            DspSignal* signal = wire->linkedComponent->_threadStates[threadNo]->outputBus.GetSignal(wire->fromSignalIndex);
+            threadState->inputBus.SetSignal(wire->toSignalIndex, signal);
         }
 
         // 3. clear all outputs
-        _outputBuses[threadNo].ClearAllValues();
+        threadState->outputBus.ClearAllValues();
 
         // 4. wait for your turn to process.
         _WaitForRelease(threadNo);
 
         // 5. call Process_() with newly aquired inputs
-        Process_(_inputBuses[threadNo], _outputBuses[threadNo]);
+        _Process(threadState->inputBus, threadState->outputBus);
 
         // 6. signal that you're done processing.
         _ReleaseThread(threadNo);
@@ -779,11 +1033,52 @@ void DspComponent::_ThreadTick(int threadNo)
 
 void DspComponent::_ThreadReset(int threadNo)
 {
+    _ThreadState* threadState = _threadStates[threadNo];
+
     // clear all inputs
-    _inputBuses[threadNo].ClearAllValues();
+    threadState->inputBus.ClearAllValues();
 
     // reset _hasTicked flag
-    *_hasTickeds[threadNo] = false;
+    threadState->hasTicked = false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponent::_StreamTick(unsigned long tickNo, std::vector<int> const& wireDelays)
+{
+    // while streamed, the thread states form a ring of per-tick buses (see DspCircuit::Stream())
+    _ThreadState* threadState = _threadStates[tickNo % _bufferCount];
+
+    // 1. get the outputs of the required tick from input components (a feedback wire delivers the
+    // output of the previous tick, as when ticked)
+    for (int i = 0; i < _inputWires.GetWireCount(); i++)
+    {
+        DspWire* wire = _inputWires.GetWire(i);
+        _ThreadState* inputState = wire->linkedComponent->_threadStates[(tickNo + _bufferCount - wireDelays[i]) % _bufferCount];
+
+        threadState->inputBus.SetSignal(wire->toSignalIndex, inputState->outputBus.GetSignal(wire->fromSignalIndex));
+    }
+
+    // 2. clear all outputs
+    threadState->outputBus.ClearAllValues();
+
+    // 3. call Process_() with newly aquired inputs
+    _Process(threadState->inputBus, threadState->outputBus);
+
+    // 4. clear all inputs
+    threadState->inputBus.ClearAllValues();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponent::_CopySignals(DspSignalBus& fromBus, DspSignalBus& toBus)
+{
+    toBus.ClearAllValues();
+
+    for (int i = 0; i < fromBus.GetSignalCount(); i++)
+    {
+        toBus.SetSignal(i, fromBus.GetSignal(i));
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -797,7 +1092,7 @@ bool DspComponent::_SetInputSignal(int inputIndex, DspSignal const* newSignal)
 
 bool DspComponent::_SetInputSignal(int inputIndex, int threadIndex, DspSignal const* newSignal)
 {
-    return _inputBuses[threadIndex].SetSignal(inputIndex, newSignal);
+    return _threadStates[threadIndex]->inputBus.SetSignal(inputIndex, newSignal);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -811,20 +1106,30 @@ DspSignal* DspComponent::_GetOutputSignal(int outputIndex)
 
 DspSignal* DspComponent::_GetOutputSignal(int outputIndex, int threadIndex)
 {
-    return _outputBuses[threadIndex].GetSignal(outputIndex);
+    return _threadStates[threadIndex]->outputBus.GetSignal(outputIndex);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DspComponent::_WaitForRelease(int threadNo)
 {
-    _releaseMutexes[threadNo].Lock();
-    if (!_gotReleases[threadNo])
+    _ThreadState* threadState = _threadStates[threadNo];
+
+    // wait for release, and reset the release flag (traced only if not already released)
+    if (!threadState->gotRelease.CompareExchange(1, 0))
     {
-        _releaseCondts[threadNo].Wait(_releaseMutexes[threadNo]);  // wait for resume
+        unsigned long long waitStart = DspTracer::IsTracing() ? DspTracer::_GetTime() : 0;
+
+        while (!threadState->gotRelease.CompareExchange(1, 0))
+        {
+            threadState->gotRelease.Wait(0);
+        }
+
+        if (waitStart != 0)
+        {
+            DspTracer::_RecordComponent(DspTracer::_WaitEvent, this, waitStart, DspTracer::_GetTime());
+        }
     }
-    _gotReleases[threadNo] = false;  // reset the release flag
-    _releaseMutexes[threadNo].Unlock();
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -838,10 +1143,10 @@ void DspComponent::_ReleaseThread(int threadNo)
         nextThread = 0;
     }
 
-    _releaseMutexes[nextThread].Lock();
-    _gotReleases[nextThread] = true;
-    _releaseCondts[nextThread].WakeAll();
-    _releaseMutexes[nextThread].Unlock();
+    _ThreadState* threadState = _threadStates[nextThread];
+
+    threadState->gotRelease.Store(1);
+    threadState->gotRelease.WakeAll();
 }
 
 //=================================================================================================
@@ -25,13 +25,15 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 #include <dspatch/DspComponentThread.h>
 #include <dspatch/DspComponent.h>
 
+#include <algorithm>
+
 //=================================================================================================
 
 DspComponentThread::DspComponentThread()
     : _component(NULL)
     , _stop(false)
-    , _pause(false)
     , _stopped(true)
+    , _tickCount(0)
 {
 }
 
@@ -53,19 +55,30 @@ void DspComponentThread::Initialise(DspComponent* component)
 
 bool DspComponentThread::IsStopped() const
 {
-    return _stopped;
+    return _stopped.load(std::memory_order_acquire);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspComponentThread::GetTickCount() const
+{
+    return _tickCount.load(std::memory_order_relaxed);
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DspComponentThread::Start(Priority priority)
 {
-    if (_stopped)
+    if (IsStopped())
     {
-        _stop = false;
-        _stopped = false;
-        _pause = false;
-        DspThread::Start(priority);
+        _stop.store(false, std::memory_order_relaxed);
+        _stopped.store(false, std::memory_order_relaxed);
+        _tickCount.store(0, std::memory_order_relaxed);
+        _state.Store(_Running);
+        _placed.Store(0);
+        _affinity.clear();
+
+        DspThread::Start(priority);  // publishes the above to the new thread
     }
 }
 
@@ -73,65 +86,212 @@ void DspComponentThread::Start(Priority priority)
 
 void DspComponentThread::Stop()
 {
-    _stop = true;
+    _stop.store(true, std::memory_order_release);
 
-    while (_stopped != true)
-    {
-        _pauseCondt.WakeAll();
-        _resumeCondt.WakeAll();
-        MsSleep(1);
-    }
+    // release the thread if paused (or prevent it from pausing)
+    _state.Store(_Stopping);
+    _state.WakeAll();
 
-    DspThread::Stop();
+    DspThread::Stop();  // joins the thread
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DspComponentThread::Pause()
 {
-    _resumeMutex.Lock();
+    if (IsStopped())
+    {
+        return;
+    }
 
-    _pause = true;
-    _pauseCondt.Wait(_resumeMutex);  // wait for resume
-    _pause = false;
+    // ask the thread to pause (waking it from a paced sleep)
+    if (_state.CompareExchange(_Running, _Pausing))
+    {
+        _state.WakeAll();
+    }
 
-    _resumeMutex.Unlock();
+    // wait for the thread to pause (or stop)
+    int state;
+    while ((state = _state.Load()) == _Running || state == _Pausing)
+    {
+        _state.Wait(state);
+    }
 }
 
 //-------------------------------------------------------------------------------------------------
 
 void DspComponentThread::Resume()
 {
-    _resumeMutex.Lock();
-    _resumeCondt.WakeAll();
-    _resumeMutex.Unlock();
+    if (_state.CompareExchange(_Paused, _Running))
+    {
+        _state.WakeAll();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponentThread::SetThreadAffinity(std::vector<int> const& cpus)
+{
+    _cpus = cpus;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspComponentThread::GetThreadAffinity(std::vector<int>& cpus)
+{
+    _WaitForPlacement();
+
+    cpus = _affinity;
+    return !cpus.empty();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponentThread::SetSchedulingProfile(DspSchedulingProfile const& profile)
+{
+    _scheduling = profile;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspComponentThread::GetThreadScheduling(DspSchedulingProfile& effective)
+{
+    _WaitForPlacement();
+
+    effective = _effectiveScheduling;
+    return _placed.Load() != 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponentThread::SetTickPacing(DspTickPacing const& pacing)
+{
+    _pacing = pacing;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspTickPacing DspComponentThread::GetTickPacing() const
+{
+    return _pacing;
 }
 
 //=================================================================================================
 
 void DspComponentThread::_Run()
 {
+    // apply this thread's affinity and scheduling, then read back what the OS actually gave us
+    // (without CPUs, the thread is released from those of the thread that started it)
+    SetAffinity(_cpus);
+
+    SetScheduling(_scheduling, _effectiveScheduling);
+    GetAffinity(_affinity);
+
+    _placed.Store(1);  // publishes _affinity and _effectiveScheduling
+    _placed.WakeAll();
+
     if (_component != NULL)
     {
-        while (!_stop)
+        unsigned long long nextTick = GetMonotonicTime();
+        unsigned long backoff = 0;
+
+        while (!_stop.load(std::memory_order_acquire))
         {
+            unsigned long long tickStart = 0;
+            if (_pacing.mode != DspTickPacing::FreeRunning)
+            {
+                tickStart = GetMonotonicTime();
+            }
+
             _component->Tick();
             _component->Reset();
 
-            if (_pause)
+            _tickCount.store(_tickCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            if (_pacing.mode != DspTickPacing::FreeRunning)
             {
-                _resumeMutex.Lock();
+                _Pace(tickStart, nextTick, backoff);
+            }
 
-                _pauseCondt.WakeAll();
+            // signal Pause() that we're paused, then wait for Resume() (or Stop())
+            if (_state.CompareExchange(_Pausing, _Paused))
+            {
+                _state.WakeAll();
 
-                _resumeCondt.Wait(_resumeMutex);  // wait for resume
+                while (_state.Load() == _Paused)
+                {
+                    _state.Wait(_Paused);
+                }
 
-                _resumeMutex.Unlock();
+                // pace afresh from here (the pacing may have changed meanwhile)
+                nextTick = GetMonotonicTime();
+                backoff = 0;
             }
         }
     }
 
-    _stopped = true;
+    _stopped.store(true, std::memory_order_release);
+
+    // release Pause() callers waiting on a thread that is no longer running
+    _state.Store(_Stopping);
+    _state.WakeAll();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponentThread::_WaitForPlacement()
+{
+    // wait for the thread to apply the affinity and scheduling
+    while (_placed.Load() == 0 && !IsStopped())
+    {
+        _placed.Wait(0);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponentThread::_Pace(unsigned long long tickStart, unsigned long long& nextTick, unsigned long& backoff)
+{
+    unsigned long long now = GetMonotonicTime();
+
+    if (_pacing.mode == DspTickPacing::FixedRate)
+    {
+        // schedule the next tick a period after the last, dropping ticks missed by an overrun
+        nextTick += _pacing.period;
+
+        if (nextTick + _pacing.period <= now)
+        {
+            nextTick = now;
+        }
+        else if (nextTick > now)
+        {
+            _SleepUntil(nextTick);
+        }
+    }
+    else if (_pacing.mode == DspTickPacing::IdleBackoff)
+    {
+        // back off exponentially while ticks return without having waited on anything
+        if (now - tickStart < _pacing.idleTime)
+        {
+            backoff = backoff == 0 ? _pacing.minBackoff : std::min(backoff * 2, _pacing.maxBackoff);
+            _SleepUntil(now + backoff);
+        }
+        else
+        {
+            backoff = 0;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspComponentThread::_SleepUntil(unsigned long long time)
+{
+    // sleep on the thread state, such that Pause() and Stop() cut the sleep short
+    while (_state.Load() == _Running && GetMonotonicTime() < time)
+    {
+        _state.WaitUntil(_Running, time);
+    }
 }
 
 //=================================================================================================
@@ -0,0 +1,618 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <dspatch/DspEngine.h>
+#include <dspatch/DspCircuit.h>
+
+#include <algorithm>
+
+//=================================================================================================
+
+class DspEngine::_Worker : public DspThread
+{
+public:
+    _Worker()
+        : lease(NULL)
+        , retired(false)
+        , _job(NULL)
+        , _stop(false)
+        , _stopped(true)
+    {
+    }
+
+    ~_Worker()
+    {
+        Stop();
+    }
+
+    virtual void Start(Priority priority = NormalPriority)
+    {
+        _stop = false;
+        _stopped = false;
+        DspThread::Start(priority);
+    }
+
+    virtual void Stop()
+    {
+        _mutex.Lock();
+
+        _stop = true;
+        _jobCondt.WakeAll();
+
+        while (!_stopped)
+        {
+            _doneCondt.Wait(_mutex);
+        }
+
+        _mutex.Unlock();
+
+        DspThread::Stop();
+    }
+
+    void Assign(DspCircuitThread* job)
+    {
+        _mutex.Lock();
+
+        _job = job;
+        _jobCondt.WakeAll();
+
+        _mutex.Unlock();
+    }
+
+    void WaitForJob()
+    {
+        _mutex.Lock();
+
+        while (_job != NULL && !_stopped)
+        {
+            _doneCondt.Wait(_mutex);
+        }
+
+        _mutex.Unlock();
+    }
+
+public:
+    DspCircuitThread* lease;  // job leasing this worker (guarded by the engine's _workersMutex)
+    bool retired;             // scheduling could not be restored after a job, do not reuse
+
+private:
+    virtual void _Run()
+    {
+        // jobs apply their own scheduling, restore ours once each job is done
+        DspSchedulingProfile scheduling, effective;
+        GetScheduling(scheduling);
+
+        _mutex.Lock();
+
+        while (!_stop)
+        {
+            if (_job == NULL)
+            {
+                _jobCondt.Wait(_mutex);  // wait for a job
+                continue;
+            }
+
+            DspCircuitThread* job = _job;
+
+            _mutex.Unlock();
+
+            job->_Run();  // returns once the job is stopped
+
+            _mutex.Lock();
+
+            // E.g. an unprivileged thread cannot lower its nice value again
+            if (!SetScheduling(scheduling, effective))
+            {
+                retired = true;
+            }
+
+            _job = NULL;
+            _doneCondt.WakeAll();
+        }
+
+        _stopped = true;
+        _doneCondt.WakeAll();
+
+        _mutex.Unlock();
+    }
+
+private:
+    DspCircuitThread* _job;
+    bool _stop;
+    bool _stopped;
+    DspMutex _mutex;
+    DspWaitCondition _jobCondt, _doneCondt;
+};
+
+//=================================================================================================
+
+DspEngine::DspEngine(int workerCount)
+    : _workerCount(workerCount < 0 ? DspThread::GetCpuCount() : workerCount)
+    , _circuitThreadLimit(-1)
+    , _priority(DspThread::TimeCriticalPriority)
+    , _rootCircuit(new DspCircuit(0, this))
+{
+    _rootCircuit->_rootEngine = this;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspEngine::~DspEngine()
+{
+    // stop auto-ticking, remove all auto-ticked components and release the root circuit's threads
+    delete _rootCircuit;
+
+    // stop jobs still running on leased workers (this returns their workers to the pool)
+    std::vector<DspCircuitThread*> jobs;
+
+    _workersMutex.Lock();
+    for (size_t i = 0; i < _workers.size(); i++)
+    {
+        if (_workers[i]->lease != NULL)
+        {
+            jobs.push_back(_workers[i]->lease);
+        }
+    }
+    _workersMutex.Unlock();
+
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        jobs[i]->Stop();
+    }
+
+    for (size_t i = 0; i < _workers.size(); i++)
+    {
+        delete _workers[i];
+    }
+}
+
+//=================================================================================================
+
+int DspEngine::SetRootThreadCount(int threadCount)
+{
+    return _rootCircuit->SetThreadCount(threadCount);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspEngine::GetRootThreadCount() const
+{
+    return _rootCircuit->GetThreadCount();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::SetPriority(DspThread::Priority priority)
+{
+    _workersMutex.Lock();
+    _priority = priority;
+    _workersMutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspThread::Priority DspEngine::GetPriority() const
+{
+    _workersMutex.Lock();
+    DspThread::Priority priority = _priority;
+    _workersMutex.Unlock();
+
+    return priority;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::SetSchedulingProfile(DspSchedulingProfile const& profile)
+{
+    _workersMutex.Lock();
+    _scheduling = profile;
+    _workersMutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspSchedulingProfile DspEngine::GetSchedulingProfile() const
+{
+    _workersMutex.Lock();
+    DspSchedulingProfile profile = _scheduling;
+    _workersMutex.Unlock();
+
+    return profile;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::SetPlacement(DspThreadPlacement const& placement)
+{
+    _workersMutex.Lock();
+    _placement = placement;
+    _workersMutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspThreadPlacement DspEngine::GetPlacement() const
+{
+    _workersMutex.Lock();
+    DspThreadPlacement placement = _placement;
+    _workersMutex.Unlock();
+
+    return placement;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::SetAutoTickPacing(DspTickPacing const& pacing)
+{
+    _workersMutex.Lock();
+    _pacing = pacing;
+    _workersMutex.Unlock();
+
+    // hand the pacing to the auto-tick thread while it is paused
+    _rootCircuit->PauseAutoTick();
+    _rootCircuit->_componentThread.SetTickPacing(pacing);
+    _rootCircuit->ResumeAutoTick();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspTickPacing DspEngine::GetAutoTickPacing() const
+{
+    _workersMutex.Lock();
+    DspTickPacing pacing = _pacing;
+    _workersMutex.Unlock();
+
+    return pacing;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::SetWorkerCount(int workerCount)
+{
+    std::vector<_Worker*> idleWorkers;
+
+    _workersMutex.Lock();
+
+    _workerCount = workerCount < 0 ? DspThread::GetCpuCount() : workerCount;
+    _TrimIdleWorkers(idleWorkers);
+
+    _workersMutex.Unlock();
+
+    for (size_t i = 0; i < idleWorkers.size(); i++)
+    {
+        delete idleWorkers[i];
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspEngine::GetWorkerCount() const
+{
+    _workersMutex.Lock();
+    int workerCount = _workerCount;
+    _workersMutex.Unlock();
+
+    return workerCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::SetCircuitThreadLimit(int threadLimit)
+{
+    _workersMutex.Lock();
+    _circuitThreadLimit = threadLimit;
+    _workersMutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspEngine::GetCircuitThreadLimit() const
+{
+    _workersMutex.Lock();
+    int threadLimit = _circuitThreadLimit;
+    _workersMutex.Unlock();
+
+    return threadLimit;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspEngine::GetComponentCount() const
+{
+    return _rootCircuit->GetComponentCount();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspEngine::GetAutoTickCount() const
+{
+    return _rootCircuit->_componentThread.GetTickCount();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspEngine::GetActiveWorkerCount() const
+{
+    int activeCount = 0;
+
+    _workersMutex.Lock();
+    for (size_t i = 0; i < _workers.size(); i++)
+    {
+        if (_workers[i]->lease != NULL)
+        {
+            ++activeCount;
+        }
+    }
+    _workersMutex.Unlock();
+
+    return activeCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspEngine::GetIdleWorkerCount() const
+{
+    _workersMutex.Lock();
+    int idleCount = _workers.size();
+    for (size_t i = 0; i < _workers.size(); i++)
+    {
+        if (_workers[i]->lease != NULL)
+        {
+            --idleCount;
+        }
+    }
+    _workersMutex.Unlock();
+
+    return idleCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspEngine::GetAutoTickAffinity(std::vector<int>& cpus) const
+{
+    return _rootCircuit->_componentThread.GetThreadAffinity(cpus);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspEngine::GetAutoTickScheduling(DspSchedulingProfile& effective) const
+{
+    return _rootCircuit->_componentThread.GetThreadScheduling(effective);
+}
+
+//=================================================================================================
+
+bool DspEngine::_AddComponent(DspComponent* component)
+{
+    return _rootCircuit->AddComponent(component);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::_RemoveComponent(DspComponent const* component)
+{
+    _rootCircuit->RemoveComponent(component);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::_StartAutoTick()
+{
+    _rootCircuit->StartAutoTick();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::_StopAutoTick()
+{
+    _rootCircuit->StopAutoTick();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::_Finalize()
+{
+    _rootCircuit->StopAutoTick();
+    _rootCircuit->RemoveAllComponents();
+    _rootCircuit->SetThreadCount(0);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspEngine::_GetThreadLimit(int threadCount) const
+{
+    _workersMutex.Lock();
+
+    if (threadCount > _workerCount)
+    {
+        threadCount = _workerCount;
+    }
+    if (_circuitThreadLimit >= 0 && threadCount > _circuitThreadLimit)
+    {
+        threadCount = _circuitThreadLimit;
+    }
+
+    _workersMutex.Unlock();
+
+    return threadCount < 0 ? 0 : threadCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::_GetThreadCpus(DspThreadPlacement const& placement, int threadNo, std::vector<int>& cpus) const
+{
+    // a circuit's own placement overrides the engine's placement
+    placement.GetThreadCpus(threadNo, cpus);
+
+    if (cpus.empty())
+    {
+        GetPlacement().GetThreadCpus(threadNo, cpus);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspSchedulingProfile DspEngine::_GetThreadScheduling(DspSchedulingProfile const& profile) const
+{
+    // a circuit's own profile overrides the engine's profile, which overrides the engine's priority
+    if (profile.policy != DspSchedulingProfile::InheritPolicy)
+    {
+        return profile;
+    }
+
+    _workersMutex.Lock();
+    DspSchedulingProfile scheduling = _scheduling;
+    if (scheduling.policy == DspSchedulingProfile::InheritPolicy)
+    {
+        scheduling = DspThread::GetPriorityProfile(_priority);
+    }
+    _workersMutex.Unlock();
+
+    return scheduling;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspEngine::_Acquire(DspCircuitThread* job)
+{
+    // Workers are only leased under the lock. Starting a new worker's thread and handing it the
+    // job are done once unlocked, the lease keeping other jobs off the worker in the meantime.
+    _workersMutex.Lock();
+
+    _Worker* worker = NULL;
+    bool isNew = false;
+    int activeCount = 0;
+
+    for (size_t i = 0; i < _workers.size(); i++)
+    {
+        if (_workers[i]->lease != NULL)
+        {
+            ++activeCount;
+        }
+        else if (worker == NULL)
+        {
+            worker = _workers[i];
+        }
+    }
+
+    if (activeCount >= _workerCount)
+    {
+        worker = NULL;  // all workers are busy
+    }
+    else if (worker == NULL)
+    {
+        // no idle worker available, add a new one
+        worker = new _Worker();
+        isNew = true;
+        _workers.push_back(worker);
+    }
+
+    if (worker != NULL)
+    {
+        worker->lease = job;
+    }
+
+    _workersMutex.Unlock();
+
+    if (worker == NULL)
+    {
+        return false;
+    }
+
+    if (isNew)
+    {
+        worker->Start();
+    }
+    worker->Assign(job);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::_Release(DspCircuitThread* job)
+{
+    // Waiting for the job to return and stopping workers are done once unlocked, such that other
+    // circuits can acquire and release workers meanwhile. Until then, the lease keeps other jobs
+    // off the worker.
+    _workersMutex.Lock();
+
+    _Worker* worker = NULL;
+    for (size_t i = 0; i < _workers.size(); i++)
+    {
+        if (_workers[i]->lease == job)
+        {
+            worker = _workers[i];
+            break;
+        }
+    }
+
+    _workersMutex.Unlock();
+
+    if (worker != NULL)
+    {
+        worker->WaitForJob();
+    }
+
+    std::vector<_Worker*> idleWorkers;
+
+    _workersMutex.Lock();
+
+    if (worker != NULL)
+    {
+        worker->lease = NULL;
+
+        if (worker->retired)
+        {
+            _workers.erase(std::find(_workers.begin(), _workers.end(), worker));
+            idleWorkers.push_back(worker);
+        }
+    }
+
+    _TrimIdleWorkers(idleWorkers);
+
+    _workersMutex.Unlock();
+
+    for (size_t i = 0; i < idleWorkers.size(); i++)
+    {
+        delete idleWorkers[i];
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspEngine::_TrimIdleWorkers(std::vector<_Worker*>& idleWorkers)
+{
+    // remove idle workers in excess of the worker count (the caller stops them once unlocked)
+    for (size_t i = _workers.size(); i-- > 0 && (int)_workers.size() > _workerCount;)
+    {
+        if (_workers[i]->lease == NULL)
+        {
+            idleWorkers.push_back(_workers[i]);
+            _workers.erase(_workers.begin() + i);
+        }
+    }
+}
+
+//=================================================================================================
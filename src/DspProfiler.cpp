@@ -0,0 +1,416 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <dspatch/DspProfiler.h>
+#include <dspatch/DspArena.h>
+#include <dspatch/DspComponent.h>
+
+#include <algorithm>
+#include <new>
+
+//=================================================================================================
+
+// one thread's counters for one component, on cache lines of their own (see DspArena)
+struct DspProfiler::_Counters
+{
+    _Counters()
+        : callCount(0)
+        , totalTime(0)
+        , maxTime(0)
+    {
+        for (int i = 0; i < DspComponentProfile::bucketCount; i++)
+        {
+            histogram[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Clear()
+    {
+        callCount.store(0, std::memory_order_relaxed);
+        totalTime.store(0, std::memory_order_relaxed);
+        maxTime.store(0, std::memory_order_relaxed);
+
+        for (int i = 0; i < DspComponentProfile::bucketCount; i++)
+        {
+            histogram[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<unsigned long long> callCount;
+    std::atomic<unsigned long long> totalTime;  // in nanoseconds
+    std::atomic<unsigned long long> maxTime;    // in nanoseconds
+    std::atomic<unsigned long long> histogram[DspComponentProfile::bucketCount];
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// all counters of one component, indexed by thread slot
+struct DspProfiler::_Profile
+{
+    _Profile(DspComponent* newComponent)
+        : component(newComponent)
+    {
+        for (int i = 0; i < _threadSlotCount; i++)
+        {
+            counters[i].store(NULL, std::memory_order_relaxed);
+        }
+    }
+
+    DspComponent* component;
+    std::atomic<_Counters*> counters[_threadSlotCount];
+};
+
+//-------------------------------------------------------------------------------------------------
+
+struct DspProfiler::_State
+{
+    _State()
+        : arena(sizeof(_Counters))
+        , nextThreadSlot(0)
+        , snapshotThread(NULL)
+    {
+    }
+
+    DspMutex mutex;  // guards the arena and profiles
+    DspArena arena;
+    std::vector<_Profile*> profiles;
+    std::atomic<int> nextThreadSlot;
+
+    DspMutex snapshotMutex;  // guards the snapshot thread
+    _SnapshotThread* snapshotThread;
+};
+
+//-------------------------------------------------------------------------------------------------
+
+class DspProfiler::_SnapshotThread : public DspThread
+{
+public:
+    _SnapshotThread(unsigned long interval, SnapshotCallback_t callback, void* userData)
+        : _interval(interval)
+        , _callback(callback)
+        , _userData(userData)
+        , _stop(0)
+    {
+    }
+
+    ~_SnapshotThread()
+    {
+        Stop();
+    }
+
+    virtual void Stop()
+    {
+        _stop.Store(1);
+        _stop.WakeAll();
+
+        DspThread::Stop();
+    }
+
+private:
+    virtual void _Run()
+    {
+        std::vector<DspComponentProfile> profiles;
+        unsigned long long nextSnapshot = GetMonotonicTime() + _interval;
+
+        while (true)
+        {
+            // sleep on the stop flag, such that Stop() cuts the sleep short
+            while (_stop.Load() == 0 && GetMonotonicTime() < nextSnapshot)
+            {
+                _stop.WaitUntil(0, nextSnapshot);
+            }
+            if (_stop.Load() != 0)
+            {
+                return;
+            }
+
+            DspProfiler::GetProfiles(profiles);
+            _callback(profiles, _userData);
+
+            // skip the snapshots missed while the callback overran the interval
+            nextSnapshot = std::max(nextSnapshot + _interval, GetMonotonicTime());
+        }
+    }
+
+    unsigned long _interval;
+    SnapshotCallback_t _callback;
+    void* _userData;
+    DspFutex _stop;
+};
+
+//=================================================================================================
+
+std::atomic<bool> DspProfiler::_enabled(false);
+
+//=================================================================================================
+
+void DspProfiler::SetEnabled(bool enabled)
+{
+    _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspProfiler::Reset()
+{
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    for (size_t i = 0; i < state.profiles.size(); i++)
+    {
+        for (int j = 0; j < _threadSlotCount; j++)
+        {
+            _Counters* counters = state.profiles[i]->counters[j].load(std::memory_order_relaxed);
+            if (counters != NULL)
+            {
+                counters->Clear();
+            }
+        }
+    }
+
+    state.mutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspProfiler::GetProfile(DspComponent const* component, DspComponentProfile& profile)
+{
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    _Profile const* componentProfile = component->_profile.load(std::memory_order_relaxed);
+    if (componentProfile != NULL)
+    {
+        _ReadProfile(componentProfile, profile);
+    }
+
+    state.mutex.Unlock();
+
+    return componentProfile != NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspProfiler::GetProfiles(std::vector<DspComponentProfile>& profiles)
+{
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    profiles.resize(state.profiles.size());
+    for (size_t i = 0; i < state.profiles.size(); i++)
+    {
+        _ReadProfile(state.profiles[i], profiles[i]);
+    }
+
+    state.mutex.Unlock();
+
+    std::stable_sort(profiles.begin(), profiles.end(), _IsLonger);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspProfiler::StartSnapshots(unsigned long interval, SnapshotCallback_t callback, void* userData)
+{
+    StopSnapshots();
+
+    if (interval == 0 || callback == NULL)
+    {
+        return;
+    }
+
+    _State& state = _GetState();
+
+    state.snapshotMutex.Lock();
+
+    state.snapshotThread = new _SnapshotThread(interval, callback, userData);
+    state.snapshotThread->Start();
+
+    state.snapshotMutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspProfiler::StopSnapshots()
+{
+    _State& state = _GetState();
+
+    state.snapshotMutex.Lock();
+
+    if (state.snapshotThread != NULL)
+    {
+        delete state.snapshotThread;
+        state.snapshotThread = NULL;
+    }
+
+    state.snapshotMutex.Unlock();
+}
+
+//=================================================================================================
+
+DspProfiler::_State& DspProfiler::_GetState()
+{
+    // never deleted: components (and their profiles) may outlive Finalize()
+    static _State* state = new _State();
+    return *state;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspProfiler::_Record(DspComponent* component, unsigned long long time)
+{
+    // threads take turns at the slots, threads beyond the slot count sharing them
+    static thread_local int threadSlot = _GetState().nextThreadSlot.fetch_add(1, std::memory_order_relaxed) % _threadSlotCount;
+
+    _Profile* profile = component->_profile.load(std::memory_order_acquire);
+    _Counters* counters = profile != NULL ? profile->counters[threadSlot].load(std::memory_order_acquire) : NULL;
+
+    if (counters == NULL)
+    {
+        counters = _AddCounters(component, threadSlot);  // once per component and thread slot
+    }
+
+    int bucket = 0;
+    for (unsigned long long limit = time >> 1; limit > 0 && bucket < DspComponentProfile::bucketCount - 1; limit >>= 1)
+    {
+        bucket++;
+    }
+
+    counters->callCount.fetch_add(1, std::memory_order_relaxed);
+    counters->totalTime.fetch_add(time, std::memory_order_relaxed);
+    counters->histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    unsigned long long maxTime = counters->maxTime.load(std::memory_order_relaxed);
+    while (time > maxTime && !counters->maxTime.compare_exchange_weak(maxTime, time, std::memory_order_relaxed))
+    {
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspProfiler::_Counters* DspProfiler::_AddCounters(DspComponent* component, int threadSlot)
+{
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    _Profile* profile = component->_profile.load(std::memory_order_relaxed);
+    if (profile == NULL)
+    {
+        profile = new _Profile(component);
+        state.profiles.push_back(profile);
+        component->_profile.store(profile, std::memory_order_release);
+    }
+
+    _Counters* counters = profile->counters[threadSlot].load(std::memory_order_relaxed);
+    if (counters == NULL)
+    {
+        counters = new (state.arena.Allocate()) _Counters();
+        profile->counters[threadSlot].store(counters, std::memory_order_release);
+    }
+
+    state.mutex.Unlock();
+
+    return counters;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspProfiler::_ReadProfile(_Profile const* profile, DspComponentProfile& result)
+{
+    unsigned long long totalTime = 0;
+    unsigned long long maxTime = 0;
+
+    result.component = profile->component;
+    result.componentName = profile->component->GetComponentName();
+    result.callCount = 0;
+    result.histogram.assign(DspComponentProfile::bucketCount, 0);
+
+    for (int i = 0; i < _threadSlotCount; i++)
+    {
+        _Counters const* counters = profile->counters[i].load(std::memory_order_acquire);
+        if (counters == NULL)
+        {
+            continue;
+        }
+
+        result.callCount += counters->callCount.load(std::memory_order_relaxed);
+        totalTime += counters->totalTime.load(std::memory_order_relaxed);
+        maxTime = std::max(maxTime, counters->maxTime.load(std::memory_order_relaxed));
+
+        for (int j = 0; j < DspComponentProfile::bucketCount; j++)
+        {
+            result.histogram[j] += counters->histogram[j].load(std::memory_order_relaxed);
+        }
+    }
+
+    result.totalTime = totalTime / 1000.0;
+    result.maxTime = maxTime / 1000.0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspProfiler::_IsLonger(DspComponentProfile const& lhs, DspComponentProfile const& rhs)
+{
+    return lhs.totalTime > rhs.totalTime;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspProfiler::_Release(DspComponent* component)
+{
+    // most components are never timed: their destruction takes no lock (nor creates the state)
+    if (component->_profile.load(std::memory_order_acquire) == NULL)
+    {
+        return;
+    }
+
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    _Profile* profile = component->_profile.load(std::memory_order_relaxed);
+    if (profile != NULL)
+    {
+        for (int i = 0; i < _threadSlotCount; i++)
+        {
+            _Counters* counters = profile->counters[i].load(std::memory_order_relaxed);
+            if (counters != NULL)
+            {
+                counters->~_Counters();
+                state.arena.Free(counters);
+            }
+        }
+
+        state.profiles.erase(std::find(state.profiles.begin(), state.profiles.end(), profile));
+        component->_profile.store(NULL, std::memory_order_relaxed);
+        delete profile;
+    }
+
+    state.mutex.Unlock();
+}
+
+//=================================================================================================
@@ -0,0 +1,616 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <dspatch/DspTickSource.h>
+#include <dspatch/DspComponent.h>
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <errno.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+//=================================================================================================
+
+class DspTickSource::_Thread : public DspThread
+{
+public:
+    _Thread(DspTickSource* source)
+        : _source(source)
+    {
+    }
+
+    ~_Thread()
+    {
+        Stop();
+    }
+
+private:
+    virtual void _Run()
+    {
+        _source->Run_();
+    }
+
+    DspTickSource* _source;
+};
+
+//=================================================================================================
+
+DspTickSource::DspTickSource()
+    : _component(NULL)
+    , _state(_Stopped)
+    , _pauseCount(0)
+    , _tickCount(0)
+    , _thread(NULL)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspTickSource::~DspTickSource()
+{
+    Detach();
+    StopThread_();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspTickSource::Attach(DspComponent* component)
+{
+    if (component == _component)
+    {
+        return component != NULL;
+    }
+
+    // only a free standing component may be attached (not one auto-ticking, or in a circuit)
+    if (component == NULL || component->_parentCircuit != NULL || component->_rootEngine != NULL ||
+        component->_tickSource != NULL)
+    {
+        return false;
+    }
+
+    Detach();
+
+    _Pause();
+    _component = component;
+    _component->_tickSource = this;
+    _Resume();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspTickSource::Attach(DspComponent& component)
+{
+    return Attach(&component);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTickSource::Detach()
+{
+    if (_component != NULL)
+    {
+        // wait for the tick in flight (if any) before letting go of the component
+        _Pause();
+        _component->_tickSource = NULL;
+        _component = NULL;
+        _Resume();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspComponent* DspTickSource::GetComponent() const
+{
+    return _component;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspTickSource::Start()
+{
+    if (IsStarted())
+    {
+        return true;
+    }
+
+    _tickCount.store(0, std::memory_order_relaxed);
+    _SetState(0, _Stopped);
+
+    if (!Start_())
+    {
+        _SetState(_Stopped, 0);
+        return false;
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTickSource::Stop()
+{
+    if (!IsStarted())
+    {
+        return;
+    }
+
+    // no tick starts once stopped, and a source waiting to be resumed gives up
+    _SetState(_Stopped, 0);
+
+    Stop_();
+
+    // wait for the tick in flight (E.g. a callback tick) to finish
+    int state = _state.Load();
+    while ((state & _Ticking) != 0)
+    {
+        _state.Wait(state);
+        state = _state.Load();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspTickSource::IsStarted() const
+{
+    return (_state.Load() & _Stopped) == 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspTickSource::GetTickCount() const
+{
+    return _tickCount.load(std::memory_order_relaxed);
+}
+
+//=================================================================================================
+
+void DspTickSource::Run_()
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspTickSource::Tick_(bool waitIfPaused)
+{
+    // claim the tick, unless stopped, or paused and not to wait
+    while (!_state.CompareExchange(_Idle, _Ticking))
+    {
+        int state = _state.Load();
+
+        if (!waitIfPaused || (state & _Stopped) != 0)
+        {
+            return false;
+        }
+        else if (state != _Idle)
+        {
+            _state.Wait(state);
+        }
+    }
+
+    bool ticked = false;
+
+    if (_component != NULL)
+    {
+        _component->Tick();
+        _component->Reset();
+
+        _tickCount.store(_tickCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        ticked = true;
+    }
+
+    _SetState(0, _Ticking);
+
+    return ticked;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspTickSource::StartThread_(DspThread::Priority priority)
+{
+    StopThread_();
+
+    _thread = new _Thread(this);
+    _thread->Start(priority);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTickSource::StopThread_()
+{
+    if (_thread != NULL)
+    {
+        _thread->Stop();
+        delete _thread;
+        _thread = NULL;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspTickSource::WaitUntil_(unsigned long long time)
+{
+    // sleep on the source state, such that Stop() cuts the sleep short
+    int state = _state.Load();
+
+    while ((state & _Stopped) == 0 && DspThread::GetMonotonicTime() < time)
+    {
+        _state.WaitUntil(state, time);
+        state = _state.Load();
+    }
+
+    return (state & _Stopped) == 0;
+}
+
+//=================================================================================================
+
+void DspTickSource::_Pause()
+{
+    if (_pauseCount++ != 0)
+    {
+        return;  // already paused
+    }
+
+    // set the pause bit as soon as no tick is in flight
+    int state = _state.Load();
+
+    while (true)
+    {
+        if ((state & _Ticking) != 0)
+        {
+            _state.Wait(state);
+        }
+        else if (_state.CompareExchange(state, state | _Paused))
+        {
+            break;
+        }
+
+        state = _state.Load();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTickSource::_Resume()
+{
+    if (_pauseCount > 0 && --_pauseCount == 0)
+    {
+        _SetState(0, _Paused);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTickSource::_SetState(int set, int clear)
+{
+    int state = _state.Load();
+
+    while (!_state.CompareExchange(state, (state & ~clear) | set))
+    {
+        state = _state.Load();
+    }
+
+    _state.WakeAll();
+}
+
+//=================================================================================================
+
+DspCallbackTickSource::DspCallbackTickSource()
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspCallbackTickSource::~DspCallbackTickSource()
+{
+    Stop();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCallbackTickSource::Tick()
+{
+    return Tick_(false);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspCallbackTickSource::Start_()
+{
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspCallbackTickSource::Stop_()
+{
+}
+
+//=================================================================================================
+
+DspTimerTickSource::DspTimerTickSource(unsigned long period, DspThread::Priority priority)
+    : _period(period)
+    , _priority(priority)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspTimerTickSource::~DspTimerTickSource()
+{
+    Stop();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTimerTickSource::SetPeriod(unsigned long period)
+{
+    if (!IsStarted())
+    {
+        _period = period;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long DspTimerTickSource::GetPeriod() const
+{
+    return _period;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspTimerTickSource::Start_()
+{
+    return StartThread_(_priority);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTimerTickSource::Stop_()
+{
+    StopThread_();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTimerTickSource::Run_()
+{
+    unsigned long long nextTick = DspThread::GetMonotonicTime();
+
+    while (IsStarted())
+    {
+        Tick_(true);
+
+        // schedule the next tick a period after the last, dropping ticks missed by an overrun
+        unsigned long long now = DspThread::GetMonotonicTime();
+        nextTick += _period;
+
+        if (nextTick + _period <= now)
+        {
+            nextTick = now;
+        }
+        else if (nextTick > now)
+        {
+            WaitUntil_(nextTick);
+        }
+    }
+}
+
+//=================================================================================================
+
+DspFdTickSource::DspFdTickSource(DspThread::Priority priority)
+    : _priority(priority)
+    , _epollFd(-1)
+    , _stopFd(-1)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspFdTickSource::~DspFdTickSource()
+{
+    Stop();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspFdTickSource::AddFd(int fd)
+{
+    _fdsMutex.Lock();
+
+    bool added = fd >= 0 && std::find(_fds.begin(), _fds.end(), fd) == _fds.end();
+
+    if (added)
+    {
+#ifdef __linux__
+        if (_epollFd != -1)
+        {
+            struct epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+
+            added = epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+        }
+#endif
+
+        if (added)
+        {
+            _fds.push_back(fd);
+        }
+    }
+
+    _fdsMutex.Unlock();
+
+    return added;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspFdTickSource::RemoveFd(int fd)
+{
+    _fdsMutex.Lock();
+
+    std::vector<int>::iterator it = std::find(_fds.begin(), _fds.end(), fd);
+    bool removed = it != _fds.end();
+
+    if (removed)
+    {
+        _fds.erase(it);
+
+#ifdef __linux__
+        if (_epollFd != -1)
+        {
+            epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, NULL);
+        }
+#endif
+    }
+
+    _fdsMutex.Unlock();
+
+    return removed;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspFdTickSource::GetFdCount() const
+{
+    _fdsMutex.Lock();
+    int fdCount = _fds.size();
+    _fdsMutex.Unlock();
+
+    return fdCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspFdTickSource::Start_()
+{
+#ifdef __linux__
+    _fdsMutex.Lock();
+
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    _stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    bool started = _epollFd != -1 && _stopFd != -1;
+
+    // the stop event wakes the thread on Stop(), then every descriptor wakes it to tick
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = _stopFd;
+
+    started = started && epoll_ctl(_epollFd, EPOLL_CTL_ADD, _stopFd, &event) == 0;
+
+    for (size_t i = 0; i < _fds.size() && started; i++)
+    {
+        event.data.fd = _fds[i];
+        started = epoll_ctl(_epollFd, EPOLL_CTL_ADD, _fds[i], &event) == 0;
+    }
+
+    _fdsMutex.Unlock();
+
+    if (started)
+    {
+        return StartThread_(_priority);
+    }
+
+    Stop_();
+#endif
+
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspFdTickSource::Stop_()
+{
+#ifdef __linux__
+    if (_stopFd != -1)
+    {
+        uint64_t value = 1;
+        if (write(_stopFd, &value, sizeof(value)) != sizeof(value))
+        {
+            // the counter is non-zero already, hence the thread is being woken anyway
+        }
+    }
+
+    StopThread_();
+
+    _fdsMutex.Lock();
+
+    if (_epollFd != -1)
+    {
+        close(_epollFd);
+        _epollFd = -1;
+    }
+    if (_stopFd != -1)
+    {
+        close(_stopFd);
+        _stopFd = -1;
+    }
+
+    _fdsMutex.Unlock();
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspFdTickSource::Run_()
+{
+#ifdef __linux__
+    struct epoll_event events[16];
+
+    while (IsStarted())
+    {
+        int eventCount = epoll_wait(_epollFd, events, 16, -1);
+
+        if (eventCount < 0 && errno != EINTR)
+        {
+            break;
+        }
+
+        // tick once per wake up, however many descriptors are ready
+        bool ready = false;
+        for (int i = 0; i < eventCount; i++)
+        {
+            ready = ready || events[i].data.fd != _stopFd;
+        }
+
+        if (ready)
+        {
+            Tick_(true);
+        }
+    }
+#endif
+}
+
+//=================================================================================================
@@ -0,0 +1,440 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <dspatch/DspTracer.h>
+#include <dspatch/DspComponent.h>
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+//=================================================================================================
+
+struct DspTracer::_Event
+{
+    std::atomic<unsigned long long> start;  // in nanoseconds
+    std::atomic<unsigned long long> end;    // in nanoseconds
+    std::atomic<unsigned int> info;         // type (top 8 bits) and component name or thread number
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// the events of one thread, written by that thread only
+struct DspTracer::_Ring
+{
+    _Ring(int newThreadNo)
+        : threadNo(newThreadNo)
+        , eventCount(0)
+    {
+    }
+
+    int threadNo;
+    std::atomic<unsigned long long> eventCount;  // events recorded since Start() (including overwritten)
+    _Event events[_ringSize];
+};
+
+//-------------------------------------------------------------------------------------------------
+
+struct DspTracer::_State
+{
+    _State()
+        : origin(0)
+    {
+        names.push_back("");
+    }
+
+    DspMutex mutex;  // guards all below
+    std::vector<_Ring*> rings;
+    std::vector<_Ring*> freeRings;     // rings of exited threads, cleared for reuse
+    std::vector<_Ring*> retiredRings;  // rings of exited threads, kept until the next Start()
+    std::vector<std::string> names;    // component names, by trace id (0: none)
+    unsigned long long origin;         // time of Start()
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// hands a thread's ring back once the thread exits
+class DspTracer::_RingOwner
+{
+public:
+    _RingOwner()
+        : ring(NULL)
+    {
+    }
+
+    ~_RingOwner()
+    {
+        if (ring != NULL)
+        {
+            DspTracer::_RetireRing(ring);
+        }
+    }
+
+    _Ring* ring;
+};
+
+//=================================================================================================
+
+std::atomic<bool> DspTracer::_tracing(false);
+
+//=================================================================================================
+
+void DspTracer::Start()
+{
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    for (size_t i = 0; i < state.rings.size(); i++)
+    {
+        state.rings[i]->eventCount.store(0, std::memory_order_relaxed);
+    }
+
+    state.freeRings.insert(state.freeRings.end(), state.retiredRings.begin(), state.retiredRings.end());
+    state.retiredRings.clear();
+
+    // events a thread was still recording meanwhile predate the origin, and are left out
+    state.origin = _GetTime();
+
+    state.mutex.Unlock();
+
+    _tracing.store(true, std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTracer::Stop()
+{
+    _tracing.store(false, std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTracer::WriteChromeTrace(std::ostream& stream)
+{
+    static char const* const eventNames[] = { "Tick", "", "Wait", "Sync", "Edit", "Edit" };
+    static char const* const categories[] = { "tick", "process", "wait", "sync", "edit", "edit" };
+    static char const* const phases[] = { "X", "X", "X", "X", "B", "E" };
+
+    _State& state = _GetState();
+
+    std::vector<unsigned long long> starts;
+    std::vector<unsigned long long> ends;
+    std::vector<unsigned int> infos;
+
+    state.mutex.Lock();
+
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    for (size_t i = 0; i < state.rings.size(); i++)
+    {
+        _Ring* ring = state.rings[i];
+
+        stream << (i == 0 ? "\n" : ",\n");
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadNo
+               << ",\"args\":{\"name\":\"DSPatch thread " << ring->threadNo << "\"}}";
+
+        // copy the ring's events, then drop those its thread overwrote whilst being copied
+        unsigned long long eventCount = ring->eventCount.load(std::memory_order_acquire);
+        unsigned long long firstEvent = eventCount > (unsigned long long)_ringSize ? eventCount - _ringSize : 0;
+
+        starts.clear();
+        ends.clear();
+        infos.clear();
+
+        for (unsigned long long j = firstEvent; j < eventCount; j++)
+        {
+            _Event const& event = ring->events[j % _ringSize];
+
+            starts.push_back(event.start.load(std::memory_order_relaxed));
+            ends.push_back(event.end.load(std::memory_order_relaxed));
+            infos.push_back(event.info.load(std::memory_order_relaxed));
+        }
+
+        // then re-read the count: had any event copied been (partly) overwritten, the count now
+        // reads past its overwriter, and while it reads N, event N may be being written over
+        // event N - _ringSize (see _Record())
+        std::atomic_thread_fence(std::memory_order_acquire);
+        unsigned long long overwritten = ring->eventCount.load(std::memory_order_relaxed) + 1;
+        overwritten = overwritten > (unsigned long long)_ringSize ? overwritten - _ringSize : 0;
+
+        for (size_t j = 0; j < starts.size(); j++)
+        {
+            if (firstEvent + j < overwritten || starts[j] < state.origin)
+            {
+                continue;
+            }
+
+            int type = infos[j] >> 24;
+            unsigned int id = infos[j] & 0xFFFFFF;
+
+            stream << ",\n{\"name\":";
+            _WriteString(stream, type == _ProcessEvent ? state.names[id] : eventNames[type]);
+            stream << ",\"cat\":\"" << categories[type] << "\",\"ph\":\"" << phases[type] << "\",\"ts\":";
+            _WriteTime(stream, starts[j] - state.origin);
+
+            if (*phases[type] == 'X')
+            {
+                stream << ",\"dur\":";
+                _WriteTime(stream, ends[j] - starts[j]);
+            }
+
+            stream << ",\"pid\":1,\"tid\":" << ring->threadNo;
+
+            if (type == _TickEvent || type == _SyncEvent)
+            {
+                stream << ",\"args\":{\"thread\":" << id << "}";
+            }
+            else if (type != _ProcessEvent && id != 0)
+            {
+                stream << ",\"args\":{\"component\":";
+                _WriteString(stream, state.names[id]);
+                stream << "}";
+            }
+
+            stream << "}";
+        }
+    }
+
+    stream << "\n]}\n";
+
+    state.mutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+bool DspTracer::SaveChromeTrace(std::string const& filePath)
+{
+    std::ofstream file(filePath.c_str(), std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    WriteChromeTrace(file);
+    file.close();
+
+    return !file.fail();
+}
+
+//=================================================================================================
+
+DspTracer::_State& DspTracer::_GetState()
+{
+    // never deleted: threads (and their rings) may outlive Finalize()
+    static _State* state = new _State();
+    return *state;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+unsigned long long DspTracer::_GetTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTracer::_RecordComponent(_EventType type, DspComponent* component, unsigned long long start, unsigned long long end)
+{
+    int id = 0;
+
+    if (component != NULL)
+    {
+        id = component->_traceId.load(std::memory_order_relaxed);
+        if (id == 0)
+        {
+            id = _AddName(component);
+        }
+    }
+
+    _Record(type, id, start, end);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTracer::_RecordThread(_EventType type, int threadNo, unsigned long long start, unsigned long long end)
+{
+    _Record(type, threadNo, start, end);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTracer::_Record(_EventType type, int id, unsigned long long start, unsigned long long end)
+{
+    static thread_local _RingOwner owner;
+
+    if (owner.ring == NULL)
+    {
+        owner.ring = _AddRing();
+    }
+
+    _Ring* ring = owner.ring;
+    unsigned long long eventNo = ring->eventCount.load(std::memory_order_relaxed);
+    _Event& event = ring->events[eventNo % _ringSize];
+
+    // the slot may be copied whilst overwritten: a copy that reads any part of this event must
+    // then read a count of at least eventNo, marking the slot's previous event as overwritten
+    // (see WriteChromeTrace())
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    event.info.store(((unsigned int)type << 24) | (id & 0xFFFFFF), std::memory_order_relaxed);
+
+    ring->eventCount.store(eventNo + 1, std::memory_order_release);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+DspTracer::_Ring* DspTracer::_AddRing()
+{
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    _Ring* ring;
+
+    if (!state.freeRings.empty())
+    {
+        ring = state.freeRings.back();
+        state.freeRings.pop_back();
+    }
+    else
+    {
+        ring = new _Ring(state.rings.size() + 1);
+        state.rings.push_back(ring);
+    }
+
+    state.mutex.Unlock();
+
+    return ring;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTracer::_RetireRing(_Ring* ring)
+{
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    state.retiredRings.push_back(ring);
+
+    state.mutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int DspTracer::_AddName(DspComponent* component)
+{
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    int id = component->_traceId.load(std::memory_order_relaxed);
+
+    // ids are 24 bits wide, components beyond are traced unnamed
+    if (id == 0 && state.names.size() < 0xFFFFFF)
+    {
+        id = state.names.size();
+        state.names.push_back("");
+        component->_traceId.store(id, std::memory_order_relaxed);
+    }
+
+    state.mutex.Unlock();
+
+    _Rename(component);
+
+    return id;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTracer::_Rename(DspComponent* component)
+{
+    _State& state = _GetState();
+
+    state.mutex.Lock();
+
+    int id = component->_traceId.load(std::memory_order_relaxed);
+
+    if (id != 0)
+    {
+        std::string name = component->GetComponentName();
+        if (name.empty())
+        {
+            std::ostringstream unnamed;
+            unnamed << "Component " << id;
+            name = unnamed.str();
+        }
+
+        state.names[id] = name;
+    }
+
+    state.mutex.Unlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTracer::_WriteString(std::ostream& stream, std::string const& string)
+{
+    static char const* const hexDigits = "0123456789abcdef";
+
+    stream << '"';
+
+    for (size_t i = 0; i < string.size(); i++)
+    {
+        unsigned char c = string[i];
+
+        if (c == '"' || c == '\\')
+        {
+            stream << '\\' << c;
+        }
+        else if (c < 0x20)
+        {
+            stream << "\\u00" << hexDigits[c >> 4] << hexDigits[c & 0xF];
+        }
+        else
+        {
+            stream << c;
+        }
+    }
+
+    stream << '"';
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void DspTracer::_WriteTime(std::ostream& stream, unsigned long long time)
+{
+    // microseconds, to the nanosecond
+    unsigned long long fraction = time % 1000;
+
+    stream << time / 1000 << '.' << (char)('0' + fraction / 100) << (char)('0' + fraction / 10 % 10)
+           << (char)('0' + fraction % 10);
+}
+
+//=================================================================================================
@@ -0,0 +1,99 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+
+#include <DSPatch.h>
+
+#include <cstdio>
+#include <vector>
+
+//=================================================================================================
+// Checks that GetThreadAffinity() reads back the CPUs a circuit's threads were placed on: a
+// pinned placement confines each thread to its single CPU, while a circuit without placement
+// leaves its threads free to run on any CPU, even on workers an earlier circuit had pinned.
+
+static void PrintCpus(char const* label, std::vector<int> const& cpus)
+{
+    printf("  %s", label);
+    for (size_t i = 0; i < cpus.size(); i++)
+    {
+        printf(" %d", cpus[i]);
+    }
+    printf("\n");
+}
+
+//-------------------------------------------------------------------------------------------------
+
+static bool CheckAffinity(DspCircuit& circuit, std::vector<int> const& expected, char const* placement)
+{
+    bool passed = true;
+
+    for (int i = 0; i < circuit.GetThreadCount(); i++)
+    {
+        std::vector<int> cpus;
+        circuit.GetThreadAffinity(i, cpus);
+
+        if (cpus != expected)
+        {
+            printf("FAIL: %s placement, circuit thread %d\n", placement, i);
+            PrintCpus("expected:", expected);
+            PrintCpus("got:     ", cpus);
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+//=================================================================================================
+
+int main()
+{
+    // the CPUs any thread may run on, as an unplaced thread sees them
+    std::vector<int> anyCpus;
+    if (!DspThread::SetAffinity(anyCpus) || !DspThread::GetAffinity(anyCpus))
+    {
+        printf("SKIP: thread affinity is not supported on this platform\n");
+        return 0;
+    }
+
+    DspEngine engine(2);
+    DspCircuit circuit(0, &engine);
+
+    bool passed = true;
+
+    // pinned to CPU 0 (present on any machine)
+    DspThreadPlacement pinned(-1, true);
+    pinned.cpus.push_back(0);
+
+    circuit.SetThreadCount(2, pinned);
+    passed = CheckAffinity(circuit, pinned.cpus, "pinned") && passed;
+
+    // the same workers, now without placement
+    circuit.SetThreadCount(0);
+    circuit.SetThreadCount(2, DspThreadPlacement());
+    passed = CheckAffinity(circuit, anyCpus, "unpinned") && passed;
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/************************************************************************
+DSPatch - Cross-Platform, Object-Oriented, Flow-Based Programming Library
+Copyright (c) 2012-2015 Marcus Tomlinson
+
+This file is part of DSPatch.
+
+GNU Lesser General Public License Usage
+This file may be used under the terms of the GNU Lesser General Public
+License version 3.0 as published by the Free Software Foundation and
+appearing in the file LGPLv3.txt included in the packaging of this
+file. Please review the following information to ensure the GNU Lesser
+General Public License version 3.0 requirements will be met:
+http://www.gnu.org/copyleft/lgpl.html.
+
+Other Usage
+Alternatively, this file may be used in accordance with the terms and
+conditions contained in a signed written agreement between you and
+Marcus Tomlinson.
+
+DSPatch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+************************************************************************/
+
+#include <DSPatch.h>
+
+#include <cstdio>
+#include <vector>
+
+//=================================================================================================
+// Checks that Stream() picks up and hands back the state of feedback loops where Render() left it
+// and is to resume it: a run of Render(), Stream() and Render() must produce what a model of the
+// circuit produces for the same ticks. In the loop below, each tick outputs the value output a
+// number of ticks before, plus one: one tick before when streamed or without circuit threads, and
+// the thread count before when ticked by circuit threads (each thread's feedback wires read that
+// thread's own last outputs).
+
+class Counter : public DspComponent
+{
+public:
+    Counter()
+    {
+        AddInput_();
+        AddOutput_();
+    }
+
+protected:
+    virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs)
+    {
+        int count = 0;
+        inputs.GetValue(0, count);
+        outputs.SetValue(0, count + 1);
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+
+class Passer : public DspComponent
+{
+public:
+    Passer()
+    {
+        AddInput_();
+        AddOutput_();
+    }
+
+protected:
+    virtual void Process_(DspSignalBus& inputs, DspSignalBus& outputs)
+    {
+        int count = 0;
+        inputs.GetValue(0, count);
+        outputs.SetValue(0, count);
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+
+class Recorder : public DspRenderSink
+{
+public:
+    virtual bool Consume(unsigned long, DspSignalBus const& outputs)
+    {
+        int count = -1;
+        outputs.GetValue(0, count);
+        counts.push_back(count);
+        return true;
+    }
+
+    std::vector<int> counts;
+};
+
+//=================================================================================================
+
+static const unsigned long renderTicks = 10;
+static const unsigned long streamTicks = 30;
+
+static bool TestStream(int threadCount)
+{
+    DspEngine engine(4);
+    DspCircuit circuit(threadCount, &engine);
+
+    Counter counter;
+    Passer passer;
+    circuit.AddComponent(counter);
+    circuit.AddComponent(passer);
+
+    circuit.AddOutput();
+    circuit.ConnectOutToIn(counter, 0, passer, 0);
+    circuit.ConnectOutToIn(passer, 0, counter, 0);
+    circuit.ConnectOutToOut(passer, 0, 0);
+
+    Recorder recorder;
+    circuit.Render(renderTicks, recorder);
+    circuit.Stream(streamTicks, recorder);
+    circuit.Render(renderTicks, recorder);
+
+    // the first ticks round the loop have no earlier output to read, hence output 0
+    std::vector<int> expected;
+    for (unsigned long i = 0; i < 2 * renderTicks + streamTicks; i++)
+    {
+        bool streamed = i >= renderTicks && i < renderTicks + streamTicks;
+        unsigned long ticksBack = streamed || threadCount == 0 ? 1 : threadCount;
+
+        expected.push_back(i < ticksBack ? 0 : expected[i - ticksBack] + 1);
+    }
+
+    if (recorder.counts == expected)
+    {
+        return true;
+    }
+
+    printf("FAIL: %d circuit thread(s)\n  expected:", threadCount);
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        printf(" %d", expected[i]);
+    }
+    printf("\n  got:     ");
+    for (size_t i = 0; i < recorder.counts.size(); i++)
+    {
+        printf(" %d", recorder.counts[i]);
+    }
+    printf("\n");
+
+    return false;
+}
+
+//=================================================================================================
+
+int main()
+{
+    int threadCounts[] = {0, 1, 2, 4};
+
+    bool passed = true;
+    for (size_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); i++)
+    {
+        passed = TestStream(threadCounts[i]) && passed;
+    }
+
+    return passed ? 0 : 1;
+}